@@ -0,0 +1,348 @@
+/*
+ * On-disk texture cache for hyprlax
+ * Stores decoded layer images with their full mip chain under
+ * $XDG_CACHE_HOME/hyprlax/ so they can be memory-mapped straight into GL
+ */
+
+#include "cache.h"
+#include "texcomp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FNV_PRIME 0x100000001b3ULL
+
+uint64_t cache_hash(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+int cache_make_key(const char* source_path, int target_width, int target_height,
+                   char* key, size_t key_size) {
+    if (!source_path || !key || key_size < CACHE_KEY_SIZE) return -1;
+
+    struct stat st;
+    if (stat(source_path, &st) != 0) return -1;
+
+    char resolved[PATH_MAX];
+    const char* path = realpath(source_path, resolved) ? resolved : source_path;
+
+    // Hash each field separately so the key doesn't depend on struct padding
+    int64_t mtime_sec = st.st_mtim.tv_sec;
+    int64_t mtime_nsec = st.st_mtim.tv_nsec;
+    int64_t file_size = st.st_size;
+    int32_t dims[2] = { target_width, target_height };
+    uint32_t version = CACHE_VERSION;
+
+    uint64_t hash = CACHE_HASH_SEED;
+    hash = cache_hash(hash, path, strlen(path));
+    hash = cache_hash(hash, &mtime_sec, sizeof(mtime_sec));
+    hash = cache_hash(hash, &mtime_nsec, sizeof(mtime_nsec));
+    hash = cache_hash(hash, &file_size, sizeof(file_size));
+    hash = cache_hash(hash, dims, sizeof(dims));
+    hash = cache_hash(hash, &version, sizeof(version));
+
+    snprintf(key, key_size, "%016llx", (unsigned long long)hash);
+    return 0;
+}
+
+int cache_snapshot_key(const char* output_name, int workspace, char* key, size_t key_size) {
+    if (!output_name || !key || key_size < CACHE_KEY_SIZE) return -1;
+
+    // The prefix keeps snapshot keys apart from those of source images
+    int32_t number = workspace;
+    uint32_t version = CACHE_VERSION;
+    uint64_t hash = CACHE_HASH_SEED;
+    hash = cache_hash(hash, "snapshot", 8);
+    hash = cache_hash(hash, output_name, strlen(output_name) + 1);
+    hash = cache_hash(hash, &number, sizeof(number));
+    hash = cache_hash(hash, &version, sizeof(version));
+
+    snprintf(key, key_size, "%016llx", (unsigned long long)hash);
+    return 0;
+}
+
+static int cache_dir(char* buffer, size_t size) {
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    int written;
+    if (xdg && xdg[0] == '/') {
+        written = snprintf(buffer, size, "%s/hyprlax", xdg);
+    } else {
+        const char* home = getenv("HOME");
+        if (!home || !home[0]) return -1;
+        written = snprintf(buffer, size, "%s/.cache/hyprlax", home);
+    }
+    return (written < 0 || (size_t)written >= size) ? -1 : 0;
+}
+
+int cache_entry_path(const char* key, char* buffer, size_t size) {
+    if (!key || !buffer) return -1;
+
+    char dir[CACHE_PATH_MAX];
+    if (cache_dir(dir, sizeof(dir)) < 0) return -1;
+
+    int written = snprintf(buffer, size, "%s/%s.hlxt", dir, key);
+    return (written < 0 || (size_t)written >= size) ? -1 : 0;
+}
+
+// Create each missing component of dir (like mkdir -p)
+static int make_dirs(const char* dir) {
+    char path[CACHE_PATH_MAX];
+    snprintf(path, sizeof(path), "%s", dir);
+
+    for (char* p = path + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(path, 0700) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    if (mkdir(path, 0700) != 0 && errno != EEXIST) return -1;
+    return 0;
+}
+
+int cache_load(const char* key, cache_entry_t* entry) {
+    if (!key || !entry) return -1;
+    memset(entry, 0, sizeof(*entry));
+
+    char path[CACHE_PATH_MAX];
+    if (cache_entry_path(key, path, sizeof(path)) < 0) return -1;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(cache_header_t)) {
+        close(fd);
+        return -1;
+    }
+
+    // Mark the entry used so cache_prune keeps it over ones that aren't
+    if (st.st_mtime + CACHE_TOUCH_INTERVAL < time(NULL)) {
+        futimens(fd, NULL);
+    }
+
+    // Populate now: the caller maps on a worker thread and uploads on the GL thread
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const cache_header_t* header = map;
+    size_t map_size = st.st_size;
+    int valid = memcmp(header->magic, CACHE_MAGIC, 4) == 0 &&
+                header->version == CACHE_VERSION &&
+                cache_level_size(header->format, 1, 1) > 0 &&
+                header->level_count >= 1 && header->level_count <= CACHE_MAX_LEVELS;
+
+    for (uint32_t i = 0; valid && i < header->level_count; i++) {
+        uint64_t width = header->levels[i].width;
+        uint64_t height = header->levels[i].height;
+        uint64_t offset = header->levels[i].offset;
+        uint64_t bytes = header->levels[i].size;
+        valid = width > 0 && height > 0 &&
+                width <= INT_MAX && height <= INT_MAX &&
+                bytes == cache_level_size(header->format, (int)width, (int)height) &&
+                offset >= sizeof(cache_header_t) &&
+                offset <= map_size && bytes <= map_size - offset;
+        if (valid) {
+            entry->levels[i].pixels = (unsigned char*)map + offset;
+            entry->levels[i].width = (int)width;
+            entry->levels[i].height = (int)height;
+        }
+    }
+
+    if (!valid) {
+        munmap(map, map_size);
+        memset(entry, 0, sizeof(*entry));
+        return -1;
+    }
+
+    entry->map = map;
+    entry->map_size = map_size;
+    entry->format = header->format;
+    entry->meta = header->meta;
+    entry->level_count = header->level_count;
+    return 0;
+}
+
+void cache_release(cache_entry_t* entry) {
+    if (!entry) return;
+
+    if (entry->map) {
+        munmap(entry->map, entry->map_size);
+    }
+    memset(entry, 0, sizeof(*entry));
+}
+
+static int write_all(int fd, const void* data, size_t size) {
+    const unsigned char* bytes = data;
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        bytes += written;
+        size -= written;
+    }
+    return 0;
+}
+
+size_t cache_level_size(cache_format_t format, int width, int height) {
+    switch (format) {
+        case CACHE_FORMAT_RGBA8: return (size_t)width * height * 4;
+        case CACHE_FORMAT_BC1: return texcomp_bc1_size(width, height);
+        case CACHE_FORMAT_BC3: return texcomp_bc3_size(width, height);
+    }
+    return 0;
+}
+
+int cache_store(const char* key, cache_format_t format, const image_t* levels,
+                int level_count, const cache_meta_t* meta) {
+    if (!key || !levels || level_count < 1 || level_count > CACHE_MAX_LEVELS) return -1;
+    if (cache_level_size(format, 1, 1) == 0) return -1;
+
+    char dir[CACHE_PATH_MAX];
+    char path[CACHE_PATH_MAX];
+    char temp[CACHE_PATH_MAX + 64];
+    if (cache_dir(dir, sizeof(dir)) < 0 || make_dirs(dir) < 0) return -1;
+    if (cache_entry_path(key, path, sizeof(path)) < 0) return -1;
+
+    cache_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, 4);
+    header.version = CACHE_VERSION;
+    header.format = format;
+    header.level_count = level_count;
+    if (meta) header.meta = *meta;
+
+    uint64_t offset = sizeof(header);
+    for (int i = 0; i < level_count; i++) {
+        header.levels[i].width = levels[i].width;
+        header.levels[i].height = levels[i].height;
+        header.levels[i].offset = offset;
+        header.levels[i].size = cache_level_size(format, levels[i].width, levels[i].height);
+        offset += header.levels[i].size;
+    }
+
+    // Unique temp name so concurrent writers (other instances, worker threads) never collide
+    snprintf(temp, sizeof(temp), "%s.%d.%lu.tmp", path, (int)getpid(),
+             (unsigned long)pthread_self());
+    int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return -1;
+
+    int result = write_all(fd, &header, sizeof(header));
+    for (int i = 0; result == 0 && i < level_count; i++) {
+        result = write_all(fd, levels[i].pixels, header.levels[i].size);
+    }
+    if (close(fd) != 0) result = -1;
+
+    if (result == 0 && rename(temp, path) != 0) result = -1;
+    if (result < 0) {
+        unlink(temp);
+        return result;
+    }
+
+    // Edited images leave their old entries behind; clear them out now and then
+    static pthread_mutex_t prune_lock = PTHREAD_MUTEX_INITIALIZER;
+    static time_t last_prune = 0;
+    time_t now = time(NULL);
+    int prune = 0;
+    pthread_mutex_lock(&prune_lock);
+    if (now - last_prune >= CACHE_PRUNE_INTERVAL) {
+        last_prune = now;
+        prune = 1;
+    }
+    pthread_mutex_unlock(&prune_lock);
+    if (prune) cache_prune(CACHE_MAX_BYTES, CACHE_MAX_AGE);
+    return 0;
+}
+
+typedef struct {
+    char name[256];
+    time_t mtime;
+    uint64_t size;
+} prune_file_t;
+
+static int compare_mtime(const void* a, const void* b) {
+    const prune_file_t* file_a = a;
+    const prune_file_t* file_b = b;
+    return (file_a->mtime > file_b->mtime) - (file_a->mtime < file_b->mtime);
+}
+
+static int has_suffix(const char* name, const char* suffix) {
+    size_t length = strlen(name);
+    size_t suffix_length = strlen(suffix);
+    return length > suffix_length && strcmp(name + length - suffix_length, suffix) == 0;
+}
+
+int cache_prune(uint64_t max_bytes, long max_age) {
+    char dir[CACHE_PATH_MAX];
+    if (cache_dir(dir, sizeof(dir)) < 0) return -1;
+    DIR* handle = opendir(dir);
+    if (!handle) return -1;
+
+    time_t now = time(NULL);
+    prune_file_t* files = NULL;
+    int count = 0, capacity = 0;
+    uint64_t total = 0;
+    int removed = 0;
+    char path[CACHE_PATH_MAX + 256];
+
+    struct dirent* dirent;
+    while ((dirent = readdir(handle))) {
+        int temp = has_suffix(dirent->d_name, ".tmp");
+        if (!temp && !has_suffix(dirent->d_name, ".hlxt")) continue;
+        if (strlen(dirent->d_name) >= sizeof(files[0].name)) continue;
+
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", dir, dirent->d_name);
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+
+        // A write takes seconds; a temp file this old belongs to a writer that died
+        long age = (long)(now - st.st_mtime);
+        if ((temp && age > CACHE_TOUCH_INTERVAL) || (!temp && age > max_age)) {
+            if (unlink(path) == 0) removed++;
+            continue;
+        }
+        if (temp) continue;
+
+        if (count == capacity) {
+            int grown = capacity ? capacity * 2 : 64;
+            prune_file_t* resized = realloc(files, sizeof(prune_file_t) * grown);
+            if (!resized) break;
+            files = resized;
+            capacity = grown;
+        }
+        snprintf(files[count].name, sizeof(files[count].name), "%s", dirent->d_name);
+        files[count].mtime = st.st_mtime;
+        files[count].size = (uint64_t)st.st_size;
+        total += files[count].size;
+        count++;
+    }
+    closedir(handle);
+
+    // Oldest use first
+    if (count > 1) qsort(files, count, sizeof(prune_file_t), compare_mtime);
+    for (int i = 0; i < count && total > max_bytes; i++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, files[i].name);
+        if (unlink(path) == 0) {
+            total -= files[i].size;
+            removed++;
+        }
+    }
+    free(files);
+    return removed;
+}
@@ -0,0 +1,97 @@
+/*
+ * On-disk texture cache for hyprlax
+ * Stores decoded layer images with their full mip chain under
+ * $XDG_CACHE_HOME/hyprlax/ so they can be memory-mapped straight into GL
+ */
+
+#ifndef HYPRLAX_CACHE_H
+#define HYPRLAX_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "image.h"
+
+#define CACHE_MAGIC "HLXT"
+#define CACHE_VERSION 2
+#define CACHE_MAX_LEVELS 16       // Enough for a 32768px mip chain
+#define CACHE_KEY_SIZE 17         // 16 hex digits + NUL
+#define CACHE_PATH_MAX 4096
+#define CACHE_MAX_BYTES (512ULL << 20)       // Least recently used entries past this are deleted
+#define CACHE_MAX_AGE (30L * 24 * 60 * 60)   // Seconds an entry may go unused
+#define CACHE_PRUNE_INTERVAL 60              // Seconds between the prunes cache_store runs
+#define CACHE_TOUCH_INTERVAL (60 * 60)       // A hit refreshes the entry's mtime at most this often
+
+typedef enum {
+    CACHE_FORMAT_RGBA8 = 0,
+    CACHE_FORMAT_BC1 = 1,     // S3TC DXT1, opaque layers
+    CACHE_FORMAT_BC3 = 2,     // S3TC DXT5, layers with alpha
+} cache_format_t;
+
+// Facts about the RGBA level 0, kept so a hit never has to rescan (or decompress) pixels
+typedef struct {
+    image_coverage_t coverage;
+    uint64_t content_hash;
+} cache_meta_t;
+
+// File header, followed by the level payloads at the recorded offsets
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t level_count;
+    cache_meta_t meta;
+    struct {
+        uint32_t width;
+        uint32_t height;
+        uint64_t offset;
+        uint64_t size;
+    } levels[CACHE_MAX_LEVELS];
+} cache_header_t;
+
+// A mapped cache file; level pixels point into the mapping (block data for
+// compressed formats, where width and height stay in texels)
+typedef struct {
+    void* map;
+    size_t map_size;
+    cache_format_t format;
+    cache_meta_t meta;
+    int level_count;
+    image_t levels[CACHE_MAX_LEVELS];
+} cache_entry_t;
+
+// FNV-1a over size bytes, continuing from hash (start a new hash from CACHE_HASH_SEED)
+#define CACHE_HASH_SEED 0xcbf29ce484222325ULL
+uint64_t cache_hash(uint64_t hash, const void* data, size_t size);
+
+// Key from the source file identity (resolved path, mtime, size) and the stored
+// level-0 size; returns -1 if the source can't be stat'ed
+int cache_make_key(const char* source_path, int target_width, int target_height,
+                   char* key, size_t key_size);
+
+// Key of the composited-frame snapshot of one output (by connector name) on one
+// workspace; stored as a single RGBA8 level whose meta.content_hash identifies the scene
+int cache_snapshot_key(const char* output_name, int workspace, char* key, size_t key_size);
+
+// $XDG_CACHE_HOME/hyprlax/<key>.hlxt (falls back to ~/.cache)
+int cache_entry_path(const char* key, char* buffer, size_t size);
+
+// Map an entry; returns -1 on a miss or an invalid file
+int cache_load(const char* key, cache_entry_t* entry);
+void cache_release(cache_entry_t* entry);
+
+// Payload bytes of one width x height level; 0 for an unknown format
+size_t cache_level_size(cache_format_t format, int width, int height);
+
+// Write levels atomically (temp file + rename); creates the cache directory and prunes
+// it with the default limits (at most once per CACHE_PRUNE_INTERVAL)
+int cache_store(const char* key, cache_format_t format, const image_t* levels,
+                int level_count, const cache_meta_t* meta);
+
+// Delete entries unused for more than max_age seconds, then the least recently used until
+// the rest fit in max_bytes, along with temp files left by interrupted writes. An entry's
+// mtime is its last use: cache_load refreshes it on a hit. Returns the number of files
+// removed, or -1 if the cache directory can't be read.
+int cache_prune(uint64_t max_bytes, long max_age);
+
+#endif // HYPRLAX_CACHE_H
@@ -0,0 +1,374 @@
+/*
+ * Configuration for hyprlax
+ * Global settings with their defaults, and the parallax.conf parser
+ */
+
+#define _GNU_SOURCE
+#include "config.h"
+#include "resscale.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libgen.h>
+
+struct config config = {
+    .shift_per_workspace = 200.0f,  // More dramatic shift between workspaces
+    .animation_duration = 1.0f,  // Longer duration - user can "feel" it settling
+    .animation_delay = 0.0f,
+    .scale_factor = 1.5f,  // Increased scale to accommodate larger shifts
+    .easing = EASE_EXPO_OUT,  // Exponential ease out - fast then very gentle settling
+    .target_fps = 144,
+    .vsync = 1,
+    .debug = 0,
+    .multi_layer_mode = 0,
+    .max_workspaces = 10,  // Default to 10, will be detected from Hyprland
+    .config_file_path = NULL,
+    .bench = 0,
+    .bench_width = 1920,
+    .bench_height = 1080,
+    .bench_script = BENCH_DEFAULT_SCRIPT,
+    .bench_blur = -1.0f,
+    .blur_downscale = BLUR_DEFAULT_DOWNSCALE,
+    .texture_cache = 1,
+    .compress_textures = 0,
+    .dmabuf_upload = 0,
+    .gpu_animation = 0,
+    .watch_config = 0,
+    .texture_budget_mb = 0,
+    .dynamic_resolution = 0,
+    .render_scale_min = RESSCALE_MIN_DEFAULT,
+    .deferred_mips = 0,
+    .power_policy = 0
+};
+
+void config_copy_settings(struct config *to, const struct config *from, unsigned mask) {
+    if (mask & CONFIG_SET_SHIFT) to->shift_per_workspace = from->shift_per_workspace;
+    if (mask & CONFIG_SET_DURATION) to->animation_duration = from->animation_duration;
+    if (mask & CONFIG_SET_EASING) to->easing = from->easing;
+    if (mask & CONFIG_SET_BLUR_DOWNSCALE) to->blur_downscale = from->blur_downscale;
+    if (mask & CONFIG_SET_COMPRESS_TEXTURES) to->compress_textures = from->compress_textures;
+    if (mask & CONFIG_SET_DMABUF_UPLOAD) to->dmabuf_upload = from->dmabuf_upload;
+    if (mask & CONFIG_SET_GPU_ANIMATION) to->gpu_animation = from->gpu_animation;
+    if (mask & CONFIG_SET_TEXTURE_BUDGET) to->texture_budget_mb = from->texture_budget_mb;
+    if (mask & CONFIG_SET_DYNAMIC_RESOLUTION) to->dynamic_resolution = from->dynamic_resolution;
+    if (mask & CONFIG_SET_RENDER_SCALE_MIN) to->render_scale_min = from->render_scale_min;
+    if (mask & CONFIG_SET_DEFERRED_MIPS) to->deferred_mips = from->deferred_mips;
+    if (mask & CONFIG_SET_POWER_POLICY) to->power_policy = from->power_policy;
+    if (mask & CONFIG_SET_POWER_PROFILES) {
+        memcpy(to->power_profiles, from->power_profiles, sizeof(to->power_profiles));
+    }
+}
+
+// Helper: Check if path is in a sensitive directory
+static int is_sensitive_path(const char *resolved_path) {
+    const char *sensitive_dirs[] = {
+        "/etc", "/sys", "/proc", "/dev",
+        "/boot", "/root", NULL
+    };
+
+    for (int i = 0; sensitive_dirs[i]; i++) {
+        size_t dir_len = strlen(sensitive_dirs[i]);
+        if (strncmp(resolved_path, sensitive_dirs[i], dir_len) == 0 &&
+            (resolved_path[dir_len] == '/' || resolved_path[dir_len] == '\0')) {
+            fprintf(stderr, "Error: Path validation failed - access to sensitive directory '%s' denied\n",
+                    sensitive_dirs[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Helper: Resolve path for non-existent files
+static char *resolve_nonexistent_path(const char *path) {
+    char *path_copy = strdup(path);
+    if (!path_copy) {
+        fprintf(stderr, "Error: Path validation failed - memory allocation error\n");
+        return NULL;
+    }
+
+    char *dir = dirname(path_copy);
+    char *resolved_dir = realpath(dir, NULL);
+
+    if (!resolved_dir) {
+        fprintf(stderr, "Error: Path validation failed - parent directory '%s' does not exist\n", dir);
+        free(path_copy);
+        return NULL;
+    }
+
+    // Construct the resolved path
+    char *base = basename((char *)path);
+    size_t path_len = strlen(resolved_dir) + strlen(base) + 2;
+    char *resolved_path = malloc(path_len);
+    if (!resolved_path) {
+        fprintf(stderr, "Error: Path validation failed - memory allocation error\n");
+        free(resolved_dir);
+        free(path_copy);
+        return NULL;
+    }
+
+    snprintf(resolved_path, path_len, "%s/%s", resolved_dir, base);
+    free(resolved_dir);
+    free(path_copy);
+
+    return resolved_path;
+}
+
+int validate_path(const char *path) {
+    if (!path) {
+        fprintf(stderr, "Error: Path validation failed - NULL path provided\n");
+        return 0;
+    }
+
+    // Try to resolve the path directly
+    char *resolved_path = realpath(path, NULL);
+
+    // If file doesn't exist, resolve parent directory
+    if (!resolved_path) {
+        resolved_path = resolve_nonexistent_path(path);
+        if (!resolved_path) {
+            return 0;
+        }
+    }
+
+    // Check for sensitive directories
+    int is_valid = !is_sensitive_path(resolved_path);
+
+    free(resolved_path);
+    return is_valid;
+}
+
+char *resolve_config_relative_path(const char *path) {
+    if (!path) return NULL;
+
+    // If path is already absolute, return a copy
+    if (path[0] == '/') {
+        return strdup(path);
+    }
+
+    // If no config file path stored, treat as relative to current directory
+    if (!config.config_file_path) {
+        return strdup(path);
+    }
+
+    // Get directory of config file
+    char *config_dir = strdup(config.config_file_path);
+    if (!config_dir) return NULL;
+
+    char *last_slash = strrchr(config_dir, '/');
+    if (last_slash) {
+        *last_slash = '\0';  // Terminate at last slash to get directory
+    } else {
+        // Config file is in current directory
+        free(config_dir);
+        return strdup(path);
+    }
+
+    // Build full path
+    size_t dir_len = strlen(config_dir);
+    size_t path_len = strlen(path);
+    char *full_path = malloc(dir_len + path_len + 2);
+    if (!full_path) {
+        free(config_dir);
+        return NULL;
+    }
+
+    snprintf(full_path, dir_len + path_len + 2, "%s/%s", config_dir, path);
+    free(config_dir);
+
+    return full_path;
+}
+
+// Keep cached blur resolution within a sane range of the output size
+float clamp_blur_downscale(float value) {
+    if (value < 0.1f) return 0.1f;
+    if (value > 1.0f) return 1.0f;
+    return value;
+}
+
+// Dynamic resolution never drops below a tenth of the output size
+float clamp_render_scale_min(float value) {
+    if (value < 0.1f) return 0.1f;
+    if (value > 1.0f) return 1.0f;
+    return value;
+}
+
+int config_parse_file(const char *filename, config_layer_fn add_layer, void *data) {
+    // Validate the config file path
+    if (!validate_path(filename)) {
+        fprintf(stderr, "Error: Invalid config file path: %s\n", filename);
+        return -1;
+    }
+
+    // Store the config file path (resolve to absolute path)
+    char *resolved_config_path = realpath(filename, NULL);
+    if (resolved_config_path) {
+        if (config.config_file_path) {
+            free(config.config_file_path);
+        }
+        config.config_file_path = resolved_config_path;
+    } else {
+        // If realpath fails, store the original path
+        if (config.config_file_path) {
+            free(config.config_file_path);
+        }
+        config.config_file_path = strdup(filename);
+    }
+
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot open config file: %s\n", filename);
+        return -1;
+    }
+
+    char line[MAX_CONFIG_LINE_SIZE];
+    int line_num = 0;
+
+    while (fgets(line, MAX_CONFIG_LINE_SIZE, file)) {
+        line_num++;
+
+        // Check if line was truncated (no newline found)
+        if (!strchr(line, '\n')) {
+            // Only report error if not at EOF (EOF without newline is acceptable)
+            if (!feof(file)) {
+                fprintf(stderr, "Error: Line %d exceeds buffer size of %d characters\n",
+                        line_num, MAX_CONFIG_LINE_SIZE - 1);
+                // Skip rest of the line safely
+                int c;
+                while ((c = fgetc(file)) != EOF) {
+                    if (c == '\n') break;
+                }
+                continue;
+            }
+        }
+
+        // Skip comments and empty lines
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+
+        // Remove newline
+        char *newline = strchr(line, '\n');
+        if (newline) *newline = '\0';
+
+        // Parse tokens
+        char *cmd = strtok(line, " \t");
+        if (!cmd) continue;
+
+        if (strcmp(cmd, "layer") == 0) {
+            char *image = strtok(NULL, " \t");
+            char *shift_str = strtok(NULL, " \t");
+            char *opacity_str = strtok(NULL, " \t");
+            char *blur_str = strtok(NULL, " \t");
+
+            if (!image) {
+                fprintf(stderr, "Config line %d: layer requires image path\n", line_num);
+                continue;
+            }
+
+            // Resolve path relative to config file if needed
+            char *resolved_image_path = resolve_config_relative_path(image);
+            if (!resolved_image_path) {
+                fprintf(stderr, "Error: Failed to resolve image path at line %d: %s\n", line_num, image);
+                fclose(file);
+                return -1;
+            }
+
+            // Validate resolved image path
+            if (!validate_path(resolved_image_path)) {
+                fprintf(stderr, "Error: Invalid image path at line %d: %s\n", line_num, resolved_image_path);
+                free(resolved_image_path);
+                fclose(file);
+                return -1;
+            }
+
+            float shift = shift_str ? atof(shift_str) : 1.0f;
+            float opacity = opacity_str ? atof(opacity_str) : 1.0f;
+            float blur = blur_str ? atof(blur_str) : 0.0f;
+            
+            if (config.debug) {
+                fprintf(stderr, "Config parse layer: image=%s, shift=%.2f, opacity=%.2f, blur=%.2f\n",
+                        image, shift, opacity, blur);
+            }
+
+            config_layer_t layer = {
+                .image_path = resolved_image_path,  // Now owned by the receiver
+                .shift_multiplier = shift,
+                .opacity = opacity,
+                .blur_amount = blur,
+                .easing = config.easing,
+                .animation_duration = config.animation_duration,
+            };
+            if (add_layer(&layer, data) < 0) {
+                fprintf(stderr, "Error: Failed to add layer at line %d\n", line_num);
+                fclose(file);
+                return -1;
+            }
+        } else if (strcmp(cmd, "duration") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) config.animation_duration = atof(val);
+        } else if (strcmp(cmd, "shift") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) config.shift_per_workspace = atof(val);
+        } else if (strcmp(cmd, "easing") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) {
+                if (strcmp(val, "linear") == 0) config.easing = EASE_LINEAR;
+                else if (strcmp(val, "quad") == 0) config.easing = EASE_QUAD_OUT;
+                else if (strcmp(val, "cubic") == 0) config.easing = EASE_CUBIC_OUT;
+                else if (strcmp(val, "quart") == 0) config.easing = EASE_QUART_OUT;
+                else if (strcmp(val, "quint") == 0) config.easing = EASE_QUINT_OUT;
+                else if (strcmp(val, "sine") == 0) config.easing = EASE_SINE_OUT;
+                else if (strcmp(val, "expo") == 0) config.easing = EASE_EXPO_OUT;
+                else if (strcmp(val, "circ") == 0) config.easing = EASE_CIRC_OUT;
+                else if (strcmp(val, "back") == 0) config.easing = EASE_BACK_OUT;
+                else if (strcmp(val, "elastic") == 0) config.easing = EASE_ELASTIC_OUT;
+                else if (strcmp(val, "snap") == 0) config.easing = EASE_CUSTOM_SNAP;
+            }
+        } else if (strcmp(cmd, "blur_downscale") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) config.blur_downscale = clamp_blur_downscale(atof(val));
+        } else if (strcmp(cmd, "compress_textures") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) config.compress_textures = atoi(val) != 0;
+        } else if (strcmp(cmd, "dmabuf_upload") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) config.dmabuf_upload = atoi(val) != 0;
+        } else if (strcmp(cmd, "gpu_animation") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) config.gpu_animation = atoi(val) != 0;
+        } else if (strcmp(cmd, "texture_budget_mb") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) config.texture_budget_mb = atoi(val) > 0 ? atoi(val) : 0;
+        } else if (strcmp(cmd, "dynamic_resolution") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) config.dynamic_resolution = atoi(val) != 0;
+        } else if (strcmp(cmd, "render_scale_min") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) config.render_scale_min = clamp_render_scale_min(atof(val));
+        } else if (strcmp(cmd, "deferred_mips") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) config.deferred_mips = atoi(val) != 0;
+        } else if (strcmp(cmd, "power_policy") == 0) {
+            char *val = strtok(NULL, " \t");
+            if (val) config.power_policy = atoi(val) != 0;
+        } else if (strcmp(cmd, "profile") == 0) {
+            // profile <ac|battery|fullscreen> <setting> <value> [<setting> <value> ...]
+            char *name = strtok(NULL, " \t");
+            int id = power_profile_from_name(name);
+            if (id < 0) {
+                fprintf(stderr, "Warning: Unknown power profile '%s' on line %d\n",
+                        name ? name : "", line_num);
+                continue;
+            }
+            char *setting;
+            while ((setting = strtok(NULL, " \t"))) {
+                char *val = strtok(NULL, " \t");
+                if (power_profile_set(&config.power_profiles[id], setting, val) < 0) {
+                    fprintf(stderr, "Warning: Invalid profile setting '%s %s' on line %d\n",
+                            setting, val ? val : "", line_num);
+                }
+            }
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
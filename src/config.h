@@ -0,0 +1,101 @@
+/*
+ * Configuration for hyprlax
+ * Global settings with their defaults, and the parallax.conf parser
+ */
+
+#ifndef HYPRLAX_CONFIG_H
+#define HYPRLAX_CONFIG_H
+
+#include "easing.h"
+#include "power.h"
+
+#define INITIAL_MAX_LAYERS 8
+#define MAX_CONFIG_LINE_SIZE 512  // Maximum line length in config files
+#define BLUR_DEFAULT_DOWNSCALE 0.5f // Resolution of cached blur textures relative to the output
+#define BENCH_DEFAULT_SCRIPT "2,3,4,5,1"  // Workspace switches replayed by --bench
+
+// Global settings, from the command line and parallax.conf
+struct config {
+    float shift_per_workspace;
+    float animation_duration;
+    float animation_delay;  // Delay before starting animation
+    float scale_factor;
+    easing_type_t easing;
+    int target_fps;
+    int vsync;
+    int debug;
+    int multi_layer_mode;  // Whether we're using multiple layers
+    int max_workspaces;    // Maximum number of workspaces (detected from Hyprland)
+    char *config_file_path;  // Path to the config file for resolving relative paths
+
+    // Headless benchmark mode (--bench)
+    int bench;
+    int bench_width, bench_height;
+    const char *bench_script;  // Comma-separated workspace switches
+    float bench_blur;          // Overrides every layer's blur when >= 0
+
+    float blur_downscale;      // Cached blur resolution relative to the output (0.1 - 1.0)
+    int texture_cache;         // Reuse decoded mip chains from $XDG_CACHE_HOME/hyprlax
+    int compress_textures;     // Store layers as S3TC blocks when the driver supports it
+    int dmabuf_upload;         // Hand layer pixels to the GPU as dma-bufs instead of copying
+    int gpu_animation;         // Ease layer offsets in the compositing shader from a clock uniform
+    int watch_config;          // Reload the config file whenever it is saved
+    int texture_budget_mb;     // Evict textures of layers not on screen past this (0 = no limit)
+    int dynamic_resolution;    // Composite animated frames at a lower resolution under GPU load
+    float render_scale_min;    // Lowest fraction of the output resolution it may drop to
+    int deferred_mips;         // Upload level 0 first and the mip chain once animations are idle
+    int power_policy;          // Switch render profiles with the battery and fullscreen state
+    power_profile_t power_profiles[POWER_PROFILE_COUNT];  // Set from power_profiles_default()
+};
+
+extern struct config config;
+
+// Settings a config file can set, as bits for config_copy_settings()
+enum {
+    CONFIG_SET_SHIFT = 1 << 0,
+    CONFIG_SET_DURATION = 1 << 1,
+    CONFIG_SET_EASING = 1 << 2,
+    CONFIG_SET_BLUR_DOWNSCALE = 1 << 3,
+    CONFIG_SET_COMPRESS_TEXTURES = 1 << 4,
+    CONFIG_SET_DMABUF_UPLOAD = 1 << 5,
+    CONFIG_SET_GPU_ANIMATION = 1 << 6,
+    CONFIG_SET_TEXTURE_BUDGET = 1 << 7,
+    CONFIG_SET_DYNAMIC_RESOLUTION = 1 << 8,
+    CONFIG_SET_RENDER_SCALE_MIN = 1 << 9,
+    CONFIG_SET_DEFERRED_MIPS = 1 << 10,
+    CONFIG_SET_POWER_POLICY = 1 << 11,
+    CONFIG_SET_POWER_PROFILES = 1 << 12,
+    CONFIG_SET_FILE = (1 << 13) - 1  // Everything config_parse_file() writes besides layers
+};
+
+// Copy the settings selected by mask (CONFIG_SET_* bits) from one config to another
+void config_copy_settings(struct config *to, const struct config *from, unsigned mask);
+
+// A `layer` line, with the animation defaults in effect where it was read
+typedef struct {
+    char *image_path;  // Resolved against the config file's directory; owned by the receiver
+    float shift_multiplier;
+    float opacity;
+    float blur_amount;
+    easing_type_t easing;
+    float animation_duration;
+} config_layer_t;
+
+// Receives each layer of a config file in order; returns -1 to abort the parse
+typedef int (*config_layer_fn)(const config_layer_t *layer, void *data);
+
+// Validate path to prevent directory traversal; returns 0 for sensitive or unresolvable paths
+int validate_path(const char *path);
+
+// Resolve path relative to the directory of config.config_file_path (a new string)
+char *resolve_config_relative_path(const char *path);
+
+float clamp_blur_downscale(float value);
+float clamp_render_scale_min(float value);
+
+// Parse a config file, applying the global settings to `config` as they are read and
+// handing each layer to add_layer. Returns -1 if the file or a layer path can't be used,
+// or add_layer failed; layers handed over before that stay with the receiver.
+int config_parse_file(const char *filename, config_layer_fn add_layer, void *data);
+
+#endif // HYPRLAX_CONFIG_H
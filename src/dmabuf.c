@@ -0,0 +1,86 @@
+/*
+ * Shareable pixel buffers for hyprlax
+ * Wraps a sealed memfd in a dma-buf through /dev/udmabuf, so a worker can write a
+ * layer's pixels once and the GL thread can import them as an EGLImage without a copy
+ */
+
+#define _GNU_SOURCE
+#include "dmabuf.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/udmabuf.h>
+
+static pthread_once_t probe_once = PTHREAD_ONCE_INIT;
+static int device_available;
+
+static void probe_device(void) {
+    device_available = access(DMABUF_DEVICE, R_OK | W_OK) == 0;
+}
+
+int dmabuf_supported(void) {
+    pthread_once(&probe_once, probe_device);
+    return device_available;
+}
+
+int dmabuf_image_create(dmabuf_image_t* image, int width, int height) {
+    if (!image) return -1;
+    memset(image, 0, sizeof(*image));
+    image->memfd = image->fd = -1;
+    if (width <= 0 || height <= 0 || !dmabuf_supported()) return -1;
+
+    // udmabuf only takes whole pages from a memfd that can no longer shrink
+    long page = sysconf(_SC_PAGESIZE);
+    image->stride = width * 4;
+    image->size = ((size_t)image->stride * height + page - 1) / page * page;
+    image->width = width;
+    image->height = height;
+
+    image->memfd = memfd_create("hyprlax-layer", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (image->memfd < 0 || ftruncate(image->memfd, image->size) != 0 ||
+        fcntl(image->memfd, F_ADD_SEALS, F_SEAL_SHRINK) != 0) {
+        dmabuf_image_destroy(image);
+        return -1;
+    }
+
+    int device = open(DMABUF_DEVICE, O_RDWR | O_CLOEXEC);
+    if (device < 0) {
+        dmabuf_image_destroy(image);
+        return -1;
+    }
+    struct udmabuf_create create = {
+        .memfd = (unsigned int)image->memfd,
+        .flags = UDMABUF_FLAGS_CLOEXEC,
+        .offset = 0,
+        .size = image->size,
+    };
+    image->fd = ioctl(device, UDMABUF_CREATE, &create);
+    close(device);
+    if (image->fd < 0) {
+        dmabuf_image_destroy(image);
+        return -1;
+    }
+
+    void* map = mmap(NULL, image->size, PROT_READ | PROT_WRITE, MAP_SHARED, image->memfd, 0);
+    if (map == MAP_FAILED) {
+        dmabuf_image_destroy(image);
+        return -1;
+    }
+    image->pixels = map;
+    return 0;
+}
+
+void dmabuf_image_destroy(dmabuf_image_t* image) {
+    // A zeroed image was never created; its 0 descriptors aren't ours to close
+    if (!image || image->size == 0) return;
+
+    if (image->pixels) munmap(image->pixels, image->size);
+    if (image->fd >= 0) close(image->fd);
+    if (image->memfd >= 0) close(image->memfd);
+    memset(image, 0, sizeof(*image));
+    image->memfd = image->fd = -1;
+}
@@ -0,0 +1,33 @@
+/*
+ * Shareable pixel buffers for hyprlax
+ * Wraps a sealed memfd in a dma-buf through /dev/udmabuf, so a worker can write a
+ * layer's pixels once and the GL thread can import them as an EGLImage without a copy
+ */
+
+#ifndef HYPRLAX_DMABUF_H
+#define HYPRLAX_DMABUF_H
+
+#include <stddef.h>
+
+#define DMABUF_DEVICE "/dev/udmabuf"
+#define DMABUF_FOURCC_ABGR8888 0x34324241  // DRM_FORMAT_ABGR8888: R, G, B, A bytes in memory
+
+typedef struct {
+    int memfd;
+    int fd;                  // dma-buf, -1 when not created
+    unsigned char* pixels;   // Writable mapping of the buffer
+    size_t size;
+    int width, height;
+    int stride;              // Bytes per row
+} dmabuf_image_t;
+
+// Whether udmabuf can be used at all; probed once
+int dmabuf_supported(void);
+
+// Allocate a zeroed width x height RGBA8 buffer; returns -1 (and leaves fd at -1)
+// if udmabuf is unavailable or the allocation fails
+int dmabuf_image_create(dmabuf_image_t* image, int width, int height);
+// Safe on a zeroed (never created) image
+void dmabuf_image_destroy(dmabuf_image_t* image);
+
+#endif // HYPRLAX_DMABUF_H
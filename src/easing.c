@@ -0,0 +1,288 @@
+/*
+ * Easing and layer animation for hyprlax
+ * Easing curves, sampled into lookup tables, and a structure-of-arrays table of
+ * layer offsets that every animated frame advances in one pass
+ */
+
+#include "easing.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+float easing_apply(float t, easing_type_t type) {
+    switch (type) {
+        case EASE_LINEAR:
+            return t;
+
+        case EASE_QUAD_OUT:
+            return 1.0f - (1.0f - t) * (1.0f - t);
+
+        case EASE_CUBIC_OUT:
+            return 1.0f - powf(1.0f - t, 3.0f);
+
+        case EASE_QUART_OUT:
+            return 1.0f - powf(1.0f - t, 4.0f);
+
+        case EASE_QUINT_OUT:
+            return 1.0f - powf(1.0f - t, 5.0f);
+
+        case EASE_SINE_OUT:
+            return sinf((t * M_PI) / 2.0f);
+
+        case EASE_EXPO_OUT:
+            return t == 1.0f ? 1.0f : 1.0f - powf(2.0f, -10.0f * t);
+
+        case EASE_CIRC_OUT:
+            return sqrtf(1.0f - powf(t - 1.0f, 2.0f));
+
+        case EASE_BACK_OUT: {
+            float c1 = 1.70158f;
+            float c3 = c1 + 1.0f;
+            return 1.0f + c3 * powf(t - 1.0f, 3.0f) + c1 * powf(t - 1.0f, 2.0f);
+        }
+
+        case EASE_ELASTIC_OUT: {
+            float c4 = (2.0f * M_PI) / 3.0f;
+            return t == 0 ? 0 : t == 1 ? 1 : powf(2.0f, -10.0f * t) * sinf((t * 10.0f - 0.75f) * c4) + 1.0f;
+        }
+
+        case EASE_CUSTOM_SNAP: {
+            // Custom extra snappy easing - fast start, very quick deceleration at the end
+            if (t < 0.4f) {
+                // Accelerate quickly for first 40% of time
+                return 1.0f - powf(1.0f - (t * 2.5f), 6.0f);
+            } else {
+                // Then ease out more gently
+                return 1.0f - powf(1.0f - t, 8.0f);
+            }
+        }
+
+        default:
+            return t;
+    }
+}
+
+// One extra sample so index + 1 is always valid, even at t = 1
+static float lut[EASE_COUNT][EASING_LUT_SIZE + 1];
+static int lut_ready;
+
+static void build_tables(void) {
+    for (int type = 0; type < EASE_COUNT; type++) {
+        for (int i = 0; i <= EASING_LUT_SIZE; i++) {
+            lut[type][i] = easing_apply((float)i / EASING_LUT_SIZE, type);
+        }
+    }
+    lut_ready = 1;
+}
+
+float easing_lookup(float t, easing_type_t type) {
+    if ((unsigned)type >= EASE_COUNT) return t;
+    // Circ is vertical at t = 0, where no sample spacing keeps up, and sqrtf is cheap anyway
+    if (type == EASE_CIRC_OUT) return easing_apply(fminf(fmaxf(t, 0.0f), 1.0f), type);
+    if (!lut_ready) build_tables();
+
+    if (t <= 0.0f) return lut[type][0];
+    if (t >= 1.0f) return lut[type][EASING_LUT_SIZE];
+    float position = t * EASING_LUT_SIZE;
+    int index = (int)position;
+    float fraction = position - index;
+    const float* samples = lut[type];
+    return samples[index] + (samples[index + 1] - samples[index]) * fraction;
+}
+
+int easing_overshoots(easing_type_t type) {
+    return type == EASE_BACK_OUT || type == EASE_ELASTIC_OUT;
+}
+
+int anim_table_resize(anim_table_t* table, int count) {
+    if (!table || count < 0) return -1;
+
+    if (count > table->capacity) {
+        int capacity = table->capacity > 0 ? table->capacity : 8;
+        while (capacity < count) capacity *= 2;
+
+        // All or nothing, so the arrays never disagree on capacity
+        float* current = malloc(capacity * sizeof(float));
+        float* start = malloc(capacity * sizeof(float));
+        float* target = malloc(capacity * sizeof(float));
+        double* started = malloc(capacity * sizeof(double));
+        float* delay = malloc(capacity * sizeof(float));
+        float* duration = malloc(capacity * sizeof(float));
+        uint8_t* easing = malloc(capacity);
+        uint8_t* animating = malloc(capacity);
+        if (!current || !start || !target || !started || !delay || !duration ||
+            !easing || !animating) {
+            free(current); free(start); free(target); free(started);
+            free(delay); free(duration); free(easing); free(animating);
+            return -1;
+        }
+
+        int rows = table->count;
+        if (rows > 0) {
+            memcpy(current, table->current, rows * sizeof(float));
+            memcpy(start, table->start, rows * sizeof(float));
+            memcpy(target, table->target, rows * sizeof(float));
+            memcpy(started, table->started, rows * sizeof(double));
+            memcpy(delay, table->delay, rows * sizeof(float));
+            memcpy(duration, table->duration, rows * sizeof(float));
+            memcpy(easing, table->easing, rows);
+            memcpy(animating, table->animating, rows);
+        }
+        anim_table_free(table);
+        table->current = current;
+        table->start = start;
+        table->target = target;
+        table->started = started;
+        table->delay = delay;
+        table->duration = duration;
+        table->easing = easing;
+        table->animating = animating;
+        table->count = rows;
+        table->capacity = capacity;
+    }
+
+    for (int i = table->count; i < count; i++) {
+        anim_table_set(table, i, 0.0f);
+    }
+    table->count = count;
+    return 0;
+}
+
+void anim_table_free(anim_table_t* table) {
+    if (!table) return;
+
+    free(table->current);
+    free(table->start);
+    free(table->target);
+    free(table->started);
+    free(table->delay);
+    free(table->duration);
+    free(table->easing);
+    free(table->animating);
+    memset(table, 0, sizeof(*table));
+}
+
+void anim_table_remove(anim_table_t* table, int row) {
+    if (!table || row < 0 || row >= table->count) return;
+
+    int after = table->count - row - 1;
+    memmove(table->current + row, table->current + row + 1, after * sizeof(float));
+    memmove(table->start + row, table->start + row + 1, after * sizeof(float));
+    memmove(table->target + row, table->target + row + 1, after * sizeof(float));
+    memmove(table->started + row, table->started + row + 1, after * sizeof(double));
+    memmove(table->delay + row, table->delay + row + 1, after * sizeof(float));
+    memmove(table->duration + row, table->duration + row + 1, after * sizeof(float));
+    memmove(table->easing + row, table->easing + row + 1, after);
+    memmove(table->animating + row, table->animating + row + 1, after);
+    table->count--;
+}
+
+int anim_table_remap(anim_table_t* table, const int* from, int count) {
+    if (!table || count < 0 || (count > 0 && !from)) return -1;
+
+    anim_table_t remapped = {0};
+    if (anim_table_resize(&remapped, count) < 0) return -1;
+    for (int i = 0; i < count; i++) {
+        int row = from[i];
+        if (row < 0 || row >= table->count) continue;  // Rests at 0
+        remapped.current[i] = table->current[row];
+        remapped.start[i] = table->start[row];
+        remapped.target[i] = table->target[row];
+        remapped.started[i] = table->started[row];
+        remapped.delay[i] = table->delay[row];
+        remapped.duration[i] = table->duration[row];
+        remapped.easing[i] = table->easing[row];
+        remapped.animating[i] = table->animating[row];
+    }
+    anim_table_free(table);
+    *table = remapped;
+    return 0;
+}
+
+void anim_table_set(anim_table_t* table, int row, float offset) {
+    table->current[row] = table->start[row] = table->target[row] = offset;
+    table->started[row] = 0.0;
+    table->delay[row] = 0.0f;
+    table->duration[row] = 0.0f;
+    table->easing[row] = EASE_LINEAR;
+    table->animating[row] = 0;
+}
+
+// Offset of a running row at `now`
+static float row_offset(const anim_table_t* table, int row, double now) {
+    double elapsed = now - table->started[row] - table->delay[row];
+    if (elapsed <= 0.0) return table->start[row];
+    if (elapsed >= table->duration[row]) return table->target[row];
+
+    float eased = easing_lookup((float)(elapsed / table->duration[row]), table->easing[row]);
+    return table->start[row] + (table->target[row] - table->start[row]) * eased;
+}
+
+void anim_table_retarget(anim_table_t* table, int row, float target, double now,
+                         float delay, float duration, easing_type_t easing) {
+    if (table->animating[row]) {
+        table->current[row] = row_offset(table, row, now);
+    }
+    table->start[row] = table->current[row];
+    table->target[row] = target;
+    table->started[row] = now;
+    table->delay[row] = delay > 0.0f ? delay : 0.0f;
+    table->duration[row] = duration > 0.0f ? duration : 0.0f;
+    table->easing[row] = (unsigned)easing < EASE_COUNT ? easing : EASE_LINEAR;
+    table->animating[row] = 1;
+}
+
+int anim_table_update(anim_table_t* table, double now, int* changed) {
+    int animating = 0;
+    for (int row = 0; row < table->count; row++) {
+        if (!table->animating[row]) continue;
+
+        float previous = table->current[row];
+        double elapsed = now - table->started[row] - table->delay[row];
+        if (elapsed >= table->duration[row]) {
+            table->current[row] = table->target[row];
+            table->animating[row] = 0;
+        } else {
+            table->current[row] = row_offset(table, row, now);
+            animating++;
+        }
+        if (changed && table->current[row] != previous) *changed = 1;
+    }
+    return animating;
+}
+
+int anim_table_settle(anim_table_t* table, double now, int* changed) {
+    int animating = 0;
+    for (int row = 0; row < table->count; row++) {
+        if (!table->animating[row]) continue;
+
+        double elapsed = now - table->started[row] - table->delay[row];
+        if (elapsed >= table->duration[row]) {
+            if (changed && table->current[row] != table->target[row]) *changed = 1;
+            table->current[row] = table->target[row];
+            table->animating[row] = 0;
+        } else {
+            if (changed && elapsed > 0.0 && table->start[row] != table->target[row]) *changed = 1;
+            animating++;
+        }
+    }
+    return animating;
+}
+
+float anim_table_offset(const anim_table_t* table, int row, double now) {
+    return table->animating[row] ? row_offset(table, row, now) : table->current[row];
+}
+
+int anim_table_rows_match(const anim_table_t* table, int a, int b) {
+    if (!table->animating[a] || !table->animating[b]) {
+        return !table->animating[a] && !table->animating[b] &&
+               table->current[a] == table->current[b];
+    }
+    return table->start[a] == table->start[b] && table->target[a] == table->target[b] &&
+           table->started[a] == table->started[b] && table->delay[a] == table->delay[b] &&
+           table->duration[a] == table->duration[b] && table->easing[a] == table->easing[b];
+}
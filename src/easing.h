@@ -0,0 +1,87 @@
+/*
+ * Easing and layer animation for hyprlax
+ * Easing curves, sampled into lookup tables, and a structure-of-arrays table of
+ * layer offsets that every animated frame advances in one pass
+ */
+
+#ifndef HYPRLAX_EASING_H
+#define HYPRLAX_EASING_H
+
+#include <stdint.h>
+
+#define EASING_LUT_SIZE 1024  // Intervals per curve; interpolation error stays far below a pixel
+
+typedef enum {
+    EASE_LINEAR,
+    EASE_QUAD_OUT,
+    EASE_CUBIC_OUT,
+    EASE_QUART_OUT,
+    EASE_QUINT_OUT,
+    EASE_SINE_OUT,
+    EASE_EXPO_OUT,
+    EASE_CIRC_OUT,
+    EASE_BACK_OUT,
+    EASE_ELASTIC_OUT,
+    EASE_CUSTOM_SNAP,  // Extra snappy custom easing
+    EASE_COUNT
+} easing_type_t;
+
+// Exact curve value for t in [0, 1]
+float easing_apply(float t, easing_type_t type);
+
+// Table-driven value: linear interpolation between EASING_LUT_SIZE + 1 samples
+float easing_lookup(float t, easing_type_t type);
+
+// Whether the curve leaves [0, 1] on the way (back, elastic)
+int easing_overshoots(easing_type_t type);
+
+// Offsets of a set of layers on one output; row i animates layer i. Each array holds
+// `capacity` entries.
+typedef struct {
+    float* current;      // Offset shown this frame, in pixels
+    float* start;        // Offset the running animation started from
+    float* target;       // Offset it ends at
+    double* started;     // When it was retargeted (seconds, get_time() clock)
+    float* delay;        // Seconds to hold start after `started`
+    float* duration;     // Seconds from start to target
+    uint8_t* easing;     // easing_type_t
+    uint8_t* animating;  // Row still moving (or still in its delay)
+    int count;
+    int capacity;
+} anim_table_t;
+
+// Grow or shrink to count rows; new rows rest at offset 0. Returns -1 on allocation failure,
+// leaving the table as it was.
+int anim_table_resize(anim_table_t* table, int count);
+void anim_table_free(anim_table_t* table);
+
+// Drop one row, moving the rows after it down
+void anim_table_remove(anim_table_t* table, int row);
+
+// Reorder rows: new row i takes old row from[i], or rests at 0 where from[i] < 0
+int anim_table_remap(anim_table_t* table, const int* from, int count);
+
+// Place a row at rest on offset
+void anim_table_set(anim_table_t* table, int row, float offset);
+
+// Head for target from wherever the row is at `now`, so an interrupted animation
+// continues without a jump
+void anim_table_retarget(anim_table_t* table, int row, float target, double now,
+                         float delay, float duration, easing_type_t easing);
+
+// Advance every row to `now`. Returns the number of rows still animating and sets
+// *changed if any offset moved.
+int anim_table_update(anim_table_t* table, double now, int* changed);
+
+// Like anim_table_update, but only rows that have finished are written back; rows still
+// on their way keep the offset they were retargeted from. For when something else
+// evaluates the curves (the compositing shader); sets *changed if any row moved.
+int anim_table_settle(anim_table_t* table, double now, int* changed);
+
+// Offset of one row at `now`, without touching the table
+float anim_table_offset(const anim_table_t* table, int row, double now);
+
+// Whether two rows are at the same offset now and will move identically
+int anim_table_rows_match(const anim_table_t* table, int a, int b);
+
+#endif // HYPRLAX_EASING_H
@@ -8,8 +8,13 @@
  *   hyprlax-ctl list
  *   hyprlax-ctl clear
  *   hyprlax-ctl status
+ *   hyprlax-ctl stats [reset]
+ *   hyprlax-ctl reload
+ *   hyprlax-ctl scene <config> [in=seconds] [fade=seconds]
+ *   hyprlax-ctl batch < commands.txt
  */
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -38,10 +43,50 @@ static void print_usage(const char* prog) {
     printf("  %s list|ls\n", prog);
     printf("  %s clear\n", prog);
     printf("  %s status\n", prog);
+    printf("  %s stats [reset]\n", prog);
+    printf("  %s reload           (re-apply the config file, reusing loaded images)\n", prog);
+    printf("  %s scene <config> [in=N] [fade=N]\n", prog);
+    printf("                     (preload another config's layers, crossfade to them in N seconds)\n");
+    printf("  %s batch            (one command per line on stdin, applied together)\n", prog);
     printf("\nExamples:\n");
     printf("  %s add /path/to/image.png scale=1.5 opacity=0.8\n", prog);
     printf("  %s modify 1 opacity 0.5\n", prog);
     printf("  %s remove 1\n", prog);
+    printf("  %s scene ~/.config/hyprlax/night.conf in=60 fade=2\n", prog);
+    printf("  printf 'modify 1 x 10\\nmodify 2 x 20\\n' | %s batch\n", prog);
+}
+
+static int send_all(int sock, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(sock, data, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            perror("Failed to send command");
+            return -1;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return 0;
+}
+
+// Send every line of stdin wrapped in begin/commit, so hyprlax applies them in one redraw
+static int send_batch(int sock) {
+    char command[IPC_MAX_MESSAGE_SIZE];
+    if (send_all(sock, "begin\n", 6) < 0) return -1;
+
+    while (fgets(command, sizeof(command), stdin)) {
+        size_t length = strlen(command);
+        if (length > 0 && command[length - 1] != '\n') {
+            if (length >= sizeof(command) - 1) {
+                fprintf(stderr, "Command too long\n");
+                return -1;
+            }
+            command[length++] = '\n';  // Last line without a newline
+        }
+        if (send_all(sock, command, length) < 0) return -1;
+    }
+
+    return send_all(sock, "commit\n", 7);
 }
 
 int main(int argc, char** argv) {
@@ -74,34 +119,47 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    // Build command string
-    char command[IPC_MAX_MESSAGE_SIZE];
-    size_t offset = 0;
+    if (strcmp(argv[1], "batch") == 0) {
+        if (send_batch(sock) < 0) {
+            close(sock);
+            return 1;
+        }
+    } else {
+        // Build command string
+        char command[IPC_MAX_MESSAGE_SIZE];
+        size_t offset = 0;
 
-    for (int i = 1; i < argc; i++) {
-        int written = snprintf(command + offset, sizeof(command) - offset,
-                               "%s%s", (i > 1 ? " " : ""), argv[i]);
-        if (written < 0 || offset + (size_t)written >= sizeof(command)) {
-            fprintf(stderr, "Command too long\n");
+        for (int i = 1; i < argc; i++) {
+            int written = snprintf(command + offset, sizeof(command) - offset,
+                                   "%s%s", (i > 1 ? " " : ""), argv[i]);
+            if (written < 0 || offset + (size_t)written + 1 >= sizeof(command)) {
+                fprintf(stderr, "Command too long\n");
+                close(sock);
+                return 1;
+            }
+            offset += (size_t)written;
+        }
+        command[offset++] = '\n';
+
+        if (send_all(sock, command, offset) < 0) {
             close(sock);
             return 1;
         }
-        offset += (size_t)written;
     }
 
-    // Send command
-    if (send(sock, command, strlen(command), 0) < 0) {
-        perror("Failed to send command");
-        close(sock);
-        return 1;
-    }
+    // Signal the end of our commands; hyprlax answers them all and then hangs up
+    shutdown(sock, SHUT_WR);
 
-    // Receive response
+    // Print responses, dropping the blank line that terminates each one
     char response[IPC_MAX_MESSAGE_SIZE];
-    ssize_t bytes = recv(sock, response, sizeof(response) - 1, 0);
-    if (bytes > 0) {
-        response[bytes] = '\0';
-        printf("%s", response);
+    bool at_line_start = true;
+    ssize_t bytes;
+    while ((bytes = recv(sock, response, sizeof(response), 0)) > 0) {
+        for (ssize_t i = 0; i < bytes; i++) {
+            if (response[i] == '\n' && at_line_start) continue;
+            putchar(response[i]);
+            at_line_start = response[i] == '\n';
+        }
     }
 
     close(sock);
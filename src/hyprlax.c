@@ -1,20 +1,31 @@
 #define _GNU_SOURCE
 #define HYPRLAX_VERSION "1.3.1"
-#define INITIAL_MAX_LAYERS 8
-#define MAX_CONFIG_LINE_SIZE 512  // Maximum line length in config files
-#define BLUR_SHADER_MAX_SIZE 2048 // Maximum size for dynamically built shader
-#define BLUR_KERNEL_SIZE 5.0f    // Size of the blur kernel
-#define BLUR_WEIGHT_FALLOFF 0.15f // Weight falloff for blur samples
+#define BLUR_SHADER_MAX_SIZE 4096 // Maximum size for dynamically built shader
+#define BLUR_TAPS 8               // Gaussian taps on each side of the center sample, per pass
+#define BLUR_RADIUS_SCALE 10.0f   // Blur radius in screen texels per unit of blur_amount
 #define BLUR_MIN_THRESHOLD 0.001f // Minimum blur amount to apply effect
+#define BATCH_MAX_LAYERS 16         // Layers composited per draw call (also capped by texture units)
+#define BATCH_SHADER_MAX_SIZE 8192  // Maximum size for the generated compositing shader
+#define MAX_LAYER_GROUPS 16         // Cached groups of layers that move together
+#define TILE_WIDTH 1024             // Columns per GPU tile of a tiled layer
+#define TILE_LAYER_MIN_WIDTH 8192   // Wider layers (or any past GL_MAX_TEXTURE_SIZE) are tiled
+#define DECODE_THREADS 4          // Parallel image decodes (each 8K RGBA image needs ~128 MiB)
+#define LAYER_FADE_DURATION 0.4   // Seconds a layer takes to fade in once its texture is ready
+#define BENCH_MAX_SWITCHES 256
+#define BENCH_MAX_FRAMES_PER_SWITCH 100000  // Safety cap if an animation never settles
+#define MAX_FULLSCREEN_WORKSPACES 32  // Workspaces tracked as covered by a fullscreen window
+#define SNAPSHOT_DOWNSCALE 4          // Snapshots are stored at 1/4 of the output size
+#define SNAPSHOT_MAX_WORKSPACES 32    // Workspaces whose snapshots are kept up to date
+#define SNAPSHOT_INTERVAL 1.0         // Minimum seconds between two snapshots of an output
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/inotify.h>
 #include <sys/socket.h>
 #include <sys/un.h>
-#include <sys/wait.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <time.h>
@@ -27,30 +38,34 @@
 #include <wayland-client.h>
 #include <wayland-egl.h>
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
 
 #include "../protocols/xdg-shell-client-protocol.h"
 #include "../protocols/wlr-layer-shell-client-protocol.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
+#include "../protocols/presentation-time-client-protocol.h"
+
+#include "cache.h"
+#include "config.h"
+#include "dmabuf.h"
+#include "easing.h"
+#include "idmap.h"
+#include "image.h"
 #include "ipc.h"
-
-// Easing functions
-typedef enum {
-    EASE_LINEAR,
-    EASE_QUAD_OUT,
-    EASE_CUBIC_OUT,
-    EASE_QUART_OUT,
-    EASE_QUINT_OUT,
-    EASE_SINE_OUT,
-    EASE_EXPO_OUT,
-    EASE_CIRC_OUT,
-    EASE_BACK_OUT,
-    EASE_ELASTIC_OUT,
-    EASE_CUSTOM_SNAP  // Extra snappy custom easing
-} easing_type_t;
+#include "linebuf.h"
+#include "pool.h"
+#include "power.h"
+#include "resscale.h"
+#include "stats.h"
+#include "texcomp.h"
+
+// Where a layer stands in a scene switch (hyprlax-ctl scene)
+enum {
+    SCENE_CURRENT,   // Shown normally
+    SCENE_INCOMING,  // Preloading for the next scene; hidden until the crossfade starts
+    SCENE_OUTGOING   // Fading out with the previous scene
+};
 
 // Layer structure for multi-layer parallax
 struct layer {
@@ -60,45 +75,117 @@ struct layer {
     float opacity;           // Layer opacity (0.0 - 1.0)
     char *image_path;
 
-    // Per-layer animation state
-    float current_offset;
-    float target_offset;
-    float start_offset;
-
     // Phase 3: Advanced per-layer settings
     easing_type_t easing;    // Per-layer easing function
     float animation_delay;   // Per-layer animation delay
     float animation_duration; // Per-layer animation duration
-    double animation_start;  // When this layer's animation started
-    int animating;          // Is this layer currently animating
     float blur_amount;      // Blur amount for depth (0.0 = no blur)
+
+    // Pre-blurred copy of the texture, rebuilt only when its inputs change
+    GLuint blur_texture;
+    int blur_width, blur_height;
+    float blur_cached_amount;      // blur_amount the cache was built for
+    int blur_cached_output_width;  // Output size the cache was built for
+    int blur_cached_output_height;
+    float blur_cached_downscale;   // blur_downscale the cache was built at
+
+    // Asynchronous decode: texture stays 0 until a worker has decoded the image
+    uint32_t load_id;        // Matches decode completions to this layer (0 = none pending)
+    int source_width, source_height;  // Image file size; width/height may be downscaled
+    double fade_start;       // When the texture became ready (0 = fully visible)
+
+    // Alpha coverage of the texture, used to skip hidden layers and trim their quads
+    image_coverage_t coverage;
+    float blur_extent_u, blur_extent_v;  // How far the cached blur spreads, in texture space
+
+    uint64_t content_hash;   // Hash of the uploaded pixels; layers showing the same image share
+                             // one texture
+    cache_format_t format;   // How the texture is stored on the GPU (RGBA8 or S3TC blocks)
+    int imported;            // Texture is an EGLImage over a dma-buf (level 0 only, no mips)
+    uint32_t ipc_id;         // hyprlax-ctl layer id (0 = not managed over IPC)
+    int from_config;         // Listed in the config file; replaced by a config reload
+    double last_drawn;       // Last frame the layer was visible in, for budget eviction
+    int evicted;             // Texture dropped under the texture budget; reloads once visible
+    int scene;               // SCENE_* role while a scene switch is under way
+    int mips_pending;        // Only level 0 is uploaded yet (--deferred-mips)
+    struct decode_job *mip_source;  // Holds levels 1+ until then (NULL = generate on the GPU)
+
+    struct layer_tiles *tiles;  // Set instead of texture for layers too wide to upload whole
 };
 
-// Configuration
-struct config {
-    float shift_per_workspace;
-    float animation_duration;
-    float animation_delay;  // Delay before starting animation
-    float scale_factor;
-    easing_type_t easing;
-    int target_fps;
-    int vsync;
-    int debug;
-    int multi_layer_mode;  // Whether we're using multiple layers
-    int max_workspaces;    // Maximum number of workspaces (detected from Hyprland)
-    char *config_file_path;  // Path to the config file for resolving relative paths
-} config = {
-    .shift_per_workspace = 200.0f,  // More dramatic shift between workspaces
-    .animation_duration = 1.0f,  // Longer duration - user can "feel" it settling
-    .animation_delay = 0.0f,
-    .scale_factor = 1.5f,  // Increased scale to accommodate larger shifts
-    .easing = EASE_EXPO_OUT,  // Exponential ease out - fast then very gentle settling
-    .target_fps = 144,
-    .vsync = 1,
-    .debug = 0,
-    .multi_layer_mode = 0,
-    .max_workspaces = 10,  // Default to 10, will be detected from Hyprland
-    .config_file_path = NULL
+// One monitor: its layer surface, EGL surface and workspace animation.
+// Textures are shared; every output renders with the same EGL context.
+struct output {
+    struct wl_output *wl_output;  // NULL for the offscreen benchmark output
+    uint32_t registry_name;       // wl_registry global name, for hotplug removal
+    char *name;                   // Connector name from wl_output.name (e.g. "DP-1")
+
+    struct wl_surface *surface;
+    struct zwlr_layer_surface_v1 *layer_surface;
+    struct wl_egl_window *egl_window;
+    EGLSurface egl_surface;
+    struct wl_callback *frame_callback;
+    int width, height;
+    int configured;  // Track if we've received initial configuration
+
+    // Animation state
+    anim_table_t anims;       // Offsets of state.layers on this output, one row per layer
+    anim_table_t image_anim;  // Single image mode (one row)
+    double anim_epoch;        // Last retarget; the shader's u_time counts from here
+    int animating;
+    int dirty;  // Something visible changed outside the animation (texture, opacity, size)
+    int current_workspace;
+    int previous_workspace;  // Track previous workspace to detect actual changes
+    double last_frame_time;
+    double last_frame_done;  // Time of the previous frame_done callback (0 = not pacing)
+
+    // Presentation timing, used to animate for when a frame is shown rather than drawn
+    double refresh_period;   // Seconds per refresh (0 = unknown)
+    double last_presented;   // When the last frame reached the screen (0 = unknown)
+    struct wp_presentation_feedback *feedback;  // Pending feedback for the latest frame
+
+    // Dynamic resolution: animated frames are composited into scaled_target, then upscaled
+    GLuint gpu_query;        // GL_TIME_ELAPSED_EXT query of the last composite (0 = none yet)
+    int gpu_query_pending;   // Result not read back yet
+    float gpu_query_scale;   // Resolution scale the timed frame was drawn at
+    resscale_t resscale;
+    GLuint scaled_target;
+    int scaled_width, scaled_height;
+
+    // Fast start: the last session's settled frame, shown until the layers have loaded
+    GLuint snapshot_texture;
+    int snapshot_width, snapshot_height;
+    int snapshot_workspace;
+    int snapshot_drawn;
+    uint64_t snapshot_saved[SNAPSHOT_MAX_WORKSPACES];  // Scene hash last saved per workspace
+    double snapshot_time;                               // When the last one was read back
+    double snapshot_due;     // Redraw for a save the interval held back at this time (0 = none)
+
+    struct output *next;
+};
+
+// A run of adjacent layers that always move together, pre-composited into one texture
+// so a frame samples it once instead of once per member
+struct layer_group {
+    int first, count;        // Member range in state.layers
+    GLuint texture;          // Straight-alpha composite of the members (0 = not built)
+    int width, height;
+    image_coverage_t coverage;  // Union of the members' visible boxes, blur included
+
+    // Inputs the cache was rendered from; any change rebuilds it
+    GLuint sources[BATCH_MAX_LAYERS];
+    float opacities[BATCH_MAX_LAYERS];
+    float blur_amounts[BATCH_MAX_LAYERS];
+};
+
+// A layer too wide to keep on the GPU whole. Level 0 stays in CPU memory (mapped from
+// the texture cache when it was hit) and is uploaded in TILE_WIDTH column tiles; only
+// the tiles an output shows now or will pan across in its current animation are resident.
+struct layer_tiles {
+    struct decode_job *source;  // Owns the level 0 pixels
+    int count;
+    GLuint *textures;           // Per tile, 0 = not resident
+    int direction;              // Sign of the last pan; one extra tile is kept ahead of it
 };
 
 // Global state
@@ -107,35 +194,70 @@ struct {
     struct wl_display *display;
     struct wl_registry *registry;
     struct wl_compositor *compositor;
-    struct wl_output *output;
     struct zwlr_layer_shell_v1 *layer_shell;
-    struct wl_surface *surface;
-    struct zwlr_layer_surface_v1 *layer_surface;
-    struct wl_callback *frame_callback;
+    struct wp_presentation *presentation;  // Optional presentation-time feedback
+    uint32_t presentation_clock;           // clk_id of feedback timestamps
+
+    // Monitors
+    struct output *outputs;
+    struct output *focused_output;  // From focusedmon>> (NULL = unknown, use the first)
 
     // EGL/OpenGL
-    struct wl_egl_window *egl_window;
     EGLDisplay egl_display;
-    EGLContext egl_context;
-    EGLSurface egl_surface;
+    EGLContext egl_context;  // Shared by every output's surface
+    EGLConfig egl_config;
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC swap_buffers_with_damage;  // NULL if unsupported
+    PFNEGLCREATEIMAGEKHRPROC create_image;      // dma-buf import, set only when dmabuf_import is
+    PFNEGLDESTROYIMAGEKHRPROC destroy_image;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC image_target_texture;
+    int dmabuf_import;       // Workers stage level 0 in a udmabuf for EGLImage import
     GLuint texture;  // Single texture for backward compatibility
     GLuint shader_program;
-    GLuint blur_shader_program;  // Blur shader for depth effects
+    GLuint blur_shader_program;  // Separable Gaussian used to build cached blur textures
+    GLuint blur_fbo;             // Framebuffer for rendering blur passes and group caches
+    GLuint blur_temp_texture;    // Intermediate (horizontal pass) target
+    int blur_temp_width, blur_temp_height;
     GLuint vbo, ebo;
 
     // Standard shader uniforms
-    GLint u_opacity;  // Uniform location for opacity
-    GLint u_texture;  // Uniform location for texture
+    GLint u_motion;      // Uniform location for per-layer (from, to, begin, duration) offsets
+    GLint u_easing;      // Uniform location for per-layer easing_type_t
+    GLint u_opacity;     // Uniform location for per-layer opacity
+    GLint u_time;        // Uniform location for the clock motions are eased against
+    GLint u_max_offset;  // Uniform location for the panning room, which eased offsets stay in
+    GLint u_rect;        // Uniform location for the screen region a batch covers
+    GLint u_view_width;  // Uniform location for the visible fraction of the texture width
+    GLint u_flip;        // Uniform location for the vertical flip (-1 when drawing to a texture)
+    GLint u_count;       // Uniform location for the number of layers in a batch
+    GLint pos_attrib;    // Attribute location in the compositing shader
+    GLuint quad_vbo;     // Static full-screen quad used by the compositing pass
+    int batch_size;      // Layers per draw call (samplers in the compositing shader)
+    GLuint batch_bound[BATCH_MAX_LAYERS];  // Texture bound to each batch unit
+    int batch_bindings_valid;              // Cleared whenever a texture is deleted
+    GLint max_texture_size;  // GL_MAX_TEXTURE_SIZE, read by decode workers
+    int s3tc_supported;      // GL_EXT_texture_compression_s3tc (BC1/BC3 uploads)
+
+    // Pre-composited runs of layers that move together, in layer order
+    struct layer_group layer_groups[MAX_LAYER_GROUPS];
+    int layer_group_count;
+    int layer_groups_valid;  // Cleared whenever a texture is deleted (its name may be reused)
+    GLuint group_scratch_texture;  // Premultiplied composite before conversion
+    int group_scratch_width, group_scratch_height;
+    GLuint unpremultiply_program;  // Converts a group composite to straight alpha
+    GLuint copy_program;           // Upscales a reduced-resolution composite to the screen
+
+    // GL_EXT_disjoint_timer_query, all NULL when the driver lacks it
+    PFNGLGENQUERIESEXTPROC gen_queries;
+    PFNGLDELETEQUERIESEXTPROC delete_queries;
+    PFNGLBEGINQUERYEXTPROC begin_query;
+    PFNGLENDQUERYEXTPROC end_query;
+    PFNGLGETQUERYOBJECTUIVEXTPROC get_query_uint;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_u64;
+    int timer_query;         // All of the above resolved
 
     // Blur shader uniforms
     GLint blur_u_texture;  // Uniform location for texture in blur shader
-    GLint blur_u_opacity;  // Uniform location for opacity in blur shader
-    GLint blur_u_blur_amount;  // Uniform location for blur amount
-    GLint blur_u_resolution;  // Uniform location for resolution
-
-    // Window dimensions
-    int width, height;
-    int configured;  // Track if we've received initial configuration
+    GLint blur_u_step;     // Uniform location for the per-tap offset along the pass direction
 
     // Image data (for single layer mode)
     int img_width, img_height;
@@ -145,84 +267,57 @@ struct {
     int layer_count;
     int max_layers;
 
-    // Animation state
-    float current_offset;
-    float target_offset;
-    float start_offset;
-    double animation_start;
-    int animating;
-    int current_workspace;
-    int previous_workspace;  // Track previous workspace to detect actual changes
-
     // Performance tracking
-    double last_frame_time;
     int frame_count;
     double fps_timer;
+    frame_stats_t stats;     // Always-on frame timing ring buffer
+
+    // Texture memory accounting (estimated, includes mip chains)
+    size_t texture_bytes;
+    size_t peak_texture_bytes;
 
     // Hyprland IPC
     int ipc_fd;
+    linebuf_t ipc_events;    // Event stream bytes, kept across reads until a line completes
+    int workspace_query_fd;  // In-flight j/workspaces request on .socket.sock, or -1
+    int workspace_query_stale;  // Workspaces changed while the query was in flight
+    linebuf_t workspace_reply;
 
     // hyprlax IPC for dynamic layer management
     ipc_context_t *ipc_ctx;
+    idmap_t ipc_slots;       // IPC layer id -> index in layers
+
+    int config_watch_fd;     // inotify on the config file's directory (--watch-config), or -1
+    struct config file_base;     // Settings before the config file was read (defaults, earlier options)
+    struct config cli_settings;  // Settings after all command-line options
+    unsigned cli_overrides;      // CONFIG_SET_* bits given on the command line after --config
+
+    // Scene switch (hyprlax-ctl scene): the next config's layers preload hidden above the
+    // current ones, and the two crossfade once they have loaded and the switch time is up
+    int scene_pending;
+    double scene_switch_at;        // Earliest crossfade start (get_time() clock)
+    double scene_fade_start;       // When the crossfade started (0 = not yet)
+    double scene_fade;             // Crossfade length in seconds
+    struct config scene_settings;  // Settings from the scene's file, applied once it is shown
+
+    // Power-aware render policy (--power-policy)
+    power_profile_id_t power_profile;  // Profile in effect
+    int on_battery;
+    double power_checked_at;   // Last battery read (0 = never)
+
+    // Workspaces with a fullscreen window, from fullscreen>> events (which only report
+    // changes, so the state is remembered per workspace). Outputs showing one aren't drawn.
+    int fullscreen_workspaces[MAX_FULLSCREEN_WORKSPACES];
+    int fullscreen_count;
+
+    // Background image decoding
+    worker_pool_t *decode_pool;
+    uint32_t next_load_id;
 
     // Running state
     int running;
 } state = {0};
 
-// Easing functions implementation
-float apply_easing(float t, easing_type_t type) {
-    switch (type) {
-        case EASE_LINEAR:
-            return t;
-
-        case EASE_QUAD_OUT:
-            return 1.0f - (1.0f - t) * (1.0f - t);
-
-        case EASE_CUBIC_OUT:
-            return 1.0f - powf(1.0f - t, 3.0f);
-
-        case EASE_QUART_OUT:
-            return 1.0f - powf(1.0f - t, 4.0f);
-
-        case EASE_QUINT_OUT:
-            return 1.0f - powf(1.0f - t, 5.0f);
-
-        case EASE_SINE_OUT:
-            return sinf((t * M_PI) / 2.0f);
-
-        case EASE_EXPO_OUT:
-            return t == 1.0f ? 1.0f : 1.0f - powf(2.0f, -10.0f * t);
-
-        case EASE_CIRC_OUT:
-            return sqrtf(1.0f - powf(t - 1.0f, 2.0f));
-
-        case EASE_BACK_OUT: {
-            float c1 = 1.70158f;
-            float c3 = c1 + 1.0f;
-            return 1.0f + c3 * powf(t - 1.0f, 3.0f) + c1 * powf(t - 1.0f, 2.0f);
-        }
-
-        case EASE_ELASTIC_OUT: {
-            float c4 = (2.0f * M_PI) / 3.0f;
-            return t == 0 ? 0 : t == 1 ? 1 : powf(2.0f, -10.0f * t) * sinf((t * 10.0f - 0.75f) * c4) + 1.0f;
-        }
-
-        case EASE_CUSTOM_SNAP: {
-            // Custom extra snappy easing - fast start, very quick deceleration at the end
-            if (t < 0.4f) {
-                // Accelerate quickly for first 40% of time
-                return 1.0f - powf(1.0f - (t * 2.5f), 6.0f);
-            } else {
-                // Then ease out more gently
-                return 1.0f - powf(1.0f - t, 8.0f);
-            }
-        }
-
-        default:
-            return t;
-    }
-}
-
 // Shader sources with better precision
 const char *vertex_shader_src =
     "precision highp float;\n"
@@ -234,20 +329,195 @@ const char *vertex_shader_src =
     "    v_texcoord = texcoord;\n"
     "}\n";
 
-const char *fragment_shader_src =
+// Undo premultiplication of a layer group composite; fully transparent texels stay black
+const char *unpremultiply_fragment_shader_src =
     "precision highp float;\n"
     "varying vec2 v_texcoord;\n"
     "uniform sampler2D u_texture;\n"
-    "uniform float u_opacity;\n"
     "void main() {\n"
     "    vec4 color = texture2D(u_texture, v_texcoord);\n"
-    "    // Premultiply alpha for correct blending\n"
-    "    float final_alpha = color.a * u_opacity;\n"
-    "    gl_FragColor = vec4(color.rgb * final_alpha, final_alpha);\n"
+    "    gl_FragColor = color.a > 0.0 ? vec4(color.rgb / color.a, color.a) : vec4(0.0);\n"
+    "}\n";
+
+// Plain copy, for upscaling a composite drawn at reduced resolution
+const char *copy_fragment_shader_src =
+    "precision mediump float;\n"
+    "varying vec2 v_texcoord;\n"
+    "uniform sampler2D u_texture;\n"
+    "void main() {\n"
+    "    gl_FragColor = texture2D(u_texture, v_texcoord);\n"
     "}\n";
 
-// Build blur fragment shader with constants
-// Note: sprintf is used here for simple constant injection at runtime
+// Easing curves for the compositing vertex shader, mirroring easing_apply(). The type
+// arrives as a float uniform, so it is compared against whole numbers.
+static const char *composite_easing_src =
+    "float ease(float t, float type) {\n"
+    "    float u = 1.0 - t;\n"
+    "    if (type == %d.0) return 1.0 - u * u;\n"
+    "    if (type == %d.0) return 1.0 - u * u * u;\n"
+    "    if (type == %d.0) return 1.0 - u * u * u * u;\n"
+    "    if (type == %d.0) return 1.0 - u * u * u * u * u;\n"
+    "    if (type == %d.0) return sin(t * 1.5707963);\n"
+    "    if (type == %d.0) return t >= 1.0 ? 1.0 : 1.0 - exp2(-10.0 * t);\n"
+    "    if (type == %d.0) return sqrt(max(1.0 - u * u, 0.0));\n"
+    "    if (type == %d.0) return 1.0 - 2.70158 * u * u * u + 1.70158 * u * u;\n"
+    "    if (type == %d.0) {\n"
+    "        if (t <= 0.0 || t >= 1.0) return t;\n"
+    "        return exp2(-10.0 * t) * sin((t * 10.0 - 0.75) * 2.0943951) + 1.0;\n"
+    "    }\n"
+    "    if (type == %d.0) {\n"
+    "        float s = 1.0 - t * 2.5;\n"
+    "        return t < 0.4 ? 1.0 - s * s * s * s * s * s : 1.0 - u * u * u * u * u * u * u * u;\n"
+    "    }\n"
+    "    return t;\n"
+    "}\n";
+
+// Build the compositing vertex shader for up to `count` layers per pass. position is
+// 0..1 across u_rect, the screen region (v down) being drawn, so a batch can be trimmed
+// to where its layers are visible. u_flip = -1 renders into a texture upright, since
+// textures store their first row at the bottom.
+//
+// Each layer's texture offset is eased here from u_motion[i] = (from, to, begin, duration)
+// at u_time, so an animation only needs the clock to advance; a duration of 0 holds the
+// layer at `from`. Offsets reach the fragment shader packed four to a varying.
+char *build_composite_vertex_shader(int count) {
+    char *shader = malloc(BATCH_SHADER_MAX_SIZE);
+    if (!shader) {
+        fprintf(stderr, "Failed to allocate memory for compositing vertex shader\n");
+        return NULL;
+    }
+
+    int written = snprintf(shader, BATCH_SHADER_MAX_SIZE,
+        "precision highp float;\n"
+        "attribute vec2 position;\n"
+        "uniform vec4 u_rect;\n"
+        "uniform float u_flip;\n"
+        "uniform vec4 u_motion[%d];\n"
+        "uniform float u_easing[%d];\n"
+        "uniform float u_time;\n"
+        "uniform float u_max_offset;\n"
+        "varying vec2 v_texcoord;\n"
+        "varying vec4 v_offsets[%d];\n",
+        count, count, (count + 3) / 4);
+
+    if (written > 0 && written < BATCH_SHADER_MAX_SIZE) {
+        written += snprintf(shader + written, BATCH_SHADER_MAX_SIZE - written, composite_easing_src,
+            EASE_QUAD_OUT, EASE_CUBIC_OUT, EASE_QUART_OUT, EASE_QUINT_OUT, EASE_SINE_OUT,
+            EASE_EXPO_OUT, EASE_CIRC_OUT, EASE_BACK_OUT, EASE_ELASTIC_OUT, EASE_CUSTOM_SNAP);
+    }
+
+    if (written > 0 && written < BATCH_SHADER_MAX_SIZE) {
+        written += snprintf(shader + written, BATCH_SHADER_MAX_SIZE - written,
+            "float layer_offset(vec4 motion, float easing) {\n"
+            "    if (motion.w <= 0.0) return motion.x;\n"
+            "    float t = clamp((u_time - motion.z) / motion.w, 0.0, 1.0);\n"
+            "    return clamp(motion.x + (motion.y - motion.x) * ease(t, easing), 0.0, u_max_offset);\n"
+            "}\n"
+            "void main() {\n"
+            "    vec2 uv = mix(u_rect.xy, u_rect.zw, position);\n"
+            "    gl_Position = vec4(uv.x * 2.0 - 1.0, (1.0 - uv.y * 2.0) * u_flip, 0.0, 1.0);\n"
+            "    v_texcoord = uv;\n");
+    }
+
+    for (int i = 0; i < count && written > 0 && written < BATCH_SHADER_MAX_SIZE; i += 4) {
+        written += snprintf(shader + written, BATCH_SHADER_MAX_SIZE - written,
+            "    v_offsets[%d] = vec4(", i / 4);
+        for (int j = i; j < i + 4 && written > 0 && written < BATCH_SHADER_MAX_SIZE; j++) {
+            if (j < count) {
+                written += snprintf(shader + written, BATCH_SHADER_MAX_SIZE - written,
+                    "%slayer_offset(u_motion[%d], u_easing[%d])", j > i ? ", " : "", j, j);
+            } else {
+                written += snprintf(shader + written, BATCH_SHADER_MAX_SIZE - written, ", 0.0");
+            }
+        }
+        if (written > 0 && written < BATCH_SHADER_MAX_SIZE) {
+            written += snprintf(shader + written, BATCH_SHADER_MAX_SIZE - written, ");\n");
+        }
+    }
+
+    if (written > 0 && written < BATCH_SHADER_MAX_SIZE) {
+        written += snprintf(shader + written, BATCH_SHADER_MAX_SIZE - written, "}\n");
+    }
+
+    if (written < 0) {
+        fprintf(stderr, "Error: Compositing vertex shader formatting failed\n");
+        free(shader);
+        return NULL;
+    }
+
+    if (written >= BATCH_SHADER_MAX_SIZE) {
+        fprintf(stderr, "Error: Compositing vertex shader source too large (needed %d bytes, have %d)\n",
+                written, BATCH_SHADER_MAX_SIZE);
+        free(shader);
+        return NULL;
+    }
+
+    return shader;
+}
+
+// Build the compositing fragment shader for up to `count` layers per pass. Layer i is
+// sampled from u_layers[i] (texture unit i + 1) at its own offset and blended over the
+// layers before it, so a whole batch is drawn in one pass. GLES2 only allows constant
+// sampler indices, hence the unrolled body.
+char *build_composite_shader(int count) {
+    char *shader = malloc(BATCH_SHADER_MAX_SIZE);
+    if (!shader) {
+        fprintf(stderr, "Failed to allocate memory for compositing shader\n");
+        return NULL;
+    }
+
+    int written = snprintf(shader, BATCH_SHADER_MAX_SIZE,
+        "precision highp float;\n"
+        "varying vec2 v_texcoord;\n"
+        "varying vec4 v_offsets[%d];\n"
+        "uniform sampler2D u_layers[%d];\n"
+        "uniform float u_opacity[%d];\n"
+        "uniform float u_view_width;\n"
+        "uniform int u_count;\n"
+        "void main() {\n"
+        "    vec2 uv = vec2(v_texcoord.x * u_view_width, v_texcoord.y);\n"
+        "    vec4 result = vec4(0.0);\n"
+        "    vec4 color;\n"
+        "    float alpha;\n",
+        (count + 3) / 4, count, count);
+
+    for (int i = 0; i < count && written > 0 && written < BATCH_SHADER_MAX_SIZE; i++) {
+        // Premultiplied alpha, back to front
+        written += snprintf(shader + written, BATCH_SHADER_MAX_SIZE - written,
+            "    if (u_count > %d) {\n"
+            "        color = texture2D(u_layers[%d], uv + vec2(v_offsets[%d].%c, 0.0));\n"
+            "        alpha = color.a * u_opacity[%d];\n"
+            "        result = vec4(color.rgb * alpha, alpha) + result * (1.0 - alpha);\n"
+            "    }\n",
+            i, i, i / 4, "xyzw"[i % 4], i);
+    }
+
+    if (written > 0 && written < BATCH_SHADER_MAX_SIZE) {
+        written += snprintf(shader + written, BATCH_SHADER_MAX_SIZE - written,
+            "    gl_FragColor = result;\n"
+            "}\n");
+    }
+
+    if (written < 0) {
+        fprintf(stderr, "Error: Compositing shader formatting failed\n");
+        free(shader);
+        return NULL;
+    }
+
+    if (written >= BATCH_SHADER_MAX_SIZE) {
+        fprintf(stderr, "Error: Compositing shader source too large (needed %d bytes, have %d)\n",
+                written, BATCH_SHADER_MAX_SIZE);
+        free(shader);
+        return NULL;
+    }
+
+    return shader;
+}
+
+// Build separable Gaussian blur fragment shader with constant weights
+// The shader blurs along one axis; u_step is the UV distance between taps, so the same
+// program runs the horizontal and vertical passes and any radius with BLUR_TAPS samples
+// Note: snprintf is used here for simple constant injection at runtime
 // This is a common pattern in OpenGL applications for shader variants
 char *build_blur_shader() {
     char *shader = malloc(BLUR_SHADER_MAX_SIZE);
@@ -256,39 +526,36 @@ char *build_blur_shader() {
         return NULL;
     }
 
+    // Gaussian weights with the outermost tap at 3 sigma, normalized to sum to 1
+    float weights[BLUR_TAPS + 1];
+    float sigma = BLUR_TAPS / 3.0f;
+    float total = 0.0f;
+    for (int i = 0; i <= BLUR_TAPS; i++) {
+        weights[i] = expf(-(float)(i * i) / (2.0f * sigma * sigma));
+        total += (i == 0) ? weights[i] : 2.0f * weights[i];
+    }
+
     int written = snprintf(shader, BLUR_SHADER_MAX_SIZE,
         "precision highp float;\n"
         "varying vec2 v_texcoord;\n"
         "uniform sampler2D u_texture;\n"
-        "uniform float u_opacity;\n"
-        "uniform float u_blur_amount;\n"
-        "uniform vec2 u_resolution;\n"
+        "uniform vec2 u_step;\n"
         "void main() {\n"
-        "    float blur = u_blur_amount;\n"
-        "    if (blur < %.4f) {\n"  // BLUR_MIN_THRESHOLD
-        "        vec4 color = texture2D(u_texture, v_texcoord);\n"
-        "        gl_FragColor = vec4(color.rgb, color.a * u_opacity);\n"
-        "        return;\n"
-        "    }\n"
-        "    \n"
-        "    // DEBUG: Make blur effect super obvious by tinting red AND blurring\n"
-        "    vec2 texelSize = 1.0 / u_resolution;\n"
-        "    vec4 result = vec4(0.0);\n"
-        "    float samples = 0.0;\n"
-        "    \n"
-        "    // Large blur radius for testing\n"
-        "    for (float x = -10.0; x <= 10.0; x += 2.0) {\n"
-        "        for (float y = -10.0; y <= 10.0; y += 2.0) {\n"
-        "            vec2 offset = vec2(x, y) * texelSize * blur;\n"
-        "            result += texture2D(u_texture, v_texcoord + offset);\n"
-        "            samples += 1.0;\n"
-        "        }\n"
-        "    }\n"
-        "    \n"
-        "    result /= samples;\n"
-        "    gl_FragColor = vec4(result.rgb, result.a * u_opacity);\n"
-        "}\n",
-        BLUR_MIN_THRESHOLD);
+        "    vec4 result = texture2D(u_texture, v_texcoord) * %.6f;\n",
+        weights[0] / total);
+
+    for (int i = 1; i <= BLUR_TAPS && written > 0 && written < BLUR_SHADER_MAX_SIZE; i++) {
+        written += snprintf(shader + written, BLUR_SHADER_MAX_SIZE - written,
+            "    result += (texture2D(u_texture, v_texcoord + u_step * %d.0) +\n"
+            "               texture2D(u_texture, v_texcoord - u_step * %d.0)) * %.6f;\n",
+            i, i, weights[i] / total);
+    }
+
+    if (written > 0 && written < BLUR_SHADER_MAX_SIZE) {
+        written += snprintf(shader + written, BLUR_SHADER_MAX_SIZE - written,
+            "    gl_FragColor = result;\n"
+            "}\n");
+    }
 
     // Check if formatting failed first
     if (written < 0) {
@@ -315,6 +582,39 @@ double get_time() {
     return ts.tv_sec + ts.tv_nsec / 1000000000.0;
 }
 
+// Render profile in effect; without --power-policy nothing is restricted
+static const power_profile_t *active_profile(void) {
+    static const power_profile_t unrestricted = { 0, 1.0f, 1, 0 };
+    return config.power_policy ? &config.power_profiles[state.power_profile] : &unrestricted;
+}
+
+// --fps, lowered by the active profile's cap
+static int frame_rate_cap(void) {
+    int fps = active_profile()->fps;
+    if (fps > 0 && (config.target_fps <= 0 || fps < config.target_fps)) return fps;
+    return config.target_fps;
+}
+
+// Whether Hyprland reported a fullscreen window on a workspace
+static int workspace_is_fullscreen(int workspace) {
+    for (int i = 0; i < state.fullscreen_count; i++) {
+        if (state.fullscreen_workspaces[i] == workspace) return 1;
+    }
+    return 0;
+}
+
+static void set_workspace_fullscreen(int workspace, int fullscreen) {
+    for (int i = 0; i < state.fullscreen_count; i++) {
+        if (state.fullscreen_workspaces[i] == workspace) {
+            if (!fullscreen) state.fullscreen_workspaces[i] = state.fullscreen_workspaces[--state.fullscreen_count];
+            return;
+        }
+    }
+    if (fullscreen && state.fullscreen_count < MAX_FULLSCREEN_WORKSPACES) {
+        state.fullscreen_workspaces[state.fullscreen_count++] = workspace;
+    }
+}
+
 // Helper: Compile shader
 GLuint compile_shader(GLenum type, const char *source) {
     GLuint shader = glCreateShader(type);
@@ -335,15 +635,85 @@ GLuint compile_shader(GLenum type, const char *source) {
 }
 
 // Initialize OpenGL with optimizations
+// Look up the EGLImage entry points for zero-copy uploads; workers only stage dma-bufs
+// once all of them, and /dev/udmabuf, are available
+static void init_dmabuf_import(const char *gl_extensions) {
+    const char *egl_extensions = eglQueryString(state.egl_display, EGL_EXTENSIONS);
+    if (egl_extensions && strstr(egl_extensions, "EGL_EXT_image_dma_buf_import") &&
+        gl_extensions && strstr(gl_extensions, "GL_OES_EGL_image")) {
+        state.create_image = (PFNEGLCREATEIMAGEKHRPROC)eglGetProcAddress("eglCreateImageKHR");
+        state.destroy_image = (PFNEGLDESTROYIMAGEKHRPROC)eglGetProcAddress("eglDestroyImageKHR");
+        state.image_target_texture = (PFNGLEGLIMAGETARGETTEXTURE2DOESPROC)
+            eglGetProcAddress("glEGLImageTargetTexture2DOES");
+    }
+    state.dmabuf_import = state.create_image && state.destroy_image &&
+                          state.image_target_texture && dmabuf_supported();
+    if (!state.dmabuf_import) {
+        fprintf(stderr, "Warning: dma-buf import or %s unavailable, layers are copied on upload\n",
+                DMABUF_DEVICE);
+    }
+}
+
 int init_gl() {
+    // One texture unit per batched layer; unit 0 stays free for uploads and blur passes.
+    // Layer parameters are budgeted at two uniform vectors each for tight GLES2 drivers,
+    // in both stages, and offsets take a quarter of a varying each.
+    GLint max_units = 0, max_vectors = 0, max_vertex_vectors = 0, max_varyings = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &max_units);
+    glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_VECTORS, &max_vectors);
+    glGetIntegerv(GL_MAX_VERTEX_UNIFORM_VECTORS, &max_vertex_vectors);
+    glGetIntegerv(GL_MAX_VARYING_VECTORS, &max_varyings);
+    state.batch_size = max_units - 1 < BATCH_MAX_LAYERS ? max_units - 1 : BATCH_MAX_LAYERS;
+    if (state.batch_size > (max_vectors - 2) / 2) state.batch_size = (max_vectors - 2) / 2;
+    if (state.batch_size > (max_vertex_vectors - 4) / 2) state.batch_size = (max_vertex_vectors - 4) / 2;
+    if (state.batch_size > (max_varyings - 1) * 4) state.batch_size = (max_varyings - 1) * 4;
+    if (state.batch_size < 1) state.batch_size = 1;
+
+    // Set before any decode is queued; workers only read them
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &state.max_texture_size);
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    state.s3tc_supported = extensions && strstr(extensions, "GL_EXT_texture_compression_s3tc");
+
+    // GPU frame timing, for stats and dynamic resolution
+    if (extensions && strstr(extensions, "GL_EXT_disjoint_timer_query")) {
+        state.gen_queries = (PFNGLGENQUERIESEXTPROC)eglGetProcAddress("glGenQueriesEXT");
+        state.delete_queries = (PFNGLDELETEQUERIESEXTPROC)eglGetProcAddress("glDeleteQueriesEXT");
+        state.begin_query = (PFNGLBEGINQUERYEXTPROC)eglGetProcAddress("glBeginQueryEXT");
+        state.end_query = (PFNGLENDQUERYEXTPROC)eglGetProcAddress("glEndQueryEXT");
+        state.get_query_uint = (PFNGLGETQUERYOBJECTUIVEXTPROC)eglGetProcAddress("glGetQueryObjectuivEXT");
+        state.get_query_u64 = (PFNGLGETQUERYOBJECTUI64VEXTPROC)eglGetProcAddress("glGetQueryObjectui64vEXT");
+    }
+    state.timer_query = state.gen_queries && state.delete_queries && state.begin_query &&
+                        state.end_query && state.get_query_uint && state.get_query_u64;
+    if (config.dynamic_resolution && !state.timer_query) {
+        fprintf(stderr, "Warning: GL_EXT_disjoint_timer_query unavailable, dynamic resolution disabled\n");
+    }
+    if (config.compress_textures && !state.s3tc_supported) {
+        fprintf(stderr, "Warning: S3TC textures not supported by the driver, layers stay RGBA\n");
+    }
+    if (config.dmabuf_upload) {
+        init_dmabuf_import(extensions);
+    }
+
+    char *composite_vertex_src = build_composite_vertex_shader(state.batch_size);
+    char *composite_shader_src = build_composite_shader(state.batch_size);
+    if (!composite_vertex_src || !composite_shader_src) {
+        free(composite_vertex_src);
+        free(composite_shader_src);
+        return -1;
+    }
+
     // Create standard shader program
     GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_shader_src);
-    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_src);
+    GLuint composite_vertex = compile_shader(GL_VERTEX_SHADER, composite_vertex_src);
+    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, composite_shader_src);
+    free(composite_vertex_src);
+    free(composite_shader_src);
 
-    if (!vertex_shader || !fragment_shader) return -1;
+    if (!vertex_shader || !composite_vertex || !fragment_shader) return -1;
 
     state.shader_program = glCreateProgram();
-    glAttachShader(state.shader_program, vertex_shader);
+    glAttachShader(state.shader_program, composite_vertex);
     glAttachShader(state.shader_program, fragment_shader);
     glLinkProgram(state.shader_program);
 
@@ -362,8 +732,8 @@ int init_gl() {
     }
     
     if (config.debug) {
-        fprintf(stderr, "Building blur shader with BLUR_KERNEL_SIZE=%.1f, BLUR_WEIGHT_FALLOFF=%.2f\n", 
-                BLUR_KERNEL_SIZE, BLUR_WEIGHT_FALLOFF);
+        fprintf(stderr, "Building separable blur shader with %d taps per side, downscale %.2f\n",
+                BLUR_TAPS, config.blur_downscale);
     }
 
     GLuint blur_fragment = compile_shader(GL_FRAGMENT_SHADER, blur_shader_src);
@@ -392,20 +762,72 @@ int init_gl() {
         fprintf(stderr, "Blur shader linked successfully, program ID: %d\n", state.blur_shader_program);
     }
 
+    // Layer group caches are converted with a trivial pass; without it groups are skipped
+    GLuint unpremultiply_fragment = compile_shader(GL_FRAGMENT_SHADER, unpremultiply_fragment_shader_src);
+    if (unpremultiply_fragment) {
+        state.unpremultiply_program = glCreateProgram();
+        glAttachShader(state.unpremultiply_program, vertex_shader);
+        glAttachShader(state.unpremultiply_program, unpremultiply_fragment);
+        glLinkProgram(state.unpremultiply_program);
+        glGetProgramiv(state.unpremultiply_program, GL_LINK_STATUS, &status);
+        if (!status) {
+            fprintf(stderr, "Warning: Layer group shader linking failed, groups disabled\n");
+            glDeleteProgram(state.unpremultiply_program);
+            state.unpremultiply_program = 0;
+        }
+        glDeleteShader(unpremultiply_fragment);
+    }
+
+    // Dynamic resolution needs a pass to upscale with; without it frames stay full size
+    GLuint copy_fragment = compile_shader(GL_FRAGMENT_SHADER, copy_fragment_shader_src);
+    if (copy_fragment) {
+        state.copy_program = glCreateProgram();
+        glAttachShader(state.copy_program, vertex_shader);
+        glAttachShader(state.copy_program, copy_fragment);
+        glLinkProgram(state.copy_program);
+        glGetProgramiv(state.copy_program, GL_LINK_STATUS, &status);
+        if (!status) {
+            fprintf(stderr, "Warning: Copy shader linking failed, dynamic resolution disabled\n");
+            glDeleteProgram(state.copy_program);
+            state.copy_program = 0;
+        }
+        glDeleteShader(copy_fragment);
+    }
+
     glDeleteShader(vertex_shader);
+    glDeleteShader(composite_vertex);
     glDeleteShader(fragment_shader);
     glDeleteShader(blur_fragment);
 
     glUseProgram(state.shader_program);
 
     // Get uniform locations for standard shader with error checking
-    state.u_texture = glGetUniformLocation(state.shader_program, "u_texture");
-    if (state.u_texture == -1) {
-        fprintf(stderr, "Warning: Failed to find uniform 'u_texture' in standard shader\n");
-    }
+    state.u_motion = glGetUniformLocation(state.shader_program, "u_motion");
+    state.u_easing = glGetUniformLocation(state.shader_program, "u_easing");
     state.u_opacity = glGetUniformLocation(state.shader_program, "u_opacity");
-    if (state.u_opacity == -1) {
-        fprintf(stderr, "Warning: Failed to find uniform 'u_opacity' in standard shader\n");
+    state.u_time = glGetUniformLocation(state.shader_program, "u_time");
+    state.u_max_offset = glGetUniformLocation(state.shader_program, "u_max_offset");
+    state.u_rect = glGetUniformLocation(state.shader_program, "u_rect");
+    state.u_view_width = glGetUniformLocation(state.shader_program, "u_view_width");
+    state.u_count = glGetUniformLocation(state.shader_program, "u_count");
+    state.u_flip = glGetUniformLocation(state.shader_program, "u_flip");
+    if (state.u_motion == -1 || state.u_easing == -1 || state.u_opacity == -1 ||
+        state.u_time == -1 || state.u_max_offset == -1 || state.u_rect == -1 ||
+        state.u_view_width == -1 || state.u_count == -1 || state.u_flip == -1) {
+        fprintf(stderr, "Warning: Failed to find compositing uniforms in standard shader\n");
+    }
+    state.pos_attrib = glGetAttribLocation(state.shader_program, "position");
+
+    // Samplers never change: batch slot i always reads texture unit i + 1
+    GLint units[BATCH_MAX_LAYERS];
+    for (int i = 0; i < state.batch_size; i++) {
+        units[i] = i + 1;
+    }
+    glUniform1iv(glGetUniformLocation(state.shader_program, "u_layers"), state.batch_size, units);
+    state.batch_bindings_valid = 0;
+
+    if (config.debug) {
+        fprintf(stderr, "Compositing up to %d layers per draw call\n", state.batch_size);
     }
 
     // Get uniform locations for blur shader with error checking
@@ -414,22 +836,14 @@ int init_gl() {
     if (state.blur_u_texture == -1) {
         fprintf(stderr, "Warning: Failed to find uniform 'u_texture' in blur shader\n");
     }
-    state.blur_u_opacity = glGetUniformLocation(state.blur_shader_program, "u_opacity");
-    if (state.blur_u_opacity == -1) {
-        fprintf(stderr, "Warning: Failed to find uniform 'u_opacity' in blur shader\n");
+    state.blur_u_step = glGetUniformLocation(state.blur_shader_program, "u_step");
+    if (state.blur_u_step == -1) {
+        fprintf(stderr, "Warning: Failed to find uniform 'u_step' in blur shader\n");
     }
-    state.blur_u_blur_amount = glGetUniformLocation(state.blur_shader_program, "u_blur_amount");
-    if (state.blur_u_blur_amount == -1) {
-        fprintf(stderr, "Warning: Failed to find uniform 'u_blur_amount' in blur shader\n");
-    }
-    state.blur_u_resolution = glGetUniformLocation(state.blur_shader_program, "u_resolution");
-    if (state.blur_u_resolution == -1) {
-        fprintf(stderr, "Warning: Failed to find uniform 'u_resolution' in blur shader\n");
-    }
-    
+
     if (config.debug) {
-        fprintf(stderr, "Blur shader uniform locations: texture=%d, opacity=%d, blur_amount=%d, resolution=%d\n",
-               state.blur_u_texture, state.blur_u_opacity, state.blur_u_blur_amount, state.blur_u_resolution);
+        fprintf(stderr, "Blur shader uniform locations: texture=%d, step=%d\n",
+               state.blur_u_texture, state.blur_u_step);
     }
 
     // Switch back to standard shader
@@ -439,11 +853,25 @@ int init_gl() {
     glGenBuffers(1, &state.vbo);
     glGenBuffers(1, &state.ebo);
 
+    // Framebuffer used to render cached blur textures
+    glGenFramebuffers(1, &state.blur_fbo);
+
     // Set up static index buffer
     GLushort indices[] = {0, 1, 2, 0, 2, 3};
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state.ebo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
+    // Unit quad stretched over each batch's u_rect; layer offsets are applied in the shader
+    float quad[] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        1.0f, 1.0f,
+        0.0f, 1.0f,
+    };
+    glGenBuffers(1, &state.quad_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, state.quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
     // Disable depth testing and blending for better performance
     glDisable(GL_DEPTH_TEST);
     glDisable(GL_BLEND);
@@ -451,197 +879,888 @@ int init_gl() {
     return 0;
 }
 
-// Load image as texture with mipmaps
-int load_image(const char *path) {
-    int channels;
-    unsigned char *data = stbi_load(path, &state.img_width, &state.img_height, &channels, 4);
-    if (!data) {
-        fprintf(stderr, "Failed to load image '%s': %s\n", path, stbi_failure_reason());
-        return -1;
-    }
-
-    glGenTextures(1, &state.texture);
-    glBindTexture(GL_TEXTURE_2D, state.texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, state.img_width, state.img_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
-    // Use trilinear filtering for smoother animation
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    // Calculate proper scale factor based on max workspaces and shift distance
-    // Scale factor determines how much larger the image is than the viewport
-    // We need: image_width = viewport_width * scale_factor
-    // And: (scale_factor - 1) * viewport_width >= total_shift_needed
-    int max_workspaces = 10;
-    float total_shift_needed = (max_workspaces - 1) * config.shift_per_workspace;
-
-    // Initialize state.width if not set (use default screen width)
-    if (state.width == 0) {
-        state.width = 1920;  // Default, will be updated when surface is configured
-    }
+// Estimated GPU footprint of an RGBA8 texture with a full mip chain (~4/3 of level 0)
+static size_t texture_footprint(int width, int height) {
+    return (size_t)width * (size_t)height * 4 * 4 / 3;
+}
 
-    float min_scale_factor = 1.0f + (total_shift_needed / (float)state.width);
+// Same estimate for a texture stored in `format`
+static size_t texture_format_footprint(cache_format_t format, int width, int height) {
+    return cache_level_size(format, width, height) * 4 / 3;
+}
 
-    // Use the larger of the configured scale or the minimum required
-    if (config.scale_factor < min_scale_factor) {
-        config.scale_factor = min_scale_factor;
-        if (config.debug) {
-            printf("Adjusted scale factor to %.2f to accommodate %d workspaces with %.0fpx shifts\n",
-                   config.scale_factor, max_workspaces, config.shift_per_workspace);
-        }
+static void track_texture_alloc(size_t bytes) {
+    state.texture_bytes += bytes;
+    if (state.texture_bytes > state.peak_texture_bytes) {
+        state.peak_texture_bytes = state.texture_bytes;
     }
+}
 
-    stbi_image_free(data);
+static void untrack_texture_bytes(size_t bytes) {
+    state.texture_bytes = bytes > state.texture_bytes ? 0 : state.texture_bytes - bytes;
+}
 
-    return 0;
+static void track_texture_free(size_t bytes) {
+    // A deleted texture may still be cached as bound to a batch unit or a group's source
+    state.batch_bindings_valid = 0;
+    state.layer_groups_valid = 0;
+    untrack_texture_bytes(bytes);
 }
 
-// Load image as layer for multi-layer mode
-int load_layer(struct layer *layer, const char *path, float shift_multiplier, float opacity, float blur_amount) {
-    int channels;
-    unsigned char *data = stbi_load(path, &layer->width, &layer->height, &channels, 4);
-    if (!data) {
-        fprintf(stderr, "Failed to load layer image '%s': %s\n", path, stbi_failure_reason());
-        return -1;
+// Largest configured output; shared textures are sized for it
+static void max_output_size(int *width, int *height) {
+    *width = *height = 0;
+    for (struct output *output = state.outputs; output; output = output->next) {
+        if (!output->configured) continue;
+        if (output->width > *width) *width = output->width;
+        if (output->height > *height) *height = output->height;
     }
+}
 
-    glGenTextures(1, &layer->texture);
-    glBindTexture(GL_TEXTURE_2D, layer->texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, layer->width, layer->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+// Schedule one redraw of every output, e.g. after a texture or layer change
+static void mark_outputs_dirty(void) {
+    for (struct output *output = state.outputs; output; output = output->next) {
+        output->dirty = 1;
+    }
+}
 
-    // Use trilinear filtering for smoother animation
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+// Decode request handed to the worker pool; owns its copy of the path and the pixels
+struct decode_job {
+    uint32_t load_id;
+    char *path;
+    int target_width, target_height;   // Largest useful texture size (0 = native)
+    int source_width, source_height;   // Size of the image file
+    image_t levels[CACHE_MAX_LEVELS];  // Level 0 plus mip chain
+    int level_count;
+    cache_entry_t cache;               // Backs levels when the texture cache was hit
+    cache_format_t format;             // Layout of the level data (RGBA8 or S3TC blocks)
+    dmabuf_image_t dmabuf;             // Copy of level 0 for EGLImage import (size 0 = none)
+    image_coverage_t coverage;         // Alpha coverage of level 0
+    uint64_t content_hash;             // Hash of level 0, for sharing textures
+    // Settings captured when the job is queued; the worker never reads config or state,
+    // which the main thread rewrites on reload
+    int compress;                      // S3TC-compress levels (setting on and supported)
+    int max_texture_size;              // GL_MAX_TEXTURE_SIZE
+    int dmabuf_import;                 // Stage level 0 in a dma-buf for EGLImage import
+    int use_cache;                     // Read and populate the texture cache
+    int debug;
+    int result;
+    char error[256];
+};
 
-    layer->shift_multiplier = shift_multiplier;
-    layer->opacity = opacity;
-    layer->image_path = strdup(path);
-    if (!layer->image_path) {
+// Allocate a job for path and capture the settings the worker needs
+static struct decode_job *create_decode_job(const char *path) {
+    struct decode_job *job = calloc(1, sizeof(struct decode_job));
+    if (!job || !(job->path = strdup(path))) {
         fprintf(stderr, "Error: Failed to allocate memory for image path\n");
-        stbi_image_free(data);
-        return -1;
+        free(job);
+        return NULL;
     }
-    layer->current_offset = 0.0f;
-    layer->target_offset = 0.0f;
-    layer->start_offset = 0.0f;
+    job->compress = config.compress_textures && state.s3tc_supported;
+    job->max_texture_size = state.max_texture_size;
+    job->dmabuf_import = state.dmabuf_import;
+    job->use_cache = config.texture_cache;
+    job->debug = config.debug;
+    return job;
+}
 
-    // Initialize Phase 3 fields with defaults
-    layer->easing = config.easing;  // Use global easing by default
-    layer->animation_delay = 0.0f;  // Can be overridden per layer
-    layer->animation_duration = config.animation_duration;  // Use global duration by default
-    layer->animation_start = 0.0;
-    layer->animating = 0;
-    layer->blur_amount = blur_amount;
+// Texture size for a job: the target, but never larger than the source on either axis
+static void fit_texture_size(const struct decode_job *job, int *width, int *height) {
+    *width = job->target_width > 0 && job->target_width < job->source_width ?
+             job->target_width : job->source_width;
+    *height = job->target_height > 0 && job->target_height < job->source_height ?
+              job->target_height : job->source_height;
+}
 
-    stbi_image_free(data);
+// Block format a job should end up in; tiled layers gather RGBA columns, so they never
+// compress
+static cache_format_t wanted_texture_format(const struct decode_job *job, int width) {
+    if (!job->compress) return CACHE_FORMAT_RGBA8;
+    if (width > TILE_LAYER_MIN_WIDTH || width > job->max_texture_size) return CACHE_FORMAT_RGBA8;
+    return job->coverage.opaque ? CACHE_FORMAT_BC1 : CACHE_FORMAT_BC3;
+}
 
-    if (config.debug) {
-        printf("Loaded layer: %s (%.0fx%.0f) shift=%.2f opacity=%.2f\n",
-               path, (float)layer->width, (float)layer->height, shift_multiplier, opacity);
+// Replace RGBA levels with S3TC blocks; on failure the job keeps its RGBA levels
+static int compress_job_levels(struct decode_job *job, cache_format_t format) {
+    image_t blocks[CACHE_MAX_LEVELS];
+    for (int i = 0; i < job->level_count; i++) {
+        const image_t *level = &job->levels[i];
+        blocks[i] = (image_t){ malloc(cache_level_size(format, level->width, level->height)),
+                               level->width, level->height };
+        int result = blocks[i].pixels ? (format == CACHE_FORMAT_BC1 ?
+                                         texcomp_encode_bc1(level, blocks[i].pixels) :
+                                         texcomp_encode_bc3(level, blocks[i].pixels)) : -1;
+        if (result < 0) {
+            free(blocks[i].pixels);
+            for (int j = 0; j < i; j++) free(blocks[j].pixels);
+            return -1;
+        }
     }
 
+    for (int i = 0; i < job->level_count; i++) {
+        image_free(&job->levels[i]);
+        job->levels[i] = blocks[i];
+    }
+    job->format = format;
     return 0;
 }
 
-// Sync IPC layers with OpenGL textures
-void sync_ipc_layers() {
-    if (!state.ipc_ctx) return;
+// Copy level 0 into a dma-buf while still on the worker, so the GL thread only has to wrap
+// it in a texture. Compressed and tiled layers keep the regular upload.
+static void stage_dmabuf_level(struct decode_job *job) {
+    const image_t *level = &job->levels[0];
+    if (!job->dmabuf_import || job->format != CACHE_FORMAT_RGBA8 ||
+        level->width > TILE_LAYER_MIN_WIDTH || level->width > job->max_texture_size) {
+        return;
+    }
+    if (dmabuf_image_create(&job->dmabuf, level->width, level->height) == 0) {
+        memcpy(job->dmabuf.pixels, level->pixels, (size_t)level->width * level->height * 4);
+    }
+}
 
-    // If there are no IPC layers but we have config layers, add them to IPC
-    if (state.ipc_ctx->layer_count == 0 && state.layer_count > 0) {
-        // Add existing layers to IPC context so they can be managed
-        for (int i = 0; i < state.layer_count; i++) {
-            if (state.layers[i].image_path) {
-                ipc_add_layer(state.ipc_ctx, state.layers[i].image_path,
-                             state.layers[i].shift_multiplier,
-                             state.layers[i].opacity,
-                             0.0f, 0.0f, i);
-            }
-        }
-        return;  // Don't sync back, we just populated IPC from config
+// Worker thread: map the cached mip chain, or decode, downscale, build mips, compress and
+// populate the cache. GL uploads happen on the main thread.
+static void decode_job_run(void *arg) {
+    struct decode_job *job = arg;
+    char key[CACHE_KEY_SIZE];
+    int width = 0, height = 0;
+    int have_key = 0;
+
+    // The header alone gives the final size, so a cache hit never decodes the file
+    if (job->use_cache &&
+        image_probe(job->path, &job->source_width, &job->source_height) == 0) {
+        fit_texture_size(job, &width, &height);
+        have_key = cache_make_key(job->path, width, height, key, sizeof(key)) == 0;
     }
 
-    // First, mark all current layers for potential removal
-    for (int i = 0; i < state.layer_count; i++) {
-        if (state.layers[i].image_path) {
-            state.layers[i].opacity = -1.0f; // Mark for removal
+    if (have_key && cache_load(key, &job->cache) == 0) {
+        job->coverage = job->cache.meta.coverage;
+        // An entry written with the other compression setting is rebuilt and replaced
+        if (job->cache.format == wanted_texture_format(job, width)) {
+            memcpy(job->levels, job->cache.levels, sizeof(job->levels));
+            job->level_count = job->cache.level_count;
+            job->format = job->cache.format;
+            job->content_hash = job->cache.meta.content_hash;
+            job->result = 0;
+            stage_dmabuf_level(job);
+            return;
         }
+        cache_release(&job->cache);
     }
 
-    // Process IPC layers
-    for (int i = 0; i < state.ipc_ctx->layer_count; i++) {
-        layer_t* ipc_layer = state.ipc_ctx->layers[i];
-        if (!ipc_layer || !ipc_layer->visible) continue;
-
-        // Find existing layer with same path
-        struct layer* existing = NULL;
-        for (int j = 0; j < state.layer_count; j++) {
-            if (state.layers[j].image_path &&
-                strcmp(state.layers[j].image_path, ipc_layer->image_path) == 0) {
-                existing = &state.layers[j];
-                break;
-            }
+    job->result = image_load(job->path, &job->levels[0], job->error, sizeof(job->error));
+    if (job->result < 0) return;
+    job->source_width = job->levels[0].width;
+    job->source_height = job->levels[0].height;
+
+    // Only the output-sized slice of an image is ever shown; drop the excess resolution
+    fit_texture_size(job, &width, &height);
+    if (width != job->source_width || height != job->source_height) {
+        image_t scaled;
+        if (image_resize(&job->levels[0], &scaled, width, height) == 0) {
+            image_free(&job->levels[0]);
+            job->levels[0] = scaled;
+        } else {
+            have_key = 0;  // Native size kept, don't store it under the scaled key
         }
+    }
 
-        if (existing) {
-            // Update existing layer
-            existing->opacity = ipc_layer->opacity;
-            existing->shift_multiplier = ipc_layer->scale;
-            // TODO: Apply x/y offsets when rendering
-        } else {
-            // Add new layer
-            if (state.layer_count >= state.max_layers) {
-                // Expand layer array
-                int new_max = state.max_layers * 2;
-                struct layer* new_layers = realloc(state.layers, sizeof(struct layer) * new_max);
-                if (new_layers) {
-                    state.layers = new_layers;
-                    state.max_layers = new_max;
-                    memset(&state.layers[state.layer_count], 0,
-                           sizeof(struct layer) * (new_max - state.layer_count));
-                }
-            }
+    job->level_count = image_generate_mips(job->levels, CACHE_MAX_LEVELS);
+    image_analyze_coverage(&job->levels[0], &job->coverage);
+    job->content_hash = image_content_hash(&job->levels[0]);
 
-            if (state.layer_count < state.max_layers) {
-                struct layer* new_layer = &state.layers[state.layer_count];
-                if (load_layer(new_layer, ipc_layer->image_path,
-                              ipc_layer->scale, ipc_layer->opacity, 0.0f) == 0) {
-                    new_layer->image_path = strdup(ipc_layer->image_path);
-                    state.layer_count++;
-                }
-            }
-        }
+    cache_format_t format = wanted_texture_format(job, job->levels[0].width);
+    if (format != CACHE_FORMAT_RGBA8 && compress_job_levels(job, format) < 0) {
+        fprintf(stderr, "Warning: Failed to compress '%s', uploading it uncompressed\n", job->path);
     }
 
-    // Remove layers that are no longer in IPC
-    int write_idx = 0;
-    for (int read_idx = 0; read_idx < state.layer_count; read_idx++) {
-        if (state.layers[read_idx].opacity >= 0.0f) {
-            // Keep this layer
-            if (write_idx != read_idx) {
-                state.layers[write_idx] = state.layers[read_idx];
-            }
-            write_idx++;
-        } else {
-            // Remove this layer
-            if (state.layers[read_idx].texture) {
-                glDeleteTextures(1, &state.layers[read_idx].texture);
+    cache_meta_t meta = { job->coverage, job->content_hash };
+    if (have_key && cache_store(key, job->format, job->levels, job->level_count, &meta) < 0 &&
+        job->debug) {
+        fprintf(stderr, "Warning: Failed to write texture cache for '%s'\n", job->path);
+    }
+    stage_dmabuf_level(job);
+}
+
+// Texture size the largest output can use: its height, and its width times the panning room
+static void output_texture_size(int *width, int *height) {
+    int output_width, output_height;
+    max_output_size(&output_width, &output_height);
+    if (output_width <= 0 || output_height <= 0) {
+        *width = *height = 0;  // Unknown yet, keep native resolution
+        return;
+    }
+    *width = (int)ceilf(output_width * config.scale_factor);
+    *height = output_height;
+}
+
+static void decode_job_free(struct decode_job *job) {
+    if (job->cache.map) {
+        cache_release(&job->cache);
+    } else {
+        for (int i = 0; i < job->level_count; i++) {
+            image_free(&job->levels[i]);
+        }
+    }
+    dmabuf_image_destroy(&job->dmabuf);
+    free(job->path);
+    free(job);
+}
+
+// Wrap a worker-filled dma-buf in a texture that samples its pages in place. Returns 0 if
+// the driver rejects the buffer; import is then turned off and layers are copied instead.
+static GLuint import_dmabuf_texture(const dmabuf_image_t *image) {
+    EGLint attribs[] = {
+        EGL_WIDTH, image->width,
+        EGL_HEIGHT, image->height,
+        EGL_LINUX_DRM_FOURCC_EXT, DMABUF_FOURCC_ABGR8888,
+        EGL_DMA_BUF_PLANE0_FD_EXT, image->fd,
+        EGL_DMA_BUF_PLANE0_OFFSET_EXT, 0,
+        EGL_DMA_BUF_PLANE0_PITCH_EXT, image->stride,
+        EGL_NONE
+    };
+    EGLImageKHR egl_image = state.create_image(state.egl_display, EGL_NO_CONTEXT,
+                                               EGL_LINUX_DMA_BUF_EXT, NULL, attribs);
+    if (egl_image == EGL_NO_IMAGE_KHR) {
+        fprintf(stderr, "Warning: dma-buf import failed (0x%x), layers are copied on upload\n",
+                eglGetError());
+        state.dmabuf_import = 0;
+        return 0;
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    while (glGetError() != GL_NO_ERROR) {}
+    state.image_target_texture(GL_TEXTURE_2D, (GLeglImageOES)egl_image);
+    GLenum error = glGetError();
+    // The texture holds its own reference to the buffer
+    state.destroy_image(state.egl_display, egl_image);
+    if (error != GL_NO_ERROR) {
+        fprintf(stderr, "Warning: EGLImage texture failed (0x%x), layers are copied on upload\n",
+                error);
+        glDeleteTextures(1, &texture);
+        state.dmabuf_import = 0;
+        return 0;
+    }
+
+    // Imported storage has no mip chain; layers are sized to be shown at about 1:1
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    track_texture_alloc((size_t)image->width * image->height * 4);
+    return texture;
+}
+
+// GPU bytes a layer's own texture was tracked with
+static size_t layer_texture_bytes(const struct layer *layer) {
+    if (layer->imported) return (size_t)layer->width * layer->height * 4;
+    return texture_format_footprint(layer->format, layer->width, layer->height);
+}
+
+// Upload levels [first, count) of a chain into the bound texture
+static void upload_levels(cache_format_t format, const image_t *levels, int first, int count) {
+    GLenum internal_format = format == CACHE_FORMAT_BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT :
+                             GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    for (int i = first; i < count; i++) {
+        if (format == CACHE_FORMAT_RGBA8) {
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, levels[i].width, levels[i].height, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, levels[i].pixels);
+        } else {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, internal_format,
+                                   levels[i].width, levels[i].height, 0,
+                                   cache_level_size(format, levels[i].width, levels[i].height),
+                                   levels[i].pixels);
+        }
+    }
+}
+
+// Upload a decoded mip chain; a lone RGBA level 0 gets GPU-generated mipmaps instead.
+// Compressed chains always carry every level, since S3TC can't be mipmapped on the GPU.
+// With defer_mips only level 0 goes up, sampled without mipmaps until finish_layer_mips.
+static GLuint upload_texture_levels(cache_format_t format, const image_t *levels, int level_count,
+                                    int defer_mips) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    upload_levels(format, levels, 0, defer_mips ? 1 : level_count);
+    if (!defer_mips && level_count == 1 && format == CACHE_FORMAT_RGBA8) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    track_texture_alloc(texture_format_footprint(format, levels[0].width, levels[0].height));
+
+    // Use trilinear filtering for smoother animation
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    defer_mips ? GL_LINEAR : GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+// Load image as texture with mipmaps
+int load_image(const char *path) {
+    // Calculate proper scale factor based on max workspaces and shift distance
+    // Scale factor determines how much larger the image is than the viewport
+    // We need: image_width = viewport_width * scale_factor
+    // And: (scale_factor - 1) * viewport_width >= total_shift_needed
+    int max_workspaces = 10;
+    float total_shift_needed = (max_workspaces - 1) * config.shift_per_workspace;
+
+    // Use the widest output, or a default screen width before any is configured
+    int screen_width, screen_height;
+    max_output_size(&screen_width, &screen_height);
+    if (screen_width == 0) {
+        screen_width = 1920;
+    }
+
+    float min_scale_factor = 1.0f + (total_shift_needed / (float)screen_width);
+
+    // Use the larger of the configured scale or the minimum required
+    if (config.scale_factor < min_scale_factor) {
+        config.scale_factor = min_scale_factor;
+        if (config.debug) {
+            printf("Adjusted scale factor to %.2f to accommodate %d workspaces with %.0fpx shifts\n",
+                   config.scale_factor, max_workspaces, config.shift_per_workspace);
+        }
+    }
+
+    struct decode_job *job = create_decode_job(path);
+    if (!job) return -1;
+
+    // Sized after the scale factor is final, since it sets the texture width
+    output_texture_size(&job->target_width, &job->target_height);
+    decode_job_run(job);
+    if (job->result < 0) {
+        fprintf(stderr, "Failed to load image '%s': %s\n", path, job->error);
+        decode_job_free(job);
+        return -1;
+    }
+    state.img_width = job->levels[0].width;
+    state.img_height = job->levels[0].height;
+    state.texture = job->dmabuf.size && state.dmabuf_import ?
+                    import_dmabuf_texture(&job->dmabuf) : 0;
+    if (!state.texture) {
+        state.texture = upload_texture_levels(job->format, job->levels, job->level_count, 0);
+    }
+
+    decode_job_free(job);
+
+    return 0;
+}
+
+// Layers can be reordered or removed while a decode is in flight, so look them up by id
+static struct layer *find_layer_by_load_id(uint32_t load_id) {
+    for (int i = 0; i < state.layer_count; i++) {
+        if (state.layers[i].load_id == load_id) {
+            return &state.layers[i];
+        }
+    }
+    return NULL;
+}
+
+// Another layer holding the same texture name, if any
+static struct layer *find_texture_sharer(const struct layer *layer) {
+    for (int i = 0; layer->texture && i < state.layer_count; i++) {
+        if (&state.layers[i] != layer && state.layers[i].texture == layer->texture) {
+            return &state.layers[i];
+        }
+    }
+    return NULL;
+}
+
+// Drop a layer's reference to its texture, deleting it unless another layer shares it
+static void release_layer_texture(struct layer *layer) {
+    if (!layer->texture) return;
+
+    struct layer *sharer = find_texture_sharer(layer);
+    if (!sharer) {
+        glDeleteTextures(1, &layer->texture);
+        track_texture_free(layer_texture_bytes(layer));
+    }
+
+    // Mipmaps still to come belong to the texture; whoever keeps it finishes them
+    if (layer->mips_pending && sharer) {
+        sharer->mips_pending = 1;
+        sharer->mip_source = layer->mip_source;
+    } else if (layer->mip_source) {
+        decode_job_free(layer->mip_source);
+    }
+    layer->mips_pending = 0;
+    layer->mip_source = NULL;
+    layer->texture = 0;
+    layer->imported = 0;
+}
+
+// Another layer already showing exactly these pixels, if any
+static struct layer *find_layer_by_content(const struct layer *layer, uint64_t content_hash,
+                                           int width, int height, cache_format_t format) {
+    for (int i = 0; i < state.layer_count; i++) {
+        struct layer *other = &state.layers[i];
+        if (other != layer && other->texture && other->content_hash == content_hash &&
+            other->width == width && other->height == height && other->format == format) {
+            return other;
+        }
+    }
+    return NULL;
+}
+
+// Width in pixels of one column tile; the last one may be narrower
+static int layer_tile_width(const struct layer *layer, int tile) {
+    int remaining = layer->width - tile * TILE_WIDTH;
+    return remaining < TILE_WIDTH ? remaining : TILE_WIDTH;
+}
+
+static void evict_layer_tile(struct layer *layer, int tile) {
+    GLuint *texture = &layer->tiles->textures[tile];
+    if (!*texture) return;
+
+    glDeleteTextures(1, texture);
+    *texture = 0;
+    // Tiles never feed a group cache, but a batch unit may still hold the name
+    state.batch_bindings_valid = 0;
+    untrack_texture_bytes(texture_footprint(layer_tile_width(layer, tile), layer->height));
+}
+
+static void release_layer_tiles(struct layer *layer) {
+    if (!layer->tiles) return;
+
+    for (int i = 0; i < layer->tiles->count; i++) {
+        evict_layer_tile(layer, i);
+    }
+    decode_job_free(layer->tiles->source);
+    free(layer->tiles->textures);
+    free(layer->tiles);
+    layer->tiles = NULL;
+}
+
+// Keep a decoded image on the CPU for tiled uploads; takes ownership of the job
+static struct layer_tiles *create_layer_tiles(struct decode_job *job) {
+    struct layer_tiles *tiles = calloc(1, sizeof(struct layer_tiles));
+    int count = (job->levels[0].width + TILE_WIDTH - 1) / TILE_WIDTH;
+    if (!tiles || !(tiles->textures = calloc(count, sizeof(GLuint)))) {
+        free(tiles);
+        return NULL;
+    }
+    tiles->count = count;
+
+    // Tiles build their own mipmaps; a decoded (unmapped) chain is dead weight
+    if (!job->cache.map) {
+        for (int i = 1; i < job->level_count; i++) {
+            image_free(&job->levels[i]);
+        }
+        job->level_count = 1;
+    }
+    tiles->source = job;
+    return tiles;
+}
+
+// Upload decoded pixels into a layer's texture; first loads fade in, reloads swap in place.
+// Returns 1 if the layer kept the job (a tiled layer reads its pixels later, and deferred
+// mipmaps are uploaded from it).
+static int upload_layer_texture(struct layer *layer, struct decode_job *job) {
+    int first_load = layer->texture == 0 && !layer->tiles;
+    release_layer_texture(layer);
+    release_layer_tiles(layer);
+    layer->width = job->levels[0].width;
+    layer->height = job->levels[0].height;
+    layer->source_width = job->source_width;
+    layer->source_height = job->source_height;
+    layer->coverage = job->coverage;
+    layer->content_hash = job->content_hash;
+    layer->format = job->format;
+
+    // Panoramas too wide for one texture are uploaded in tiles as outputs pan over them
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    struct layer *twin = NULL;
+    if (layer->width > TILE_LAYER_MIN_WIDTH || layer->width > max_size) {
+        layer->tiles = create_layer_tiles(job);
+        if (!layer->tiles) {
+            fprintf(stderr, "Error: Failed to allocate tiles for layer '%s'\n", layer->image_path);
+            return 0;
+        }
+    } else {
+        // Identical images (even from different paths) are uploaded once
+        twin = find_layer_by_content(layer, job->content_hash, layer->width, layer->height,
+                                     job->format);
+        if (twin) {
+            layer->texture = twin->texture;
+            layer->imported = twin->imported;
+        } else {
+            // Jobs staged before a failed import turned it off are copied as well
+            layer->texture = job->dmabuf.size && state.dmabuf_import ?
+                             import_dmabuf_texture(&job->dmabuf) : 0;
+            layer->imported = layer->texture != 0;
+            if (!layer->texture) {
+                layer->texture = upload_texture_levels(job->format, job->levels, job->level_count,
+                                                       config.deferred_mips);
+                layer->mips_pending = config.deferred_mips;
             }
-            if (state.layers[read_idx].image_path) {
-                free(state.layers[read_idx].image_path);
+        }
+    }
+
+    // Level 0 is on the GPU; a decoded (unmapped) chain only needs the rest until then
+    if (layer->mips_pending && job->level_count > 1) {
+        if (!job->cache.map) image_free(&job->levels[0]);
+        layer->mip_source = job;
+    }
+
+    layer->blur_cached_amount = -1.0f;  // New texture, cached blur (if any) is stale
+
+    // The benchmark measures steady-state frames, so layers appear immediately there.
+    // Scene layers wait for the scene crossfade instead
+    if (first_load && !config.bench && layer->scene != SCENE_INCOMING) {
+        layer->fade_start = get_time();
+    }
+    mark_outputs_dirty();
+
+    if (config.debug) {
+        char tiled[32] = "";
+        if (layer->tiles) {
+            snprintf(tiled, sizeof(tiled), ", %d tiles", layer->tiles->count);
+        }
+        printf("Loaded layer: %s (%dx%d from %dx%d, %d levels%s%s%s%s%s%s) shift=%.2f opacity=%.2f\n",
+               layer->image_path, layer->width, layer->height,
+               layer->source_width, layer->source_height,
+               job->level_count, job->cache.map ? ", cached" : "",
+               layer->mips_pending ? ", mips deferred" : "",
+               layer->format == CACHE_FORMAT_BC1 ? ", bc1" :
+               layer->format == CACHE_FORMAT_BC3 ? ", bc3" :
+               layer->imported ? ", dma-buf" : "",
+               layer->coverage.opaque ? ", opaque" : "",
+               twin ? ", shared texture" : "", tiled,
+               layer->shift_multiplier, layer->opacity);
+    }
+    return layer->tiles != NULL || layer->mip_source == job;
+}
+
+// Complete a texture uploaded with only level 0: the rest of the chain from the decode
+// (normally memory-mapped from the texture cache), or generated on the GPU
+static void finish_layer_mips(struct layer *layer) {
+    struct decode_job *job = layer->mip_source;
+    glBindTexture(GL_TEXTURE_2D, layer->texture);
+    if (job) {
+        upload_levels(job->format, job->levels, 1, job->level_count);
+    } else if (layer->format == CACHE_FORMAT_RGBA8) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    if (job || layer->format == CACHE_FORMAT_RGBA8) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+
+    if (job) decode_job_free(job);
+    layer->mip_source = NULL;
+    layer->mips_pending = 0;
+    mark_outputs_dirty();
+
+    if (config.debug) {
+        printf("Uploaded deferred mipmaps of %s\n", layer->image_path);
+    }
+}
+
+// Between animations, finish one layer's deferred mipmaps. Returns 1 if more are waiting,
+// so the main loop comes back for them without blocking.
+static int upload_deferred_mips(void) {
+    if (state.scene_fade_start > 0.0) return 0;
+    for (struct output *output = state.outputs; output; output = output->next) {
+        if (output->animating) return 0;  // The frame after it ends brings us back
+    }
+
+    struct layer *next = NULL;
+    int waiting = 0;
+    for (int i = 0; i < state.layer_count && !waiting; i++) {
+        if (!state.layers[i].mips_pending) continue;
+        if (next) waiting = 1;
+        else next = &state.layers[i];
+    }
+    if (next) finish_layer_mips(next);
+    return waiting;
+}
+
+// Forward declarations
+static void enforce_texture_budget(void);
+static void finish_scene_switch(void);
+
+// Main thread: called from pool_dispatch() when a decode finishes
+static void decode_job_done(void *arg, int cancelled) {
+    struct decode_job *job = arg;
+    struct layer *layer = find_layer_by_load_id(job->load_id);
+
+    if (layer) {
+        layer->load_id = 0;
+    }
+
+    if (!cancelled) {
+        if (job->result < 0) {
+            fprintf(stderr, "Failed to load layer image '%s': %s\n", job->path, job->error);
+        } else if (layer) {
+            layer->last_drawn = get_time();  // Give it a frame before it can be evicted
+            layer->evicted = 0;
+            int kept = upload_layer_texture(layer, job);
+            enforce_texture_budget();
+            if (kept) return;  // Tiled or mips deferred: the layer owns the job now
+        } else if (config.debug) {
+            printf("Discarding decoded image for removed layer: %s\n", job->path);
+        }
+    }
+
+    decode_job_free(job);
+}
+
+// Block until every queued layer decode has been uploaded
+static void wait_for_layer_decodes(void) {
+    while (pool_pending(state.decode_pool) > 0) {
+        struct pollfd pfd = { .fd = pool_get_fd(state.decode_pool), .events = POLLIN };
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+            perror("poll");
+            return;
+        }
+        pool_dispatch(state.decode_pool);
+    }
+}
+
+// Queue a background decode of layer->image_path sized for the current output
+static int queue_layer_decode(struct layer *layer) {
+    struct decode_job *job = create_decode_job(layer->image_path);
+    if (!job) return -1;
+    output_texture_size(&job->target_width, &job->target_height);
+
+    if (++state.next_load_id == 0) state.next_load_id = 1;  // 0 means "nothing pending"
+    layer->load_id = state.next_load_id;
+    job->load_id = layer->load_id;
+
+    // Without a pool (thread creation failed) fall back to decoding inline
+    if (!state.decode_pool ||
+        pool_submit(state.decode_pool, decode_job_run, decode_job_done, job) < 0) {
+        decode_job_run(job);
+        decode_job_done(job, 0);
+    } else if (config.debug) {
+        printf("Queued decode for layer: %s (target %dx%d)\n",
+               layer->image_path, job->target_width, job->target_height);
+    }
+
+    return 0;
+}
+
+// Re-decode layers that were downscaled for a smaller output than the current one.
+// Shrinking outputs keep their textures; sampling handles the excess.
+void reload_undersized_layers() {
+    int width, height;
+    output_texture_size(&width, &height);
+    if (width == 0) return;
+
+    for (int i = 0; i < state.layer_count; i++) {
+        struct layer *layer = &state.layers[i];
+        if ((!layer->texture && !layer->tiles) || layer->load_id) continue;
+
+        int narrow = width > layer->width && layer->width < layer->source_width;
+        int short_ = height > layer->height && layer->height < layer->source_height;
+        if (narrow || short_) {
+            if (config.debug) {
+                printf("Output grew past %dx%d, reloading layer: %s\n",
+                       layer->width, layer->height, layer->image_path);
             }
+            queue_layer_decode(layer);
+        }
+    }
+}
+
+// Load image as layer for multi-layer mode. The image is decoded in the background;
+// the layer is skipped while rendering until its texture arrives, then fades in.
+int load_layer(struct layer *layer, const char *path, float shift_multiplier, float opacity, float blur_amount) {
+    // Catch missing or unreadable files up front, before the layer slot is touched
+    if (access(path, R_OK) != 0) {
+        fprintf(stderr, "Failed to load layer image '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    char *image_path = strdup(path);
+    if (!image_path) {
+        fprintf(stderr, "Error: Failed to allocate memory for image path\n");
+        return -1;
+    }
+
+    // path may alias layer->image_path when reloading configured layers
+    free(layer->image_path);
+    layer->image_path = image_path;
+
+    // Any existing texture stays on screen until the new one is uploaded
+    layer->shift_multiplier = shift_multiplier;
+    layer->opacity = opacity;
+
+    // Initialize Phase 3 fields with defaults
+    layer->easing = config.easing;  // Use global easing by default
+    layer->animation_delay = 0.0f;  // Can be overridden per layer
+    layer->animation_duration = config.animation_duration;  // Use global duration by default
+    layer->blur_amount = blur_amount;
+    layer->fade_start = 0.0;
+
+    return queue_layer_decode(layer);
+}
+
+// Check whether a layer's cached blur texture matches its current inputs. One cache
+// serves every output, so it is built for the largest one.
+static int layer_blur_is_current(const struct layer *layer) {
+    int width, height;
+    max_output_size(&width, &height);
+    return layer->blur_texture &&
+           layer->blur_cached_amount == layer->blur_amount &&
+           layer->blur_cached_output_width == width &&
+           layer->blur_cached_output_height == height &&
+           layer->blur_cached_downscale == config.blur_downscale;
+}
+
+// Release a layer's cached blur texture
+static void release_layer_blur(struct layer *layer) {
+    if (layer->blur_texture) {
+        glDeleteTextures(1, &layer->blur_texture);
+        track_texture_free((size_t)layer->blur_width * layer->blur_height * 4);
+        layer->blur_texture = 0;
+    }
+    layer->blur_width = layer->blur_height = 0;
+}
+
+// Create an empty RGBA texture usable as a render target (blur passes, group caches)
+static GLuint create_render_target(int width, int height) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+// Attach target to blur_fbo and draw into all of it
+static int bind_render_target(GLuint target, int width, int height) {
+    glBindFramebuffer(GL_FRAMEBUFFER, state.blur_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Error: Offscreen framebuffer incomplete (%dx%d)\n", width, height);
+        return -1;
+    }
+
+    glViewport(0, 0, width, height);
+    return 0;
+}
+
+// Draw source over the bound render target with a program built on vertex_shader_src.
+// Texcoords are unflipped, so the result keeps the source orientation.
+static void draw_render_target_quad(GLuint program, GLuint source) {
+    float vertices[] = {
+        -1.0f, -1.0f,  0.0f, 0.0f,
+         1.0f, -1.0f,  1.0f, 0.0f,
+         1.0f,  1.0f,  1.0f, 1.0f,
+        -1.0f,  1.0f,  0.0f, 1.0f,
+    };
+    GLint pos_attrib = glGetAttribLocation(program, "position");
+    GLint tex_attrib = glGetAttribLocation(program, "texcoord");
+
+    glBindBuffer(GL_ARRAY_BUFFER, state.vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(pos_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(pos_attrib);
+    glVertexAttribPointer(tex_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(tex_attrib);
+
+    glBindTexture(GL_TEXTURE_2D, source);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state.ebo);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+}
+
+// Run one separable blur pass from source into the texture attached to blur_fbo
+static int run_blur_pass(GLuint source, GLuint target, int width, int height,
+                         float step_u, float step_v) {
+    if (bind_render_target(target, width, height) < 0) return -1;
+
+    glUniform1i(state.blur_u_texture, 0);
+    glUniform2f(state.blur_u_step, step_u, step_v);
+    draw_render_target_quad(state.blur_shader_program, source);
+    return 0;
+}
+
+// Render a layer's blurred texture once with a horizontal and a vertical Gaussian pass
+// at a downscaled resolution; the per-frame path then samples it like any other texture
+int build_layer_blur(struct layer *layer) {
+    int output_width, output_height;
+    max_output_size(&output_width, &output_height);
+    if (!layer->texture || output_width <= 0 || output_height <= 0 || !state.blur_shader_program) {
+        return -1;
+    }
+
+    // Only the viewport-sized slice of a layer is ever visible, so size the cache from the
+    // output (times the panning room) rather than from the source image
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    int width = (int)(output_width * config.scale_factor * config.blur_downscale);
+    int height = (int)(output_height * config.blur_downscale);
+    if (width > layer->width) width = layer->width;
+    if (height > layer->height) height = layer->height;
+    if (max_size > 0 && width > max_size) width = max_size;
+    if (max_size > 0 && height > max_size) height = max_size;
+    if (width < 1) width = 1;
+    if (height < 1) height = 1;
+
+    if (!state.blur_temp_texture || state.blur_temp_width != width || state.blur_temp_height != height) {
+        if (state.blur_temp_texture) {
+            glDeleteTextures(1, &state.blur_temp_texture);
+            track_texture_free((size_t)state.blur_temp_width * state.blur_temp_height * 4);
         }
+        state.blur_temp_texture = create_render_target(width, height);
+        state.blur_temp_width = width;
+        state.blur_temp_height = height;
+        track_texture_alloc((size_t)width * height * 4);
+    }
+
+    if (!layer->blur_texture || layer->blur_width != width || layer->blur_height != height) {
+        release_layer_blur(layer);
+        layer->blur_texture = create_render_target(width, height);
+        layer->blur_width = width;
+        layer->blur_height = height;
+        track_texture_alloc((size_t)width * height * 4);
+    }
+
+    // Radius in UV units matches the previous single-pass shader (screen texels * blur)
+    float radius_u = BLUR_RADIUS_SCALE * layer->blur_amount / (output_width * config.scale_factor);
+    float radius_v = BLUR_RADIUS_SCALE * layer->blur_amount / (float)output_height;
+
+    glDisable(GL_BLEND);
+    glUseProgram(state.blur_shader_program);
+
+    int result = run_blur_pass(layer->texture, state.blur_temp_texture, width, height,
+                               radius_u / BLUR_TAPS, 0.0f);
+    if (result == 0) {
+        result = run_blur_pass(state.blur_temp_texture, layer->blur_texture, width, height,
+                               0.0f, radius_v / BLUR_TAPS);
+    }
+
+    // Restore default framebuffer state; the compositing pass sets its own viewport
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glUseProgram(state.shader_program);
+
+    if (result < 0) {
+        release_layer_blur(layer);
+        return -1;
     }
-    state.layer_count = write_idx;
 
-    // Sort layers by z-index (using shift_multiplier as z-index for now)
-    // TODO: Add proper z-index field to struct layer
+    layer->blur_cached_amount = layer->blur_amount;
+    layer->blur_extent_u = radius_u;
+    layer->blur_extent_v = radius_v;
+    layer->blur_cached_output_width = output_width;
+    layer->blur_cached_output_height = output_height;
+    layer->blur_cached_downscale = config.blur_downscale;
+
+    if (config.debug) {
+        fprintf(stderr, "Built cached blur for %s: %dx%d, amount %.2f\n",
+                layer->image_path ? layer->image_path : "(layer)", width, height, layer->blur_amount);
+    }
+    return 0;
 }
 
 // Add a layer to the state
@@ -681,200 +1800,1403 @@ int add_layer(const char *path, float shift_multiplier, float opacity) {
     return -1;
 }
 
-// Forward declaration
-void render_frame();
-
-// Frame callback for smooth animation
-static void frame_done(void *data, struct wl_callback *callback, uint32_t time) {
-    (void)data;
-    (void)time;
-    if (callback) wl_callback_destroy(callback);
-    state.frame_callback = NULL;
-
-    // Render the next frame
-    render_frame();
+// Remember which GL layer shows an IPC layer
+static void bind_ipc_layer(int slot, uint32_t ipc_id) {
+    state.layers[slot].ipc_id = ipc_id;
+    if (ipc_id && idmap_put(&state.ipc_slots, ipc_id, slot) < 0) {
+        fprintf(stderr, "Warning: Failed to index IPC layer %u\n", ipc_id);
+    }
 }
 
-static const struct wl_callback_listener frame_listener = {
-    .done = frame_done
-};
-
-// Render frame with optimizations
-void render_frame() {
-    // Don't render if OpenGL isn't initialized yet
-    if (state.shader_program == 0) {
-        return;
+// Free a GL layer and close the gap; layers above it move down one slot
+static void remove_layer_at(int slot) {
+    struct layer *layer = &state.layers[slot];
+    if (layer->ipc_id) idmap_remove(&state.ipc_slots, layer->ipc_id);
+
+    release_layer_texture(layer);
+    release_layer_tiles(layer);
+    release_layer_blur(layer);
+    free(layer->image_path);
+
+    state.layer_count--;
+    memmove(&state.layers[slot], &state.layers[slot + 1],
+            sizeof(struct layer) * (state.layer_count - slot));
+    memset(&state.layers[state.layer_count], 0, sizeof(struct layer));
+    for (int i = slot; i < state.layer_count; i++) {
+        if (state.layers[i].ipc_id) idmap_put(&state.ipc_slots, state.layers[i].ipc_id, i);
     }
-    double current_time = get_time();
+    for (struct output *output = state.outputs; output; output = output->next) {
+        anim_table_remove(&output->anims, slot);
+    }
+}
 
-    // Update animation for all layers
-    if (config.multi_layer_mode) {
-        // Per-layer animation with individual timing
-        int any_animating = 0;
+// Move a GL layer from one slot to another, shifting the layers in between, and keep the
+// id map and every output's animation rows in step
+static int move_layer(int slot, int target) {
+    if (slot == target) return 0;
+    int *from = malloc(sizeof(int) * state.layer_count);
+    if (!from) return -1;
+    for (int i = 0; i < state.layer_count; i++) {
+        from[i] = i;
+    }
+    int step = target > slot ? 1 : -1;
+    from[target] = slot;
+    for (int i = slot; i != target; i += step) {
+        from[i] = i + step;
+    }
+
+    struct layer moved = state.layers[slot];
+    if (target > slot) {
+        memmove(&state.layers[slot], &state.layers[slot + 1], sizeof(struct layer) * (target - slot));
+    } else {
+        memmove(&state.layers[target + 1], &state.layers[target], sizeof(struct layer) * (slot - target));
+    }
+    state.layers[target] = moved;
+
+    int low = slot < target ? slot : target;
+    int high = slot < target ? target : slot;
+    for (int i = low; i <= high; i++) {
+        if (state.layers[i].ipc_id) idmap_put(&state.ipc_slots, state.layers[i].ipc_id, i);
+    }
+    for (struct output *output = state.outputs; output; output = output->next) {
+        if (anim_table_remap(&output->anims, from, state.layer_count) < 0) {
+            fprintf(stderr, "Error: Failed to reorder animation state\n");
+        }
+    }
+    free(from);
+    state.layer_groups_valid = 0;
+    return 0;
+}
+
+// Slot the GL layer at `slot` belongs in by IPC z order: just below the first other IPC
+// layer above it, else just above the last one below it. Layers with the same z keep their
+// order, and layers hyprlax-ctl doesn't know about (an incoming scene) don't constrain it.
+static int ipc_layer_target(int slot) {
+    layer_t *ipc_layer = ipc_find_layer(state.ipc_ctx, state.layers[slot].ipc_id);
+    if (!ipc_layer) return slot;
+    int below = -1;
+    for (int i = 0; i < state.layer_count; i++) {
+        if (i == slot || !state.layers[i].ipc_id) continue;
+        layer_t *other = ipc_find_layer(state.ipc_ctx, state.layers[i].ipc_id);
+        if (!other) continue;
+        if (other->z_index > ipc_layer->z_index || (other->z_index == ipc_layer->z_index && i > slot)) {
+            return i < slot ? i : i - 1;
+        }
+        below = i;
+    }
+    if (below < 0) return slot;
+    return below < slot ? below + 1 : below;
+}
+
+// Bring the GL layer for one IPC id in line with the IPC layer's current state. Layers
+// that are gone or hidden are dropped, new or re-shown ones are loaded at their z slot.
+// Returns true if the composited frame changed; layers still decoding schedule their own
+// redraw.
+static bool apply_ipc_layer(uint32_t ipc_id, void *data) {
+    (void)data;
+    layer_t *ipc_layer = ipc_find_layer(state.ipc_ctx, ipc_id);
+    int slot = -1;
+    idmap_get(&state.ipc_slots, ipc_id, &slot);
+
+    if (!ipc_layer || !ipc_layer->visible) {
+        if (slot < 0) return false;
+        remove_layer_at(slot);
+        return true;
+    }
+
+    if (slot < 0) {
+        if (add_layer(ipc_layer->image_path, ipc_layer->scale, ipc_layer->opacity) < 0) return false;
+        slot = state.layer_count - 1;
+        bind_ipc_layer(slot, ipc_id);
+        move_layer(slot, ipc_layer_target(slot));
+        return false;
+    }
+
+    // A changed z moves the layer among the others
+    int target = ipc_layer_target(slot);
+    bool changed = target != slot && move_layer(slot, target) == 0;
+    if (changed) slot = target;
+
+    struct layer *layer = &state.layers[slot];
+    changed |= layer->opacity != ipc_layer->opacity;
+    layer->opacity = ipc_layer->opacity;
+    layer->shift_multiplier = ipc_layer->scale;  // Takes effect with the next workspace change
+    // TODO: Apply x/y offsets when rendering
+    return changed;
+}
+
+// After the change journal overflowed: free the GL layers whose IPC layer is gone
+static bool prune_ipc_layers(void *data) {
+    (void)data;
+    if (config.debug) {
+        printf("IPC change journal overflowed, resyncing all layers\n");
+    }
+    bool changed = false;
+    for (int i = state.layer_count - 1; i >= 0; i--) {
+        if (state.layers[i].ipc_id && !ipc_find_layer(state.ipc_ctx, state.layers[i].ipc_id)) {
+            remove_layer_at(i);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Sync the GL layers with what hyprlax-ctl changed since the last call, touching only
+// the journaled layers. Returns 1 if the composited frame changed.
+int sync_ipc_layers() {
+    if (!state.ipc_ctx) return 0;
+    const ipc_sync_ops_t ops = { .apply = apply_ipc_layer, .prune = prune_ipc_layers };
+    return ipc_sync_layers(state.ipc_ctx, &ops);
+}
+
+// Forward declaration
+int render_frame(struct output *output);
+
+static void request_output_frame(struct output *output);
+
+// Frame callback for smooth animation
+static void frame_done(void *data, struct wl_callback *callback, uint32_t time) {
+    struct output *output = data;
+    (void)time;
+    if (callback) wl_callback_destroy(callback);
+    output->frame_callback = NULL;
+
+    // Measure callback-to-callback gap while frames are being paced
+    double now = get_time();
+    if (output->last_frame_done > 0.0) {
+        stats_record_interval(&state.stats, (now - output->last_frame_done) * 1000.0);
+    }
+    output->last_frame_done = now;
+
+    // --fps is only a cap: a callback arriving early waits for the next refresh
+    int fps = frame_rate_cap();
+    if (fps > 0) {
+        double min_interval = 1.0 / fps;
+        double slack = output->refresh_period > 0.0 ? output->refresh_period / 2.0 : min_interval / 4.0;
+        if (now - output->last_frame_time < min_interval - slack) {
+            request_output_frame(output);
+            wl_surface_commit(output->surface);
+            return;
+        }
+    }
+
+    // Render the next frame
+    render_frame(output);
+}
+
+static const struct wl_callback_listener frame_listener = {
+    .done = frame_done
+};
+
+// Ask for a frame callback with the output's next commit (no surface in benchmark mode)
+static void request_output_frame(struct output *output) {
+    if (output->surface && !output->frame_callback) {
+        output->frame_callback = wl_surface_frame(output->surface);
+        wl_callback_add_listener(output->frame_callback, &frame_listener, output);
+    }
+}
+
+static void feedback_sync_output(void *data, struct wp_presentation_feedback *feedback,
+                                 struct wl_output *wl_output) {
+    (void)data;
+    (void)feedback;
+    (void)wl_output;
+}
+
+static void feedback_presented(void *data, struct wp_presentation_feedback *feedback,
+                               uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec,
+                               uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags) {
+    (void)seq_hi;
+    (void)seq_lo;
+    (void)flags;
+    struct output *output = data;
+    wp_presentation_feedback_destroy(feedback);
+    output->feedback = NULL;
+
+    // Timestamps are only comparable with get_time() on the monotonic clock
+    if (state.presentation_clock == CLOCK_MONOTONIC) {
+        uint64_t seconds = ((uint64_t)tv_sec_hi << 32) | tv_sec_lo;
+        output->last_presented = seconds + tv_nsec / 1000000000.0;
+    }
+    if (refresh > 0) {
+        output->refresh_period = refresh / 1000000000.0;
+    }
+}
+
+static void feedback_discarded(void *data, struct wp_presentation_feedback *feedback) {
+    struct output *output = data;
+    wp_presentation_feedback_destroy(feedback);
+    output->feedback = NULL;
+}
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+    .sync_output = feedback_sync_output,
+    .presented = feedback_presented,
+    .discarded = feedback_discarded,
+};
+
+// Ask when the output's next commit reaches the screen; only the latest frame matters
+static void request_presentation_feedback(struct output *output) {
+    if (!state.presentation || !output->surface) return;
+    if (output->feedback) {
+        wp_presentation_feedback_destroy(output->feedback);
+    }
+    output->feedback = wp_presentation_feedback(state.presentation, output->surface);
+    wp_presentation_feedback_add_listener(output->feedback, &feedback_listener, output);
+}
+
+// When a frame drawn now should be on screen: the first refresh after now, extrapolated
+// from the last presentation; without timing information, now
+static double predict_presentation_time(const struct output *output, double now) {
+    double period = output->refresh_period;
+    if (period <= 0.0) {
+        return now;
+    }
+    if (output->last_presented <= 0.0 || output->last_presented > now) {
+        return now + period;
+    }
+    double refreshes = floor((now - output->last_presented) / period) + 1.0;
+    return output->last_presented + refreshes * period;
+}
+
+// Swap an output's buffer, telling the compositor which part of it changed
+static void swap_output_buffers(struct output *output) {
+    // Every layer is a full-screen quad, so a moved or faded layer repaints the whole buffer
+    EGLint damage[4] = {0, 0, output->width, output->height};
+    if (output->surface && state.swap_buffers_with_damage) {
+        state.swap_buffers_with_damage(state.egl_display, output->egl_surface, damage, 1);
+        return;
+    }
+    if (output->surface) {
+        wl_surface_damage_buffer(output->surface, 0, 0, output->width, output->height);
+    }
+    eglSwapBuffers(state.egl_display, output->egl_surface);
+}
+
+// How a layer's texture offset moves during a frame: the compositing vertex shader eases
+// it from `from` to `to` over `duration` seconds, starting at `begin` on the u_time clock.
+// Layers the CPU already placed have a duration of 0 and stay at `from`.
+struct layer_motion {
+    float from, to;
+    float begin, duration;
+    easing_type_t easing;
+};
+
+struct layer_batch {
+    int count;
+    GLuint textures[BATCH_MAX_LAYERS];
+    float motion[BATCH_MAX_LAYERS * 4];  // layer_motion (from, to, begin, duration) per layer
+    float easing[BATCH_MAX_LAYERS];
+    float opacity[BATCH_MAX_LAYERS];
+    float rect[4];                       // Union of the layers' screen regions
+    float view_width;
+    float max_offset;                    // Panning room moving layers are clamped to
+    int blend;                           // Composite over what earlier batches drew
+};
+
+// Texture-space offset of a layer panned by `pixel_offset`, clamped to the panning room
+static float layer_texture_offset(float pixel_offset, float max_pixel_offset, float max_texture_offset) {
+    float tex_offset = 0.0f;
+    if (max_pixel_offset > 0) {
+        tex_offset = (pixel_offset / max_pixel_offset) * max_texture_offset;
+    }
+    if (tex_offset > max_texture_offset) tex_offset = max_texture_offset;
+    if (tex_offset < 0.0f) tex_offset = 0.0f;
+    return tex_offset;
+}
+
+// Keep an output's animation rows in step with state.layers. Layers added since the last
+// call start at rest on offset 0; if the table can't grow, the missing rows read as 0.
+static anim_table_t *output_layer_anims(struct output *output) {
+    if (output->anims.count != state.layer_count &&
+        anim_table_resize(&output->anims, state.layer_count) < 0) {
+        fprintf(stderr, "Error: Failed to allocate animation state for %d layers\n",
+                state.layer_count);
+    }
+    return &output->anims;
+}
+
+// Pixel offset of one layer on an output this frame. With --gpu-animation, layers in
+// motion read as the offset their current animation started from.
+static float layer_offset(const struct output *output, int layer) {
+    return layer < output->anims.count ? output->anims.current[layer] : 0.0f;
+}
+
+// Pixel offset of one layer at `now`, even while the shader is the one animating it
+static float layer_offset_at(const struct output *output, int layer, double now) {
+    if (config.gpu_animation && layer < output->anims.count) {
+        return anim_table_offset(&output->anims, layer, now);
+    }
+    return layer_offset(output, layer);
+}
+
+// Whether two layers are drawn at the same offset for the whole frame
+static int layers_share_offset(const struct output *output, int a, int b) {
+    const anim_table_t *anims = &output->anims;
+    if (config.gpu_animation) {
+        int moving_a = a < anims->count && anims->animating[a];
+        int moving_b = b < anims->count && anims->animating[b];
+        if (moving_a || moving_b) {
+            return moving_a && moving_b && anim_table_rows_match(anims, a, b);
+        }
+    }
+    return layer_offset(output, a) == layer_offset(output, b);
+}
+
+// Whether any output shows part of a tile now, pans across it in its current animation,
+// or would reach it first on the next switch in the same direction
+static int layer_tile_is_needed(const struct layer *layer, int tile) {
+    float u0 = (float)(tile * TILE_WIDTH) / layer->width;
+    float u1 = u0 + (float)layer_tile_width(layer, tile) / layer->width;
+    float view_width = 1.0f / config.scale_factor;
+    float max_texture_offset = 1.0f - view_width;
+    float prefetch = (float)TILE_WIDTH / layer->width;
+
+    for (struct output *output = state.outputs; output; output = output->next) {
+        if (!output->configured || output->width <= 0) continue;
+
+        const anim_table_t *anims = &output->anims;
+        int row = layer - state.layers;
+        float max_pixel_offset = (config.scale_factor - 1.0f) * output->width;
+        float from = layer_texture_offset(layer_offset(output, row), max_pixel_offset, max_texture_offset);
+        float to = row < anims->count && anims->animating[row] ?
+                   layer_texture_offset(anims->target[row], max_pixel_offset, max_texture_offset) : from;
+        float lo = fminf(from, to), hi = fmaxf(from, to) + view_width;
+        if (layer->tiles->direction > 0) hi += prefetch;
+        if (layer->tiles->direction < 0) lo -= prefetch;
+        if (u0 < hi && u1 > lo) return 1;
+    }
+    return 0;
+}
+
+// Upload one column tile from the CPU copy. GLES2 has no unpack row length,
+// so the columns are gathered into a packed buffer first.
+static int upload_layer_tile(struct layer *layer, int tile) {
+    const image_t *source = &layer->tiles->source->levels[0];
+    image_t column = { .width = layer_tile_width(layer, tile), .height = source->height };
+    size_t row_bytes = (size_t)column.width * 4;
+    column.pixels = malloc(row_bytes * column.height);
+    if (!column.pixels) return -1;
+
+    const unsigned char *src = source->pixels + (size_t)tile * TILE_WIDTH * 4;
+    for (int y = 0; y < column.height; y++) {
+        memcpy(column.pixels + y * row_bytes, src + (size_t)y * source->width * 4, row_bytes);
+    }
+    layer->tiles->textures[tile] = upload_texture_levels(CACHE_FORMAT_RGBA8, &column, 1, 0);
+    free(column.pixels);
+    return 0;
+}
+
+// Make the tiles the outputs need resident and evict the rest. Called when an animation
+// starts, so the whole pan is uploaded before its first frame, and before each draw.
+static void update_layer_tiles(struct layer *layer) {
+    for (int i = 0; i < layer->tiles->count; i++) {
+        if (!layer_tile_is_needed(layer, i)) {
+            evict_layer_tile(layer, i);
+        } else if (!layer->tiles->textures[i] && upload_layer_tile(layer, i) < 0) {
+            fprintf(stderr, "Error: Failed to upload tile %d of layer '%s'\n", i, layer->image_path);
+        }
+    }
+}
+
+// The active power profile leaves out blurred layers
+static int layer_skipped(const struct layer *layer) {
+    return !active_profile()->blur_layers && layer->blur_amount > BLUR_MIN_THRESHOLD;
+}
+
+// A layer hides everything beneath it when its image is opaque and it is fully shown
+static int layer_is_occluder(const struct layer *layer) {
+    return layer->texture && layer->coverage.opaque && layer->scene == SCENE_CURRENT &&
+           layer->opacity >= 1.0f && layer->fade_start == 0.0 && !layer_skipped(layer);
+}
+
+// Opacity factor of a layer taking part in a scene switch at `now`
+static float layer_scene_opacity(const struct layer *layer, double now) {
+    if (layer->scene == SCENE_CURRENT) return 1.0f;
+    if (state.scene_fade_start == 0.0) return layer->scene == SCENE_INCOMING ? 0.0f : 1.0f;
+
+    double t = state.scene_fade > 0.0 ? (now - state.scene_fade_start) / state.scene_fade : 1.0;
+    t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+    return (float)(layer->scene == SCENE_INCOMING ? t : 1.0 - t);
+}
+
+// Everything below the topmost opaque, fully shown layer is hidden by it
+static int first_visible_layer(void) {
+    for (int i = state.layer_count - 1; i > 0; i--) {
+        if (layer_is_occluder(&state.layers[i])) return i;
+    }
+    return 0;
+}
+
+// GPU bytes releasing one layer frees: its texture unless another layer shares it,
+// cached blur and resident tiles
+static size_t layer_gpu_bytes(const struct layer *layer) {
+    size_t bytes = layer->texture && !find_texture_sharer(layer) ? layer_texture_bytes(layer) : 0;
+    if (layer->blur_texture) bytes += (size_t)layer->blur_width * layer->blur_height * 4;
+    for (int i = 0; layer->tiles && i < layer->tiles->count; i++) {
+        if (layer->tiles->textures[i]) {
+            bytes += texture_footprint(layer_tile_width(layer, i), layer->height);
+        }
+    }
+    return bytes;
+}
+
+// CPU bytes held for one layer: tiled layers keep their decoded image for tile uploads
+static size_t layer_cpu_bytes(const struct layer *layer) {
+    const struct decode_job *source = layer->tiles ? layer->tiles->source : layer->mip_source;
+    if (!source) return 0;
+    size_t bytes = 0;
+    for (int i = 0; i < source->level_count; i++) {
+        if (!source->levels[i].pixels) continue;  // Level 0 of deferred mips is on the GPU
+        bytes += cache_level_size(source->format, source->levels[i].width, source->levels[i].height);
+    }
+    return bytes;
+}
+
+// Drop the GPU (and CPU tile) copies of a layer nobody can see. It keeps its slot and
+// parameters, and render_frame queues a reload, normally a texture cache hit, once it is
+// visible again.
+static void evict_layer(struct layer *layer) {
+    if (config.debug) {
+        printf("Evicting layer %s (%.1f MiB GPU, %.1f MiB CPU) to stay within %d MiB\n",
+               layer->image_path, layer_gpu_bytes(layer) / (1024.0 * 1024.0),
+               layer_cpu_bytes(layer) / (1024.0 * 1024.0), config.texture_budget_mb);
+    }
+    release_layer_texture(layer);
+    release_layer_tiles(layer);
+    release_layer_blur(layer);
+    layer->evicted = 1;
+}
+
+static int layer_is_shown(int index, int first_visible) {
+    return index >= first_visible && state.layers[index].opacity > 0.0f;
+}
+
+// Whether a shown layer holds the same texture, so evicting this one would free nothing
+// and only cost a decode when it comes back
+static int texture_shared_with_shown(const struct layer *layer, int first_visible) {
+    for (int i = 0; layer->texture && i < state.layer_count; i++) {
+        if (&state.layers[i] != layer && state.layers[i].texture == layer->texture &&
+            layer_is_shown(i, first_visible)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Evict layers that are hidden (opacity 0) or occluded on every output, least recently
+// shown first, until texture memory fits the budget again
+static void enforce_texture_budget(void) {
+    if (config.texture_budget_mb <= 0 || !config.multi_layer_mode) return;
+    size_t budget = (size_t)config.texture_budget_mb * 1024 * 1024;
+
+    int first_visible = first_visible_layer();
+    while (state.texture_bytes > budget) {
+        struct layer *victim = NULL;
         for (int i = 0; i < state.layer_count; i++) {
             struct layer *layer = &state.layers[i];
+            if ((!layer->texture && !layer->tiles) || layer_is_shown(i, first_visible) ||
+                texture_shared_with_shown(layer, first_visible)) {
+                continue;
+            }
+            if (!victim || layer->last_drawn < victim->last_drawn) victim = layer;
+        }
+        if (!victim) break;  // Everything left is on screen
+        evict_layer(victim);
+    }
+}
 
-            if (layer->animating) {
-                double elapsed = current_time - layer->animation_start;
+// Start reloading evicted layers that came back into view
+static void reload_visible_layers(int first_visible) {
+    for (int i = first_visible; i < state.layer_count; i++) {
+        struct layer *layer = &state.layers[i];
+        if (!layer->evicted || layer->opacity <= 0.0f) continue;
+        layer->evicted = 0;
+        if (queue_layer_decode(layer) < 0) {
+            fprintf(stderr, "Failed to reload evicted layer '%s'\n", layer->image_path);
+        }
+    }
+}
 
-                // Check if we're still in delay period
-                if (elapsed < layer->animation_delay) {
-                    any_animating = 1;
-                    continue;
+// Bind the compositing program and quad once per frame (or per group cache build)
+static void begin_layer_batches(struct layer_batch *batch, float view_width, int blend,
+                                int to_texture) {
+    memset(batch, 0, sizeof(*batch));
+    batch->view_width = view_width;
+    batch->blend = blend;
+
+    glUseProgram(state.shader_program);
+    glBindBuffer(GL_ARRAY_BUFFER, state.quad_vbo);
+    glVertexAttribPointer(state.pos_attrib, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(state.pos_attrib);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state.ebo);
+    glUniform1f(state.u_view_width, view_width);
+    glUniform1f(state.u_flip, to_texture ? -1.0f : 1.0f);
+}
+
+// Draw the queued layers in one pass. Textures stay bound to their units across frames,
+// so an unchanged layer set costs no bind calls.
+static void flush_layer_batch(struct layer_batch *batch) {
+    if (batch->count == 0) return;
+
+    for (int i = 0; i < batch->count; i++) {
+        if (!state.batch_bindings_valid || state.batch_bound[i] != batch->textures[i]) {
+            glActiveTexture(GL_TEXTURE1 + i);
+            glBindTexture(GL_TEXTURE_2D, batch->textures[i]);
+            state.batch_bound[i] = batch->textures[i];
+        }
+    }
+    if (!state.batch_bindings_valid) {
+        // Units past this batch hold stale names; rebind them next time they are used
+        for (int i = batch->count; i < state.batch_size; i++) {
+            state.batch_bound[i] = 0;
+        }
+        state.batch_bindings_valid = 1;
+    }
+
+    if (batch->rect[2] > batch->rect[0] && batch->rect[3] > batch->rect[1]) {
+        if (batch->blend) {
+            glEnable(GL_BLEND);
+            // Use blend function for premultiplied alpha
+            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        } else {
+            glDisable(GL_BLEND);
+        }
+        glUniform4fv(state.u_motion, batch->count, batch->motion);
+        glUniform1fv(state.u_easing, batch->count, batch->easing);
+        glUniform1fv(state.u_opacity, batch->count, batch->opacity);
+        glUniform4fv(state.u_rect, 1, batch->rect);
+        glUniform1i(state.u_count, batch->count);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+    }
+
+    // Later batches always composite over this one
+    batch->count = 0;
+    batch->rect[0] = batch->rect[1] = batch->rect[2] = batch->rect[3] = 0.0f;
+    batch->blend = 1;
+}
+
+// A layer standing still at a texture offset
+static struct layer_motion motion_at(float offset) {
+    struct layer_motion motion = {offset, offset, 0.0f, 0.0f, EASE_LINEAR};
+    return motion;
+}
+
+// How one row of an animation table moves this frame. With --gpu-animation a row in motion
+// is handed to the shader whole, timed from `epoch`; otherwise it stands at the offset the
+// CPU evaluated for this frame.
+static struct layer_motion anim_motion(const anim_table_t *table, int row, double epoch,
+                                       float max_pixel_offset, float max_texture_offset) {
+    float current = row < table->count ? table->current[row] : 0.0f;
+    if (!config.gpu_animation || row >= table->count || !table->animating[row] ||
+        table->duration[row] <= 0.0f) {
+        return motion_at(layer_texture_offset(current, max_pixel_offset, max_texture_offset));
+    }
+
+    // Pixel to texture offsets is a plain scale; the shader clamps what it eases
+    float scale = max_pixel_offset > 0 ? max_texture_offset / max_pixel_offset : 0.0f;
+    struct layer_motion motion = {
+        table->start[row] * scale, table->target[row] * scale,
+        (float)(table->started[row] + table->delay[row] - epoch), table->duration[row],
+        table->easing[row],
+    };
+    return motion;
+}
+
+// Queue a layer; `coverage` (NULL = whole texture) trims the region the batch covers
+static void add_batch_layer(struct layer_batch *batch, GLuint texture, struct layer_motion motion,
+                            float opacity, const image_coverage_t *coverage,
+                            float extent_u, float extent_v) {
+    float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+    if (coverage) {
+        if (coverage->empty) return;
+        // Blur spreads content by its radius; a texel of margin keeps filtering intact
+        float margin_u = extent_u + 1.0f / 1024.0f, margin_v = extent_v + 1.0f / 1024.0f;
+        u0 = coverage->u0 - margin_u;
+        v0 = coverage->v0 - margin_v;
+        u1 = coverage->u1 + margin_u;
+        v1 = coverage->v1 + margin_v;
+    }
+
+    int i = batch->count;
+    batch->textures[i] = texture;
+    batch->motion[i * 4] = motion.from;
+    batch->motion[i * 4 + 1] = motion.to;
+    batch->motion[i * 4 + 2] = motion.begin;
+    batch->motion[i * 4 + 3] = motion.duration;
+    batch->easing[i] = (float)motion.easing;
+    batch->opacity[i] = opacity;
+
+    // Screen region where this layer's visible box lands at its current offset, or
+    // anywhere along the way for a layer the shader moves
+    float lo = motion.from, hi = motion.from;
+    if (motion.duration > 0.0f) {
+        if (easing_overshoots(motion.easing)) {
+            lo = 0.0f;
+            hi = batch->max_offset;
+        } else {
+            lo = fminf(fmaxf(fminf(motion.from, motion.to), 0.0f), batch->max_offset);
+            hi = fminf(fmaxf(fmaxf(motion.from, motion.to), 0.0f), batch->max_offset);
+        }
+    }
+    float x0 = (u0 - hi) / batch->view_width, x1 = (u1 - lo) / batch->view_width;
+    float rect[4] = {
+        x0 < 0.0f ? 0.0f : x0, v0 < 0.0f ? 0.0f : v0,
+        x1 > 1.0f ? 1.0f : x1, v1 > 1.0f ? 1.0f : v1,
+    };
+    if (rect[2] <= rect[0] || rect[3] <= rect[1]) return;  // Panned out of view
+    if (batch->count == 0 || rect[0] < batch->rect[0]) batch->rect[0] = rect[0];
+    if (batch->count == 0 || rect[1] < batch->rect[1]) batch->rect[1] = rect[1];
+    if (batch->count == 0 || rect[2] > batch->rect[2]) batch->rect[2] = rect[2];
+    if (batch->count == 0 || rect[3] > batch->rect[3]) batch->rect[3] = rect[3];
+
+    if (++batch->count == state.batch_size) {
+        flush_layer_batch(batch);
+    }
+}
+
+// Draw a tiled layer. Each tile is its own texture and covers only its own columns, so
+// every tile gets a pass of its own with the view width rescaled to tile space. Tile
+// rects abut exactly, so no pixel is blended twice.
+static void draw_layer_tiles(struct layer_batch *batch, const struct layer *layer,
+                             float offset, float opacity) {
+    float view_width = batch->view_width;
+    flush_layer_batch(batch);
+
+    for (int i = 0; i < layer->tiles->count; i++) {
+        float u0 = (float)(i * TILE_WIDTH) / layer->width;
+        float scale = (float)layer->width / layer_tile_width(layer, i);
+        if (!layer->tiles->textures[i] || u0 >= offset + view_width || u0 + 1.0f / scale <= offset) {
+            continue;
+        }
+
+        batch->view_width = view_width * scale;
+        glUniform1f(state.u_view_width, batch->view_width);
+        add_batch_layer(batch, layer->tiles->textures[i], motion_at((offset - u0) * scale),
+                        opacity, NULL, 0.0f, 0.0f);
+        flush_layer_batch(batch);
+    }
+
+    batch->view_width = view_width;
+    glUniform1f(state.u_view_width, view_width);
+}
+
+// Texture a layer is drawn from, and how far its cached blur spreads
+static GLuint layer_draw_texture(const struct layer *layer, float *extent_u, float *extent_v) {
+    *extent_u = *extent_v = 0.0f;
+    if (layer->blur_amount > BLUR_MIN_THRESHOLD && layer->blur_texture) {
+        *extent_u = layer->blur_extent_u;
+        *extent_v = layer->blur_extent_v;
+        return layer->blur_texture;
+    }
+    return layer->texture;
+}
+
+// Layers can share a group cache when nothing about them animates independently
+static int layers_move_together(const struct layer *a, const struct layer *b) {
+    return a->texture && b->texture && a->fade_start == 0.0 && b->fade_start == 0.0 &&
+           a->scene == SCENE_CURRENT && b->scene == SCENE_CURRENT &&
+           !layer_skipped(a) && !layer_skipped(b) &&
+           a->shift_multiplier == b->shift_multiplier && a->easing == b->easing &&
+           a->animation_delay == b->animation_delay &&
+           a->animation_duration == b->animation_duration;
+}
+
+// Check whether a group's cache still matches its members
+static int layer_group_is_current(const struct layer_group *group) {
+    if (!group->texture) return 0;
+    for (int i = 0; i < group->count; i++) {
+        const struct layer *layer = &state.layers[group->first + i];
+        float extent_u, extent_v;
+        if (group->sources[i] != layer_draw_texture(layer, &extent_u, &extent_v) ||
+            group->opacities[i] != layer->opacity ||
+            group->blur_amounts[i] != layer->blur_amount) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void release_layer_group(struct layer_group *group) {
+    if (group->texture) {
+        glDeleteTextures(1, &group->texture);
+        track_texture_free((size_t)group->width * group->height * 4);
+        group->texture = 0;
+    }
+    group->width = group->height = 0;
+}
+
+// Composite a group's members (at their shared offset of zero) into a scratch target,
+// then convert the premultiplied result to straight alpha so the compositing shader can
+// sample the cache like any layer. Caches cover the output's visible slice, like blurs.
+static int build_layer_group(struct layer_group *group) {
+    int output_width, output_height;
+    max_output_size(&output_width, &output_height);
+    if (output_width <= 0 || output_height <= 0 || !state.unpremultiply_program) return -1;
+
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    int width = (int)(output_width * config.scale_factor);
+    int height = output_height;
+    if (max_size > 0 && width > max_size) width = max_size;
+    if (max_size > 0 && height > max_size) height = max_size;
+
+    if (!state.group_scratch_texture || state.group_scratch_width != width ||
+        state.group_scratch_height != height) {
+        if (state.group_scratch_texture) {
+            glDeleteTextures(1, &state.group_scratch_texture);
+            track_texture_free((size_t)state.group_scratch_width * state.group_scratch_height * 4);
+        }
+        state.group_scratch_texture = create_render_target(width, height);
+        state.group_scratch_width = width;
+        state.group_scratch_height = height;
+        track_texture_alloc((size_t)width * height * 4);
+    }
+
+    if (!group->texture || group->width != width || group->height != height) {
+        release_layer_group(group);
+        group->texture = create_render_target(width, height);
+        group->width = width;
+        group->height = height;
+        track_texture_alloc((size_t)width * height * 4);
+    }
+
+    if (bind_render_target(state.group_scratch_texture, width, height) < 0) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        release_layer_group(group);
+        return -1;
+    }
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    memset(&group->coverage, 0, sizeof(group->coverage));
+    group->coverage.empty = 1;
+
+    struct layer_batch batch;
+    begin_layer_batches(&batch, 1.0f, 1, 1);
+    for (int i = 0; i < group->count; i++) {
+        const struct layer *layer = &state.layers[group->first + i];
+        float extent_u, extent_v;
+        GLuint texture = layer_draw_texture(layer, &extent_u, &extent_v);
+        add_batch_layer(&batch, texture, motion_at(0.0f), layer->opacity, &layer->coverage,
+                        extent_u, extent_v);
+
+        group->sources[i] = texture;
+        group->opacities[i] = layer->opacity;
+        group->blur_amounts[i] = layer->blur_amount;
+
+        // The group hides what is beneath it if any member does
+        image_coverage_t *coverage = &group->coverage;
+        if (layer_is_occluder(layer)) coverage->opaque = 1;
+        if (layer->coverage.empty) continue;
+        float u0 = layer->coverage.u0 - extent_u, v0 = layer->coverage.v0 - extent_v;
+        float u1 = layer->coverage.u1 + extent_u, v1 = layer->coverage.v1 + extent_v;
+        if (coverage->empty || u0 < coverage->u0) coverage->u0 = u0;
+        if (coverage->empty || v0 < coverage->v0) coverage->v0 = v0;
+        if (coverage->empty || u1 > coverage->u1) coverage->u1 = u1;
+        if (coverage->empty || v1 > coverage->v1) coverage->v1 = v1;
+        coverage->empty = 0;
+    }
+    flush_layer_batch(&batch);
+    glActiveTexture(GL_TEXTURE0);
+
+    int result = bind_render_target(group->texture, width, height);
+    if (result == 0) {
+        glDisable(GL_BLEND);
+        glUseProgram(state.unpremultiply_program);
+        draw_render_target_quad(state.unpremultiply_program, state.group_scratch_texture);
+    } else {
+        release_layer_group(group);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (result == 0 && config.debug) {
+        printf("Cached layers %d-%d as one group (%dx%d)\n",
+               group->first, group->first + group->count - 1, width, height);
+    }
+    return result;
+}
+
+// Find runs of at least two visible layers that move together and make sure each has
+// an up-to-date group cache. Groups whose run disappeared are released.
+static void update_layer_groups(int first_layer) {
+    struct layer_group groups[MAX_LAYER_GROUPS];
+    int group_count = 0;
+
+    int i = state.unpremultiply_program ? first_layer : state.layer_count;
+    while (i < state.layer_count && group_count < MAX_LAYER_GROUPS) {
+        int count = 1;
+        while (i + count < state.layer_count && count < BATCH_MAX_LAYERS &&
+               layers_move_together(&state.layers[i], &state.layers[i + count])) {
+            count++;
+        }
+        if (count >= 2) {
+            // Keep the existing cache for an unchanged range
+            struct layer_group *group = &groups[group_count++];
+            memset(group, 0, sizeof(*group));
+            for (int j = 0; j < state.layer_group_count; j++) {
+                struct layer_group *old = &state.layer_groups[j];
+                if (old->texture && old->first == i && old->count == count) {
+                    *group = *old;
+                    old->texture = 0;
+                    break;
                 }
+            }
+            group->first = i;
+            group->count = count;
+        }
+        i += count;
+    }
 
-                // Adjust elapsed time for delay
-                elapsed -= layer->animation_delay;
+    // Deleting our own caches doesn't touch the sources, so check validity first
+    int sources_valid = state.layer_groups_valid;
+    for (int j = 0; j < state.layer_group_count; j++) {
+        release_layer_group(&state.layer_groups[j]);
+    }
+    memcpy(state.layer_groups, groups, sizeof(struct layer_group) * group_count);
+    state.layer_group_count = group_count;
+
+    for (int j = 0; j < group_count; j++) {
+        struct layer_group *group = &state.layer_groups[j];
+        if (!sources_valid || !layer_group_is_current(group)) {
+            build_layer_group(group);
+        }
+    }
+    state.layer_groups_valid = 1;
+}
+
+static void release_layer_groups(void) {
+    for (int i = 0; i < state.layer_group_count; i++) {
+        release_layer_group(&state.layer_groups[i]);
+    }
+    state.layer_group_count = 0;
+    if (state.group_scratch_texture) {
+        glDeleteTextures(1, &state.group_scratch_texture);
+        track_texture_free((size_t)state.group_scratch_width * state.group_scratch_height * 4);
+        state.group_scratch_texture = 0;
+    }
+}
+
+static void release_scaled_target(struct output *output) {
+    if (!output->scaled_target) return;
+    glDeleteTextures(1, &output->scaled_target);
+    track_texture_free((size_t)output->scaled_width * output->scaled_height * 4);
+    output->scaled_target = 0;
+    output->scaled_width = output->scaled_height = 0;
+}
 
-                if (elapsed >= layer->animation_duration) {
-                    // This layer's animation is complete
-                    layer->current_offset = layer->target_offset;
-                    layer->animating = 0;
+// Read back the GPU time of the output's last composite if the GPU has finished it, and
+// let dynamic resolution react to it. Never waits; returns milliseconds or -1.
+static double collect_gpu_time(struct output *output) {
+    if (!output->gpu_query_pending) return -1.0;
+
+    GLuint available = 0;
+    state.get_query_uint(output->gpu_query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+    if (!available) return -1.0;
+    output->gpu_query_pending = 0;
+
+    // A disjoint operation (e.g. a clock change) makes the measurement meaningless
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint) return -1.0;
+
+    GLuint64 elapsed_ns = 0;
+    state.get_query_u64(output->gpu_query, GL_QUERY_RESULT_EXT, &elapsed_ns);
+    double ms = elapsed_ns / 1000000.0;
+    stats_record(&state.stats, STATS_GPU, ms);
+
+    // Full-resolution frames (e.g. the one an animation settles on) say nothing about
+    // the cost at a reduced scale
+    if (config.dynamic_resolution && state.copy_program &&
+        output->gpu_query_scale == output->resscale.scale) {
+        // A lowered frame cap leaves each frame more time
+        int fps = frame_rate_cap();
+        double period = fps > 0 ? 1.0 / fps : 0.0;
+        if (output->refresh_period > period) period = output->refresh_period;
+        if (period <= 0.0) period = 1.0 / 60.0;
+        if (resscale_update(&output->resscale, ms, period * 1000.0 * RESSCALE_BUDGET) &&
+            config.debug) {
+            printf("Output %s: compositing animations at %.0f%% resolution (GPU %.2f ms)\n",
+                   output->name ? output->name : "offscreen",
+                   output->resscale.scale * 100.0f, output->resscale.average_ms);
+        }
+    }
+    return ms;
+}
+
+// Bind a render target at the output's current dynamic resolution scale, (re)creating it
+// when the scale changed. Returns 0 with the target bound, -1 to draw to the screen.
+static int bind_scaled_target(struct output *output) {
+    int width = (int)(output->width * output->resscale.scale + 0.5f);
+    int height = (int)(output->height * output->resscale.scale + 0.5f);
+    if (width < 1 || height < 1) return -1;
+
+    if (output->scaled_width != width || output->scaled_height != height) {
+        release_scaled_target(output);
+        output->scaled_target = create_render_target(width, height);
+        output->scaled_width = width;
+        output->scaled_height = height;
+        track_texture_alloc((size_t)width * height * 4);
+    }
+    if (bind_render_target(output->scaled_target, width, height) < 0) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        release_scaled_target(output);
+        return -1;
+    }
+    return 0;
+}
+
+// A settled frame read back for the next start; downscaled and stored on a worker
+struct snapshot_job {
+    char key[CACHE_KEY_SIZE];
+    uint64_t scene_hash;
+    image_t frame;  // Bottom row first, as read back; uploaded the same way it draws upright
+    int result;
+};
+
+static int layers_loading(void) {
+    for (int i = 0; i < state.layer_count; i++) {
+        if (state.layers[i].load_id) return 1;
+    }
+    return 0;
+}
+
+// Everything a settled frame of the output depends on besides its workspace: its size,
+// the panning and blur settings, and each layer's file and settings
+static uint64_t snapshot_scene_hash(const struct output *output) {
+    int32_t size[2] = { output->width, output->height };
+    float settings[3] = { config.shift_per_workspace, config.scale_factor, config.blur_downscale };
+    uint64_t hash = CACHE_HASH_SEED;
+    hash = cache_hash(hash, size, sizeof(size));
+    hash = cache_hash(hash, settings, sizeof(settings));
+
+    for (int i = 0; i < state.layer_count; i++) {
+        const struct layer *layer = &state.layers[i];
+        char file[CACHE_KEY_SIZE] = "";  // Path, mtime and size; stays empty if unreadable
+        if (layer->image_path) cache_make_key(layer->image_path, 0, 0, file, sizeof(file));
+        float layer_settings[3] = { layer->shift_multiplier, layer->opacity, layer->blur_amount };
+        hash = cache_hash(hash, file, sizeof(file));
+        hash = cache_hash(hash, layer_settings, sizeof(layer_settings));
+    }
+    return hash;
+}
+
+static void snapshot_job_run(void *arg) {
+    struct snapshot_job *job = arg;
+    int width = job->frame.width / SNAPSHOT_DOWNSCALE;
+    int height = job->frame.height / SNAPSHOT_DOWNSCALE;
+    image_t small = {0};
+
+    cache_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    meta.content_hash = job->scene_hash;
+
+    job->result = image_resize(&job->frame, &small, width > 0 ? width : 1, height > 0 ? height : 1);
+    if (job->result == 0) {
+        job->result = cache_store(job->key, CACHE_FORMAT_RGBA8, &small, 1, &meta);
+    }
+    image_free(&small);
+}
+
+static void snapshot_job_done(void *arg, int cancelled) {
+    struct snapshot_job *job = arg;
+    if (!cancelled && config.debug) {
+        printf("%s snapshot %s\n", job->result == 0 ? "Saved" : "Failed to save", job->key);
+    }
+    image_free(&job->frame);
+    free(job);
+}
+
+// Read back the frame an output just settled on (before it is swapped) and store it for the
+// next start. The readback waits for the GPU, so it is skipped when the snapshot on disk
+// already shows this scene and workspace, and happens at most every SNAPSHOT_INTERVAL; a
+// save that comes sooner is retried with a redraw once the interval is up.
+static void save_output_snapshot(struct output *output, double now) {
+    int workspace = output->current_workspace;
+    output->snapshot_due = 0.0;
+    if (!config.multi_layer_mode || !config.texture_cache || config.bench || !output->name ||
+        workspace < 1 || workspace > SNAPSHOT_MAX_WORKSPACES) {
+        return;
+    }
+
+    // Only the scene as a new start would draw it: fully loaded, with no switch under way
+    // and no layer left out by a power profile
+    if (state.scene_pending || state.scene_fade_start > 0.0 || layers_loading()) return;
+    for (int i = 0; i < state.layer_count; i++) {
+        if (layer_skipped(&state.layers[i])) return;
+    }
+
+    uint64_t scene_hash = snapshot_scene_hash(output);
+    if (output->snapshot_saved[workspace - 1] == scene_hash) return;
+    if (now - output->snapshot_time < SNAPSHOT_INTERVAL) {
+        output->snapshot_due = output->snapshot_time + SNAPSHOT_INTERVAL;
+        return;
+    }
+
+    struct snapshot_job *job = calloc(1, sizeof(struct snapshot_job));
+    if (!job || cache_snapshot_key(output->name, workspace, job->key, sizeof(job->key)) < 0 ||
+        !(job->frame.pixels = malloc((size_t)output->width * output->height * 4))) {
+        free(job);
+        return;
+    }
+    glReadPixels(0, 0, output->width, output->height, GL_RGBA, GL_UNSIGNED_BYTE, job->frame.pixels);
+    job->frame.width = output->width;
+    job->frame.height = output->height;
+    job->scene_hash = scene_hash;
+    output->snapshot_saved[workspace - 1] = scene_hash;
+    output->snapshot_time = now;
+
+    if (!state.decode_pool ||
+        pool_submit(state.decode_pool, snapshot_job_run, snapshot_job_done, job) < 0) {
+        snapshot_job_run(job);
+        snapshot_job_done(job, 0);
+    }
+}
+
+// Redraw settled outputs whose snapshot save is due. Returns the milliseconds until the next
+// one, or -1 if none is waiting.
+static int retry_output_snapshots(double now) {
+    int timeout = -1;
+    for (struct output *output = state.outputs; output; output = output->next) {
+        if (output->snapshot_due <= 0.0) continue;
+        if (output->animating) {
+            output->snapshot_due = 0.0;  // Its next settled frame is saved instead
+        } else if (now >= output->snapshot_due) {
+            output->snapshot_due = 0.0;  // Set again if the redraw can't save either
+            output->dirty = 1;
+        } else {
+            int wait = (int)ceil((output->snapshot_due - now) * 1000.0);
+            if (timeout < 0 || wait < timeout) timeout = wait;
+        }
+    }
+    return timeout;
+}
+
+// On an output's first configure, while the layers are still decoding, upload the snapshot
+// the last session saved for its workspace if it shows the same scene at this size
+static void load_output_snapshot(struct output *output) {
+    int workspace = output->current_workspace;
+    if (!config.multi_layer_mode || !config.texture_cache || !output->name ||
+        !state.copy_program || workspace < 1 || workspace > SNAPSHOT_MAX_WORKSPACES ||
+        !layers_loading()) {
+        return;
+    }
+
+    char key[CACHE_KEY_SIZE];
+    cache_entry_t entry;
+    if (cache_snapshot_key(output->name, workspace, key, sizeof(key)) < 0 ||
+        cache_load(key, &entry) < 0) {
+        return;
+    }
+
+    uint64_t scene_hash = snapshot_scene_hash(output);
+    if (entry.format == CACHE_FORMAT_RGBA8 && entry.level_count == 1 &&
+        entry.meta.content_hash == scene_hash) {
+        const image_t *frame = &entry.levels[0];
+        output->snapshot_texture = create_render_target(frame->width, frame->height);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frame->width, frame->height,
+                        GL_RGBA, GL_UNSIGNED_BYTE, frame->pixels);
+        output->snapshot_width = frame->width;
+        output->snapshot_height = frame->height;
+        output->snapshot_workspace = workspace;
+        output->snapshot_saved[workspace - 1] = scene_hash;  // Nothing new to save
+        track_texture_alloc((size_t)frame->width * frame->height * 4);
+
+        if (config.debug) {
+            printf("Showing snapshot of workspace %d on %s (%dx%d) while layers load\n",
+                   workspace, output->name, frame->width, frame->height);
+        }
+    } else if (config.debug) {
+        printf("Snapshot of workspace %d on %s is out of date\n", workspace, output->name);
+    }
+    cache_release(&entry);
+}
+
+static void release_output_snapshot(struct output *output) {
+    if (!output->snapshot_texture) return;
+    glDeleteTextures(1, &output->snapshot_texture);
+    track_texture_free((size_t)output->snapshot_width * output->snapshot_height * 4);
+    output->snapshot_texture = 0;
+    output->snapshot_width = output->snapshot_height = 0;
+    output->snapshot_drawn = 0;
+}
+
+// Upscale the snapshot over the whole output. Returns 1 when a frame was submitted.
+static int draw_output_snapshot(struct output *output) {
+    if (eglGetCurrentSurface(EGL_DRAW) != output->egl_surface) {
+        eglMakeCurrent(state.egl_display, output->egl_surface, output->egl_surface, state.egl_context);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, output->width, output->height);
+    glDisable(GL_BLEND);
+    glActiveTexture(GL_TEXTURE0);
+    glUseProgram(state.copy_program);
+    draw_render_target_quad(state.copy_program, output->snapshot_texture);
+
+    eglSwapInterval(state.egl_display, config.vsync ? 1 : 0);
+    swap_output_buffers(output);
+    output->snapshot_drawn = 1;
+    return 1;
+}
+
+// Advance animations and draw an output if anything on it changed. Returns 1 when a
+// frame was submitted, 0 when the compositor can keep showing the previous one.
+int render_frame(struct output *output) {
+    // Don't render if OpenGL isn't initialized yet, or the output has nothing to draw into
+    if (state.shader_program == 0 || !output->configured || output->egl_surface == EGL_NO_SURFACE) {
+        return 0;
+    }
+
+    // A pausing power profile draws nothing, and nothing of the wallpaper shows under a
+    // fullscreen window; what changed meanwhile is drawn once the output shows again
+    if (active_profile()->pause || workspace_is_fullscreen(output->current_workspace)) {
+        output->last_frame_done = 0.0;
+        return 0;
+    }
+
+    // The last session's snapshot stands in until the layers have loaded, unless the
+    // output has moved on to another workspace meanwhile
+    if (output->snapshot_texture) {
+        if (layers_loading() && output->current_workspace == output->snapshot_workspace) {
+            output->dirty = 0;
+            output->animating = 0;
+            return output->snapshot_drawn ? 0 : draw_output_snapshot(output);
+        }
+        release_output_snapshot(output);
+        output->dirty = 1;
+
+        // The snapshot already showed the scene, so the layers replace it without fading in
+        for (int i = 0; i < state.layer_count; i++) {
+            state.layers[i].fade_start = 0.0;
+        }
+    }
+    double current_time = get_time();
+    double present_time = predict_presentation_time(output, current_time);
+
+    // A finished crossfade drops the previous scene before anything is drawn
+    if (state.scene_fade_start > 0.0 && present_time - state.scene_fade_start >= state.scene_fade) {
+        finish_scene_switch();
+    }
+    int changed = output->dirty;
+
+    // Update animation for all layers
+    if (config.multi_layer_mode) {
+        // Per-layer animation with individual timing, evaluated in one pass over the table
+        // (or by the compositing shader, leaving only finished rows to settle)
+        anim_table_t *anims = output_layer_anims(output);
+        int any_animating = (config.gpu_animation ?
+                             anim_table_settle(anims, present_time, &changed) :
+                             anim_table_update(anims, present_time, &changed)) > 0;
+        for (int i = 0; i < state.layer_count; i++) {
+            struct layer *layer = &state.layers[i];
+
+            // Keep frames coming while a freshly loaded layer fades in
+            if (layer->fade_start > 0.0) {
+                if (present_time - layer->fade_start >= LAYER_FADE_DURATION) {
+                    // Other outputs still need the fully opaque frame
+                    layer->fade_start = 0.0;
+                    mark_outputs_dirty();
                 } else {
-                    float t = elapsed / layer->animation_duration;
-                    float eased = apply_easing(t, layer->easing);
-                    layer->current_offset = layer->start_offset +
-                        (layer->target_offset - layer->start_offset) * eased;
                     any_animating = 1;
                 }
+                changed = 1;
             }
         }
-        state.animating = any_animating;
-    } else {
+
+        // Keep frames coming while two scenes crossfade
+        if (state.scene_fade_start > 0.0) {
+            any_animating = 1;
+            changed = 1;
+        }
+        output->animating = any_animating;
+    } else if (output->animating) {
         // Single layer mode (backward compatible)
-        if (state.animating) {
-            double elapsed = current_time - state.animation_start;
+        output->animating = (config.gpu_animation ?
+                             anim_table_settle(&output->image_anim, present_time, &changed) :
+                             anim_table_update(&output->image_anim, present_time, &changed)) > 0;
+    }
+
+    // Rebuild cached blur textures whose layer, blur amount or output size changed
+    if (config.multi_layer_mode) {
+        for (int i = 0; i < state.layer_count; i++) {
+            struct layer *layer = &state.layers[i];
+            if (layer->tiles) {
+                update_layer_tiles(layer);  // Tiled layers are drawn unblurred
+                continue;
+            }
+            if (!layer->texture || layer_skipped(layer)) continue;  // Still decoding, or not drawn
+            if (layer->blur_amount > BLUR_MIN_THRESHOLD && !layer_blur_is_current(layer)) {
+                build_layer_blur(layer);
+                mark_outputs_dirty();
+                changed = 1;
+            } else if (layer->blur_amount <= BLUR_MIN_THRESHOLD && layer->blur_texture) {
+                release_layer_blur(layer);
+                mark_outputs_dirty();
+                changed = 1;
+            }
+        }
+    }
+
+    // Nothing on screen would differ: keep the previous buffer. An animation still in
+    // its delay period only re-arms the frame callback with an empty commit.
+    if (!changed) {
+        if (output->animating && output->surface) {
+            request_output_frame(output);
+            wl_surface_commit(output->surface);
+        } else {
+            output->last_frame_done = 0.0;  // Idle gaps are not missed frames
+        }
+        output->last_frame_time = current_time;
+        return 0;
+    }
+    output->dirty = 0;
+
+    double update_done = get_time();
 
-            if (elapsed >= config.animation_duration) {
-                state.current_offset = state.target_offset;
-                state.animating = 0;
-            } else {
-                float t = elapsed / config.animation_duration;
-                float eased = apply_easing(t, config.easing);
-                state.current_offset = state.start_offset +
-                    (state.target_offset - state.start_offset) * eased;
-            }
+    // All outputs share the context; draw into this output's surface
+    if (eglGetCurrentSurface(EGL_DRAW) != output->egl_surface) {
+        eglMakeCurrent(state.egl_display, output->egl_surface, output->egl_surface, state.egl_context);
+    }
+
+    // Everything below the topmost opaque, fully shown layer is hidden by it
+    int first_layer = 0;
+    if (config.multi_layer_mode) {
+        first_layer = first_visible_layer();
+        reload_visible_layers(first_layer);
+        for (int i = first_layer; i < state.layer_count; i++) {
+            if (state.layers[i].opacity > 0.0f) state.layers[i].last_drawn = present_time;
         }
+        enforce_texture_budget();
+        update_layer_groups(first_layer);
+    }
+
+    // Time the composite on the GPU; a query still in flight is left to finish
+    collect_gpu_time(output);
+    int timed = state.timer_query && !output->gpu_query_pending;
+    if (timed) {
+        if (!output->gpu_query) state.gen_queries(1, &output->gpu_query);
+        state.begin_query(GL_TIME_ELAPSED_EXT, output->gpu_query);
+    }
+
+    // Under GPU load animated frames are drawn smaller and upscaled; the frame an
+    // animation settles on is always drawn at full resolution
+    int scaled = config.dynamic_resolution && state.copy_program && output->animating &&
+                 output->resscale.scale < 1.0f && bind_scaled_target(output) == 0;
+    if (!scaled) {
+        release_scaled_target(output);
+        glViewport(0, 0, output->width, output->height);
     }
+    output->gpu_query_scale = scaled ? output->resscale.scale : 1.0f;
 
     // Clear
     glClear(GL_COLOR_BUFFER_BIT);
 
-    // Enable blending for multi-layer mode
-    if (config.multi_layer_mode && state.layer_count > 1) {
-        glEnable(GL_BLEND);
-        // Use blend function for premultiplied alpha
-        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-    }
+    // Blend multiple layers, except when the bottom one drawn is opaque anyway
+    int blend = config.multi_layer_mode && state.layer_count > 1 &&
+                !layer_is_occluder(&state.layers[first_layer]);
 
-    // Get attribute locations once
-    GLint pos_attrib = glGetAttribLocation(state.shader_program, "position");
-    GLint tex_attrib = glGetAttribLocation(state.shader_program, "texcoord");
+    // Every layer shares one quad and program; only per-batch uniforms change
+    float viewport_width_in_texture = 1.0f / config.scale_factor;
+    float max_texture_offset = 1.0f - viewport_width_in_texture;
+    float max_pixel_offset = (config.scale_factor - 1.0f) * output->width;
+    struct layer_batch batch;
+    begin_layer_batches(&batch, viewport_width_in_texture, blend, 0);
+    batch.max_offset = max_texture_offset;
+    glUniform1f(state.u_max_offset, max_texture_offset);
+    glUniform1f(state.u_time, (float)(present_time - output->anim_epoch));
 
     if (config.multi_layer_mode) {
-        // Render each layer
-        for (int i = 0; i < state.layer_count; i++) {
+        int next_group = 0;
+        for (int i = first_layer; i < state.layer_count; i++) {
             struct layer *layer = &state.layers[i];
 
-            // Calculate layer-specific texture offset
-            float viewport_width_in_texture = 1.0f / config.scale_factor;
-            float max_texture_offset = 1.0f - viewport_width_in_texture;
-            float max_pixel_offset = (config.scale_factor - 1.0f) * state.width;
-            float tex_offset = 0.0f;
-
-            if (max_pixel_offset > 0) {
-                tex_offset = (layer->current_offset / max_pixel_offset) * max_texture_offset;
+            // A cached group stands in for its members while they share an offset
+            while (next_group < state.layer_group_count &&
+                   state.layer_groups[next_group].first < i) {
+                next_group++;
             }
-
-            // Clamp to valid range
-            if (tex_offset > max_texture_offset) tex_offset = max_texture_offset;
-            if (tex_offset < 0.0f) tex_offset = 0.0f;
-
-            // Update vertex buffer for this layer
-            float vertices[] = {
-                -1.0f, -1.0f,  tex_offset, 1.0f,
-                 1.0f, -1.0f,  tex_offset + viewport_width_in_texture, 1.0f,
-                 1.0f,  1.0f,  tex_offset + viewport_width_in_texture, 0.0f,
-                -1.0f,  1.0f,  tex_offset, 0.0f,
-            };
-
-            glBindBuffer(GL_ARRAY_BUFFER, state.vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
-
-            // Set up vertex attributes
-            glVertexAttribPointer(pos_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-            glEnableVertexAttribArray(pos_attrib);
-            glVertexAttribPointer(tex_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-            glEnableVertexAttribArray(tex_attrib);
-
-            // Select shader based on blur amount
-            if (layer->blur_amount > BLUR_MIN_THRESHOLD && state.blur_shader_program != 0) {
-                if (config.debug) {
-                    static int blur_count = 0;
-                    if (blur_count++ < 5) {  // Only print first 5 times to avoid spam
-                        fprintf(stderr, "Using blur shader for layer %d with blur amount: %.2f\n", 
-                                i, layer->blur_amount);
-                    }
+            if (next_group < state.layer_group_count && state.layer_groups[next_group].first == i) {
+                struct layer_group *group = &state.layer_groups[next_group++];
+                int together = group->texture != 0;
+                for (int j = 1; j < group->count && together; j++) {
+                    together = layers_share_offset(output, i, i + j);
                 }
-                glUseProgram(state.blur_shader_program);
-
-                // Bind layer texture and set uniforms using pre-cached locations
-                glBindTexture(GL_TEXTURE_2D, layer->texture);
-                glUniform1i(state.blur_u_texture, 0);
-                glUniform1f(state.blur_u_opacity, layer->opacity);
-                glUniform1f(state.blur_u_blur_amount, layer->blur_amount);
-                glUniform2f(state.blur_u_resolution, (float)state.width, (float)state.height);
-                
-            } else {
-                glUseProgram(state.shader_program);
+                if (together) {
+                    add_batch_layer(&batch, group->texture,
+                                    anim_motion(&output->anims, i, output->anim_epoch,
+                                                max_pixel_offset, max_texture_offset),
+                                    1.0f, &group->coverage, 0.0f, 0.0f);
+                    i += group->count - 1;
+                    continue;
+                }
+            }
 
-                // Bind layer texture and set uniforms
-                glBindTexture(GL_TEXTURE_2D, layer->texture);
-                glUniform1i(state.u_texture, 0);
-                glUniform1f(state.u_opacity, layer->opacity);
+            // Layers still decoding have nothing to draw yet
+            if (!layer->texture && !layer->tiles) continue;
+            if (layer_skipped(layer)) continue;
+
+            float opacity = layer->opacity;
+            if (layer->fade_start > 0.0) {
+                opacity *= (float)((present_time - layer->fade_start) / LAYER_FADE_DURATION);
+            }
+            opacity *= layer_scene_opacity(layer, present_time);
+            if (opacity <= 0.0f) continue;  // Includes scene layers still waiting to be shown
+
+            if (layer->tiles) {
+                draw_layer_tiles(&batch, layer,
+                                 layer_texture_offset(layer_offset_at(output, i, present_time),
+                                                      max_pixel_offset, max_texture_offset),
+                                 opacity);
+                continue;
             }
 
-            // Draw layer
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state.ebo);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+            // Blurred layers sample their cached pre-blurred texture with the normal shader
+            float extent_u, extent_v;
+            GLuint texture = layer_draw_texture(layer, &extent_u, &extent_v);
+
+            add_batch_layer(&batch, texture,
+                            anim_motion(&output->anims, i, output->anim_epoch,
+                                        max_pixel_offset, max_texture_offset),
+                            opacity, &layer->coverage, extent_u, extent_v);
         }
     } else {
         // Single layer mode (backward compatible)
-        float viewport_width_in_texture = 1.0f / config.scale_factor;
-        float max_texture_offset = 1.0f - viewport_width_in_texture;
-        float max_pixel_offset = (config.scale_factor - 1.0f) * state.width;
-        float tex_offset = 0.0f;
-
-        if (max_pixel_offset > 0) {
-            tex_offset = (state.current_offset / max_pixel_offset) * max_texture_offset;
-        }
-
-        if (tex_offset > max_texture_offset) tex_offset = max_texture_offset;
-        if (tex_offset < 0.0f) tex_offset = 0.0f;
+        add_batch_layer(&batch, state.texture,
+                        anim_motion(&output->image_anim, 0, output->anim_epoch,
+                                    max_pixel_offset, max_texture_offset),
+                        1.0f, NULL, 0.0f, 0.0f);
+    }
+    flush_layer_batch(&batch);
 
-        float vertices[] = {
-            -1.0f, -1.0f,  tex_offset, 1.0f,
-             1.0f, -1.0f,  tex_offset + viewport_width_in_texture, 1.0f,
-             1.0f,  1.0f,  tex_offset + viewport_width_in_texture, 0.0f,
-            -1.0f,  1.0f,  tex_offset, 0.0f,
-        };
+    // Leave unit 0 active for texture uploads and blur passes
+    glActiveTexture(GL_TEXTURE0);
 
-        glBindBuffer(GL_ARRAY_BUFFER, state.vbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+    if (scaled) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, output->width, output->height);
+        glDisable(GL_BLEND);
+        glUseProgram(state.copy_program);
+        draw_render_target_quad(state.copy_program, output->scaled_target);
+    }
+    if (timed) {
+        state.end_query(GL_TIME_ELAPSED_EXT);
+        output->gpu_query_pending = 1;
+    }
 
-        glVertexAttribPointer(pos_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(pos_attrib);
-        glVertexAttribPointer(tex_attrib, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-        glEnableVertexAttribArray(tex_attrib);
+    // Keep the frame an animation settled on for the next start
+    if (!output->animating && !scaled) {
+        save_output_snapshot(output, current_time);
+    }
 
-        // Bind single texture
-        glBindTexture(GL_TEXTURE_2D, state.texture);
-        glUniform1i(state.u_texture, 0);
-        glUniform1f(state.u_opacity, 1.0f);
+    double draw_done = get_time();
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state.ebo);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
+    // The next frame is paced by the callback that the swap's commit carries
+    if (output->animating) {
+        request_output_frame(output);
+    } else {
+        // Idle gaps are not missed frames
+        output->last_frame_done = 0.0;
     }
+    request_presentation_feedback(output);
 
     // Swap buffers with vsync control
     if (config.vsync) {
@@ -882,7 +3204,13 @@ void render_frame() {
     } else {
         eglSwapInterval(state.egl_display, 0);
     }
-    eglSwapBuffers(state.egl_display, state.egl_surface);
+    swap_output_buffers(output);
+
+    double swap_done = get_time();
+    stats_record_frame(&state.stats,
+                       (update_done - current_time) * 1000.0,
+                       (draw_done - update_done) * 1000.0,
+                       (swap_done - draw_done) * 1000.0);
 
     // FPS tracking for debug
     if (config.debug) {
@@ -894,291 +3222,411 @@ void render_frame() {
         }
     }
 
-    // Request next frame if animating
-    if (state.animating && !state.frame_callback) {
-        state.frame_callback = wl_surface_frame(state.surface);
-        wl_callback_add_listener(state.frame_callback, &frame_listener, NULL);
-        wl_surface_commit(state.surface);
-    }
-
-    state.last_frame_time = current_time;
+    output->last_frame_time = current_time;
+    return 1;
 }
 
-// Get the maximum workspace number from Hyprland
-int detect_max_workspaces() {
-    // Using fork/exec for better security than popen
-    // This avoids shell injection vulnerabilities
-    int pipefd[2];
-    pid_t pid;
-
-    if (pipe(pipefd) == -1) {
-        return 10; // Default fallback
-    }
+// Address of one of Hyprland's sockets (.socket.sock for requests, .socket2.sock for events)
+static int hyprland_socket_addr(struct sockaddr_un *addr, const char *name) {
+    const char *sig = getenv("HYPRLAND_INSTANCE_SIGNATURE");
+    if (!sig) return -1;
 
-    pid = fork();
-    if (pid == -1) {
-        close(pipefd[0]);
-        close(pipefd[1]);
-        return 10; // Default fallback
+    const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (!runtime_dir) {
+        runtime_dir = "/run/user/1000";
     }
 
-    if (pid == 0) {
-        // Child process
-        close(pipefd[0]); // Close read end
-        dup2(pipefd[1], STDOUT_FILENO);
-        dup2(pipefd[1], STDERR_FILENO);
-        close(pipefd[1]);
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    snprintf(addr->sun_path, sizeof(addr->sun_path), "%s/hypr/%s/%s", runtime_dir, sig, name);
+    return 0;
+}
 
-        // Execute hyprctl directly without shell
-        char *args[] = {"hyprctl", "workspaces", NULL};
-        execvp("hyprctl", args);
+// Connect to Hyprland IPC
+int connect_hyprland_ipc() {
+    state.ipc_fd = -1;
 
-        // If exec fails, exit child
-        _exit(1);
+    struct sockaddr_un addr;
+    if (hyprland_socket_addr(&addr, ".socket2.sock") < 0) {
+        fprintf(stderr, "Not running under Hyprland\n");
+        return -1;
     }
 
-    // Parent process
-    close(pipefd[1]); // Close write end
+    state.ipc_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (state.ipc_fd < 0) return -1;
 
-    FILE *fp = fdopen(pipefd[0], "r");
-    if (!fp) {
-        close(pipefd[0]);
-        waitpid(pid, NULL, 0);
-        return 10;
+    if (connect(state.ipc_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(state.ipc_fd);
+        state.ipc_fd = -1;
+        return -1;
     }
 
-    char buffer[256];
+    // Make non-blocking
+    fcntl(state.ipc_fd, F_SETFL, O_NONBLOCK);
+
+    return 0;
+}
+
+// Highest workspace id in a j/workspaces reply; special workspaces have negative ids
+static int parse_max_workspace_id(const char *json, size_t length) {
     int max_ws = 0;
+    const char *end = json + length;
 
-    // Parse the output looking for workspace IDs
-    while (fgets(buffer, sizeof(buffer), fp)) {
-        // Look for lines like "workspace ID X"
-        char *id_str = strstr(buffer, "workspace ID ");
-        if (id_str) {
-            int ws_id = 0;
-            if (sscanf(id_str, "workspace ID %d", &ws_id) == 1) {
-                if (ws_id > max_ws) {
-                    max_ws = ws_id;
-                }
-            }
+    for (const char *p = json; p + 5 <= end; p++) {
+        if (memcmp(p, "\"id\":", 5) != 0) continue;
+
+        p += 5;
+        while (p < end && *p == ' ') p++;
+        int ws_id = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            ws_id = ws_id * 10 + (*p++ - '0');
         }
+        if (ws_id > max_ws) max_ws = ws_id;
     }
-    fclose(fp);
-    waitpid(pid, NULL, 0);
+    return max_ws;
+}
 
-    if (max_ws > 0) {
-        // Always use at least 10 workspaces to avoid breaking parallax
-        if (max_ws < 10) {
-            max_ws = 10;
-        }
-        if (config.debug) {
-            printf("Detected max workspace: %d\n", max_ws);
+// Workspaces marked "hasfullscreen": true in a j/workspaces reply; each object lists its
+// id before the flag. Returns how many were stored in workspaces.
+static int parse_fullscreen_workspaces(const char *json, size_t length, int *workspaces, int max) {
+    int count = 0, ws_id = 0;
+    const char *end = json + length;
+
+    for (const char *p = json; p + 16 <= end && count < max; p++) {
+        if (memcmp(p, "\"id\":", 5) == 0) {
+            p += 5;
+            while (p < end && *p == ' ') p++;
+            int sign = 1;
+            if (p < end && *p == '-') {
+                sign = -1;
+                p++;
+            }
+            ws_id = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                ws_id = ws_id * 10 + (*p++ - '0');
+            }
+            ws_id *= sign;
+            p--;
+        } else if (memcmp(p, "\"hasfullscreen\":", 16) == 0) {
+            p += 16;
+            while (p < end && *p == ' ') p++;
+            if (p + 4 <= end && memcmp(p, "true", 4) == 0) workspaces[count++] = ws_id;
         }
-        return max_ws;
     }
+    return count;
+}
 
-    // Try to check bindings as fallback (simpler parsing)
-    if (pipe(pipefd) == -1) {
-        return 10;
+// Ask Hyprland for its workspaces without blocking; the reply is handled in the main loop.
+// A request made while one is in flight is repeated once that reply arrives, since it
+// may have been answered before the workspace change that prompted the new request.
+static void request_workspace_count(void) {
+    if (state.workspace_query_fd >= 0) {
+        state.workspace_query_stale = 1;
+        return;
     }
 
-    pid = fork();
-    if (pid == -1) {
-        close(pipefd[0]);
-        close(pipefd[1]);
-        return 10;
+    struct sockaddr_un addr;
+    if (hyprland_socket_addr(&addr, ".socket.sock") < 0) return;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return;
+
+    const char *request = "j/workspaces";
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        write(fd, request, strlen(request)) != (ssize_t)strlen(request)) {
+        if (config.debug) {
+            printf("Workspace query failed: %s\n", strerror(errno));
+        }
+        close(fd);
+        return;
     }
 
-    if (pid == 0) {
-        // Child process
-        close(pipefd[0]);
-        dup2(pipefd[1], STDOUT_FILENO);
-        dup2(pipefd[1], STDERR_FILENO);
-        close(pipefd[1]);
+    state.workspace_query_fd = fd;
+    state.workspace_query_stale = 0;
+}
 
-        char *args[] = {"hyprctl", "binds", NULL};
-        execvp("hyprctl", args);
-        _exit(1);
+static void apply_power_profile(void);
+
+// Read the workspace reply; Hyprland closes the connection once it is complete
+static void process_workspace_reply(void) {
+    if (linebuf_fill(&state.workspace_reply, state.workspace_query_fd) != LINEBUF_CLOSED) return;
+
+    int max_ws = parse_max_workspace_id(state.workspace_reply.data, state.workspace_reply.length);
+
+    // Seeds fullscreen state that predates our event connection; later fullscreen>> events
+    // make a reply in flight stale, so it is only trusted if none arrived
+    if (!state.workspace_query_stale) {
+        int workspaces[MAX_FULLSCREEN_WORKSPACES];
+        int count = parse_fullscreen_workspaces(state.workspace_reply.data, state.workspace_reply.length,
+                                                workspaces, MAX_FULLSCREEN_WORKSPACES);
+        if (count != state.fullscreen_count ||
+            memcmp(workspaces, state.fullscreen_workspaces, count * sizeof(int)) != 0) {
+            memcpy(state.fullscreen_workspaces, workspaces, count * sizeof(int));
+            state.fullscreen_count = count;
+            mark_outputs_dirty();
+            apply_power_profile();
+        }
     }
+    close(state.workspace_query_fd);
+    state.workspace_query_fd = -1;
+    linebuf_free(&state.workspace_reply);
 
-    // Parent process
-    close(pipefd[1]);
+    // Always use at least 10 workspaces to avoid breaking parallax
+    if (max_ws > 0) {
+        config.max_workspaces = max_ws < 10 ? 10 : max_ws;
+        if (config.debug) {
+            printf("Maximum workspaces detected: %d\n", config.max_workspaces);
+        }
+    }
 
-    fp = fdopen(pipefd[0], "r");
-    if (!fp) {
-        close(pipefd[0]);
-        waitpid(pid, NULL, 0);
-        return 10;
+    if (state.workspace_query_stale) {
+        request_workspace_count();
     }
+}
 
-    max_ws = 0;
+// Retarget every layer's animation on one output toward a workspace
+// Shared by the Hyprland event handler and --bench so both drive identical animation code
+void start_workspace_animation(struct output *output, int workspace) {
+    double now = get_time();
+    output->anim_epoch = now;  // Keeps shader times small enough for float precision
 
-    // Look for workspace bindings
-    while (fgets(buffer, sizeof(buffer), fp)) {
-        // Look for lines containing "workspace,"
-        if (strstr(buffer, "workspace,")) {
-            // Try to extract workspace number
-            int ws_num = 0;
-            char *ws_str = strstr(buffer, "workspace,");
-                if (ws_str && sscanf(ws_str, "workspace, %d", &ws_num) == 1) {
-                    if (ws_num > max_ws && ws_num <= 20) {  // Sanity check
-                        max_ws = ws_num;
-                    }
+    // Power profiles may shorten the animation; a scale of 0 jumps straight to the target,
+    // as does a switch to a workspace a fullscreen window covers
+    float time_scale = workspace_is_fullscreen(workspace) ? 0.0f : active_profile()->duration_scale;
+
+    if (config.multi_layer_mode) {
+        // Multi-layer mode: set new targets for each layer with individual timing.
+        // Layers mid-animation head for the new target from where they are now.
+        anim_table_t *anims = output_layer_anims(output);
+        float base_target = (workspace - 1) * config.shift_per_workspace;
+        for (int i = 0; i < state.layer_count && i < anims->count; i++) {
+            struct layer *layer = &state.layers[i];
+            anim_table_retarget(anims, i, base_target * layer->shift_multiplier, now,
+                                layer->animation_delay * time_scale,
+                                layer->animation_duration * time_scale, layer->easing);
+
+            // Upload the tiles this pan crosses now, rather than mid-animation
+            if (layer->tiles) {
+                if (anims->target[i] != anims->start[i]) {
+                    layer->tiles->direction = anims->target[i] > anims->start[i] ? 1 : -1;
                 }
+                update_layer_tiles(layer);
             }
         }
-        fclose(fp);
-        waitpid(pid, NULL, 0);
+    } else {
+        // Single layer mode (backward compatible)
+        anim_table_retarget(&output->image_anim, 0, (workspace - 1) * config.shift_per_workspace,
+                            now, config.animation_delay * time_scale,
+                            config.animation_duration * time_scale, config.easing);
+    }
 
-        if (max_ws > 0) {
-            if (config.debug) {
-                printf("Detected max workspace from bindings: %d\n", max_ws);
-            }
-            return max_ws;
-        }
+    output->animating = 1;
+    output->previous_workspace = output->current_workspace;  // Track the previous workspace
+    output->current_workspace = workspace;
 
-    // Default to 10 workspaces if we can't detect
     if (config.debug) {
-        printf("Could not detect max workspaces, defaulting to 10\n");
+        printf("Workspace changed to %d on %s\n", workspace, output->name ? output->name : "output");
     }
-    return 10;
 }
 
-// Connect to Hyprland IPC
-int connect_hyprland_ipc() {
-    const char *sig = getenv("HYPRLAND_INSTANCE_SIGNATURE");
-    if (!sig) {
-        fprintf(stderr, "Not running under Hyprland\n");
-        return -1;
+static struct output *find_output_by_name(const char *name) {
+    for (struct output *output = state.outputs; output; output = output->next) {
+        if (output->name && strcmp(output->name, name) == 0) {
+            return output;
+        }
     }
+    return NULL;
+}
 
-    const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
-    if (!runtime_dir) {
-        runtime_dir = "/run/user/1000";
+// Output that Hyprland's workspace>> events refer to: the focused monitor
+static struct output *event_output(void) {
+    return state.focused_output ? state.focused_output : state.outputs;
+}
+
+// Animate an output if the workspace it shows actually changed
+static void switch_output_workspace(struct output *output, int workspace) {
+    if (output && workspace > 0 && workspace != output->current_workspace) {
+        start_workspace_animation(output, workspace);
     }
+}
 
-    char socket_path[256];
-    snprintf(socket_path, sizeof(socket_path), "%s/hypr/%s/.socket2.sock", runtime_dir, sig);
+// A fullscreen window appeared on, or left, the workspace an output shows. Animations
+// under it can't be seen, so they jump to their targets; the output is redrawn as it is
+// uncovered, which includes anything that changed meanwhile.
+static void set_output_fullscreen(struct output *output, int fullscreen) {
+    if (!output) return;
+    set_workspace_fullscreen(output->current_workspace, fullscreen);
+
+    if (fullscreen) {
+        anim_table_t *anims = output_layer_anims(output);
+        for (int i = 0; i < anims->count; i++) {
+            if (anims->animating[i]) anim_table_set(anims, i, anims->target[i]);
+        }
+        if (output->image_anim.animating[0]) {
+            anim_table_set(&output->image_anim, 0, output->image_anim.target[0]);
+        }
+        output->animating = 0;
+    }
+    output->dirty = 1;
 
-    state.ipc_fd = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (state.ipc_fd < 0) return -1;
+    if (config.debug) {
+        printf("Workspace %d on %s %s fullscreen\n", output->current_workspace,
+               output->name ? output->name : "output", fullscreen ? "went" : "left");
+    }
+}
 
-    struct sockaddr_un addr = {0};
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+// Pick the render profile for the current battery state and whether a fullscreen window
+// covers the focused output
+static void apply_power_profile(void) {
+    if (!config.power_policy) return;
 
-    if (connect(state.ipc_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        close(state.ipc_fd);
-        return -1;
-    }
+    struct output *focused = event_output();
+    int fullscreen = focused && workspace_is_fullscreen(focused->current_workspace);
+    power_profile_id_t profile = fullscreen ? POWER_PROFILE_FULLSCREEN :
+                                 state.on_battery ? POWER_PROFILE_BATTERY : POWER_PROFILE_AC;
+    if (profile == state.power_profile) return;
+    state.power_profile = profile;
 
-    // Make non-blocking
-    fcntl(state.ipc_fd, F_SETFL, O_NONBLOCK);
+    // Missed frames are counted against the cap in effect
+    int fps = frame_rate_cap();
+    if (fps > 0) state.stats.frame_period_ms = 1000.0 / fps;
 
-    return 0;
+    // Layers may be left out or come back, and a pause may have ended
+    mark_outputs_dirty();
+    if (config.debug) {
+        printf("Power profile: %s\n", power_profile_name(profile));
+    }
+}
+
+// Re-read the battery state when it is due. Returns the poll timeout until the next
+// read in milliseconds, or -1 without --power-policy.
+static int update_power_state(void) {
+    if (!config.power_policy) return -1;
+
+    double now = get_time();
+    if (state.power_checked_at == 0.0 || now - state.power_checked_at >= POWER_POLL_INTERVAL) {
+        state.power_checked_at = now;
+        int on_battery = power_on_battery(POWER_SUPPLY_DIR);
+        if (on_battery >= 0) state.on_battery = on_battery;
+        apply_power_profile();
+    }
+    return (int)ceil((state.power_checked_at + POWER_POLL_INTERVAL - now) * 1000.0);
 }
 
 // Process Hyprland IPC events
 void process_ipc_events() {
-    char buffer[1024];
-    ssize_t n = read(state.ipc_fd, buffer, sizeof(buffer) - 1);
-
-    if (n > 0) {
-        buffer[n] = '\0';
-
-        // Parse workspace events
-        char *line = strtok(buffer, "\n");
-        while (line) {
-            if (strncmp(line, "workspace>>", 11) == 0) {
-                int workspace = atoi(line + 11);
-
-                // Only animate if this is a real workspace change
-                if (workspace != state.current_workspace && workspace > 0) {
-                    if (config.multi_layer_mode) {
-                        // Multi-layer mode: update each layer's animation state
-                        double now = get_time();
-
-                        // Set new targets for each layer with individual timing
-                        float base_target = (workspace - 1) * config.shift_per_workspace;
-                        for (int i = 0; i < state.layer_count; i++) {
-                            struct layer *layer = &state.layers[i];
-
-                            // If currently animating, update current position
-                            if (layer->animating) {
-                                double elapsed = now - layer->animation_start - layer->animation_delay;
-                                if (elapsed > 0) {
-                                    float t = fminf(elapsed / layer->animation_duration, 1.0f);
-                                    float eased = apply_easing(t, layer->easing);
-                                    layer->current_offset = layer->start_offset +
-                                        (layer->target_offset - layer->start_offset) * eased;
-                                }
-                            }
-
-                            // Set new animation parameters
-                            layer->start_offset = layer->current_offset;
-                            layer->target_offset = base_target * layer->shift_multiplier;
-                            layer->animation_start = now;
-                            layer->animating = 1;
-                        }
-                    } else {
-                        // Single layer mode (backward compatible)
-                        if (state.animating) {
-                            double elapsed = get_time() - state.animation_start;
-                            float t = fminf(elapsed / config.animation_duration, 1.0f);
-                            float eased = apply_easing(t, config.easing);
-                            state.current_offset = state.start_offset + (state.target_offset - state.start_offset) * eased;
-                        }
+    // Drain everything that arrived, so events split across reads are reassembled
+    long received = linebuf_fill(&state.ipc_events, state.ipc_fd);
+
+    // A burst of workspace>> events (e.g. scrolling through workspaces) only animates
+    // each output toward the last one; focus changes flush the pending switch first
+    struct output *pending_output = NULL;
+    int pending_workspace = 0;
+
+    char *line;
+    while ((line = linebuf_next(&state.ipc_events))) {
+        if (strncmp(line, "workspace>>", 11) == 0) {
+            struct output *output = event_output();
+            if (pending_output && pending_output != output) {
+                switch_output_workspace(pending_output, pending_workspace);
+            }
+            pending_output = output;
+            pending_workspace = atoi(line + 11);
+        } else if (strncmp(line, "fullscreen>>", 12) == 0) {
+            // fullscreen>>1 when a window on the focused workspace went fullscreen, 0 when it
+            // left; a pending switch decides which workspace that is
+            if (pending_output) {
+                switch_output_workspace(pending_output, pending_workspace);
+                pending_output = NULL;
+            }
+            set_output_fullscreen(event_output(), atoi(line + 12) != 0);
+            if (state.workspace_query_fd >= 0) state.workspace_query_stale = 1;
+        } else if (strncmp(line, "createworkspace>>", 17) == 0 ||
+                   strncmp(line, "destroyworkspace>>", 18) == 0) {
+            if (line[0] == 'd') set_workspace_fullscreen(atoi(line + 18), 0);
+            request_workspace_count();
+        } else if (strncmp(line, "focusedmon>>", 12) == 0) {
+            if (pending_output) {
+                switch_output_workspace(pending_output, pending_workspace);
+                pending_output = NULL;
+            }
 
-                        state.start_offset = state.current_offset;
-                        state.target_offset = (workspace - 1) * config.shift_per_workspace;
-                    }
+            // focusedmon>>MONITOR,WORKSPACE: later workspace>> events apply to MONITOR
+            char *monitor = line + 12;
+            char *comma = strchr(monitor, ',');
+            if (comma) *comma = '\0';
+
+            struct output *output = find_output_by_name(monitor);
+            if (output) {
+                state.focused_output = output;
+                if (comma) switch_output_workspace(output, atoi(comma + 1));
+            } else if (config.debug) {
+                printf("Focus moved to unknown monitor '%s'\n", monitor);
+            }
+        }
+    }
 
-                    state.animation_start = get_time() + config.animation_delay;
-                    state.animating = 1;
-                    state.previous_workspace = state.current_workspace;  // Track the previous workspace
-                    state.current_workspace = workspace;
+    // Only animate if this is a real workspace change
+    if (pending_output) {
+        switch_output_workspace(pending_output, pending_workspace);
+    }
 
-                    if (config.debug) {
-                        printf("Workspace changed to %d (offset: %.2f -> %.2f)\n",
-                               workspace, state.start_offset, state.target_offset);
-                    }
+    // Focus or workspace changes may have moved a fullscreen window onto or off the
+    // focused output
+    apply_power_profile();
 
-                    // Request frame
-                    if (!state.frame_callback) {
-                        state.frame_callback = wl_surface_frame(state.surface);
-                        wl_callback_add_listener(state.frame_callback, &frame_listener, NULL);
-                        wl_surface_commit(state.surface);
-                    }
-                }
-            }
-            line = strtok(NULL, "\n");
-        }
+    // Out of memory: the rest stays in the socket and is read on the next wakeup
+    if (received == LINEBUF_NO_MEMORY) {
+        fprintf(stderr, "Warning: Out of memory buffering Hyprland events\n");
+    }
+
+    // Hyprland went away; stop polling a closed socket
+    if (received == LINEBUF_CLOSED) {
+        fprintf(stderr, "Lost connection to Hyprland IPC\n");
+        close(state.ipc_fd);
+        state.ipc_fd = -1;
+        linebuf_free(&state.ipc_events);
     }
 }
 
 // Layer surface configure
 static void layer_surface_configure(void *data, struct zwlr_layer_surface_v1 *layer_surface,
                                     uint32_t serial, uint32_t width, uint32_t height) {
-    state.width = width;
-    state.height = height;
-    state.configured = 1;  // Mark as configured
+    struct output *output = data;
+    int first_configure = !output->configured;
+    output->width = width;
+    output->height = height;
+    output->configured = 1;  // Mark as configured
+
+    // Textures were sized for the previous outputs; bring back resolution if one grew
+    reload_undersized_layers();
 
     zwlr_layer_surface_v1_ack_configure(layer_surface, serial);
 
-    if (state.egl_window) {
-        wl_egl_window_resize(state.egl_window, width, height, 0, 0);
+    if (output->egl_window) {
+        wl_egl_window_resize(output->egl_window, width, height, 0, 0);
     }
 
-    glViewport(0, 0, width, height);
-    render_frame();
+    // Until the layers have decoded, the first frame can show the last session's instead
+    if (first_configure) {
+        load_output_snapshot(output);
+    }
+    output->snapshot_drawn = 0;
+
+    output->dirty = 1;
+    render_frame(output);
 
     // Commit the surface to display the rendered frame
-    wl_surface_commit(state.surface);
+    wl_surface_commit(output->surface);
     wl_display_flush(state.display);
 }
 
+static void output_destroy_surface(struct output *output);
+
 static void layer_surface_closed(void *data, struct zwlr_layer_surface_v1 *layer_surface) {
-    state.running = 0;
+    (void)layer_surface;
+    // The compositor dropped this output's surface (usually the monitor went away)
+    output_destroy_surface(data);
 }
 
 static const struct zwlr_layer_surface_v1_listener layer_surface_listener = {
@@ -1186,19 +3634,243 @@ static const struct zwlr_layer_surface_v1_listener layer_surface_listener = {
     .closed = layer_surface_closed,
 };
 
+// Create the layer surface and EGL window surface for an output
+static int output_create_surface(struct output *output) {
+    if (output->surface || !state.compositor || !state.layer_shell ||
+        state.egl_context == EGL_NO_CONTEXT) {
+        return 0;
+    }
+
+    output->surface = wl_compositor_create_surface(state.compositor);
+    output->layer_surface = zwlr_layer_shell_v1_get_layer_surface(
+        state.layer_shell, output->surface, output->wl_output,
+        ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND, "hyprlax");
+
+    zwlr_layer_surface_v1_add_listener(output->layer_surface, &layer_surface_listener, output);
+    zwlr_layer_surface_v1_set_exclusive_zone(output->layer_surface, -1);
+    zwlr_layer_surface_v1_set_anchor(output->layer_surface,
+        ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP |
+        ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM |
+        ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT |
+        ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT);
+
+    // Create EGL window with initial dimensions (will be resized on configure)
+    output->egl_window = wl_egl_window_create(output->surface, 1, 1);
+    output->egl_surface = eglCreateWindowSurface(state.egl_display, state.egl_config,
+                                                 (EGLNativeWindowType)output->egl_window, NULL);
+    if (output->egl_surface == EGL_NO_SURFACE) {
+        fprintf(stderr, "Failed to create EGL surface for output %s\n",
+                output->name ? output->name : "(unnamed)");
+        output_destroy_surface(output);
+        return -1;
+    }
+
+    // Commit the surface to trigger configuration from compositor
+    wl_surface_commit(output->surface);
+    return 0;
+}
+
+static void output_destroy_surface(struct output *output) {
+    if (output->egl_surface != EGL_NO_SURFACE) {
+        if (eglGetCurrentSurface(EGL_DRAW) == output->egl_surface) {
+            eglMakeCurrent(state.egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, state.egl_context);
+        }
+        eglDestroySurface(state.egl_display, output->egl_surface);
+        output->egl_surface = EGL_NO_SURFACE;
+    }
+    if (output->frame_callback) {
+        wl_callback_destroy(output->frame_callback);
+        output->frame_callback = NULL;
+    }
+    if (output->feedback) {
+        wp_presentation_feedback_destroy(output->feedback);
+        output->feedback = NULL;
+    }
+    if (output->egl_window) {
+        wl_egl_window_destroy(output->egl_window);
+        output->egl_window = NULL;
+    }
+    if (output->layer_surface) {
+        zwlr_layer_surface_v1_destroy(output->layer_surface);
+        output->layer_surface = NULL;
+    }
+    if (output->surface) {
+        wl_surface_destroy(output->surface);
+        output->surface = NULL;
+    }
+    release_scaled_target(output);
+    release_output_snapshot(output);
+    if (output->gpu_query) {
+        state.delete_queries(1, &output->gpu_query);
+        output->gpu_query = 0;
+        output->gpu_query_pending = 0;
+    }
+    output->configured = 0;
+    output->animating = 0;
+}
+
+// Outputs with a surface still waiting for their first configure
+static int outputs_awaiting_configure(void) {
+    int count = 0;
+    for (struct output *output = state.outputs; output; output = output->next) {
+        if (output->surface && !output->configured) count++;
+    }
+    return count;
+}
+
+// Track a new output; it animates its own copy of every layer's offset
+static struct output *output_create(struct wl_output *wl_output, uint32_t registry_name) {
+    struct output *output = calloc(1, sizeof(struct output));
+    if (!output || anim_table_resize(&output->image_anim, 1) < 0) {
+        fprintf(stderr, "Error: Failed to allocate output\n");
+        free(output);
+        return NULL;
+    }
+    output->wl_output = wl_output;
+    output->registry_name = registry_name;
+    output->egl_surface = EGL_NO_SURFACE;
+    output->current_workspace = 1;
+    output->previous_workspace = 1;
+    output->last_frame_time = get_time();
+    resscale_init(&output->resscale, config.render_scale_min);
+
+    output->next = state.outputs;
+    state.outputs = output;
+    return output;
+}
+
+static void output_destroy(struct output *output) {
+    for (struct output **link = &state.outputs; *link; link = &(*link)->next) {
+        if (*link == output) {
+            *link = output->next;
+            break;
+        }
+    }
+    if (state.focused_output == output) {
+        state.focused_output = NULL;
+    }
+
+    output_destroy_surface(output);
+    if (output->wl_output) {
+        wl_output_destroy(output->wl_output);
+    }
+    anim_table_free(&output->anims);
+    anim_table_free(&output->image_anim);
+    free(output->name);
+    free(output);
+}
+
+// wl_output events; only the connector name matters (it matches Hyprland's monitor names)
+static void output_geometry(void *data, struct wl_output *wl_output, int32_t x, int32_t y,
+                            int32_t physical_width, int32_t physical_height, int32_t subpixel,
+                            const char *make, const char *model, int32_t transform) {
+    (void)data;
+    (void)wl_output;
+    (void)x;
+    (void)y;
+    (void)physical_width;
+    (void)physical_height;
+    (void)subpixel;
+    (void)make;
+    (void)model;
+    (void)transform;
+}
+
+static void output_mode(void *data, struct wl_output *wl_output, uint32_t flags,
+                        int32_t width, int32_t height, int32_t refresh) {
+    (void)wl_output;
+    (void)width;
+    (void)height;
+    struct output *output = data;
+    // Refresh is in mHz; presentation feedback replaces it with the measured period
+    if ((flags & WL_OUTPUT_MODE_CURRENT) && refresh > 0 && !output->last_presented) {
+        output->refresh_period = 1000.0 / refresh;
+    }
+}
+
+static void output_done(void *data, struct wl_output *wl_output) {
+    (void)data;
+    (void)wl_output;
+}
+
+static void output_scale(void *data, struct wl_output *wl_output, int32_t factor) {
+    (void)data;
+    (void)wl_output;
+    (void)factor;
+}
+
+static void output_name(void *data, struct wl_output *wl_output, const char *name) {
+    (void)wl_output;
+    struct output *output = data;
+    free(output->name);
+    output->name = strdup(name);
+}
+
+static void output_description(void *data, struct wl_output *wl_output, const char *description) {
+    (void)data;
+    (void)wl_output;
+    (void)description;
+}
+
+static const struct wl_output_listener output_listener = {
+    .geometry = output_geometry,
+    .mode = output_mode,
+    .done = output_done,
+    .scale = output_scale,
+    .name = output_name,
+    .description = output_description,
+};
+
+static void presentation_clock_id(void *data, struct wp_presentation *presentation, uint32_t clk_id) {
+    (void)data;
+    (void)presentation;
+    state.presentation_clock = clk_id;
+}
+
+static const struct wp_presentation_listener presentation_listener = {
+    .clock_id = presentation_clock_id,
+};
+
 // Registry handlers
 static void registry_global(void *data, struct wl_registry *registry, uint32_t id,
                            const char *interface, uint32_t version) {
+    (void)data;
     if (strcmp(interface, wl_compositor_interface.name) == 0) {
         state.compositor = wl_registry_bind(registry, id, &wl_compositor_interface, 4);
     } else if (strcmp(interface, wl_output_interface.name) == 0) {
-        state.output = wl_registry_bind(registry, id, &wl_output_interface, 1);
+        // Version 4 adds the name event used to match Hyprland's focusedmon>> events
+        struct wl_output *wl_output = wl_registry_bind(registry, id, &wl_output_interface,
+                                                       version < 4 ? version : 4);
+        struct output *output = output_create(wl_output, id);
+        if (!output) {
+            wl_output_destroy(wl_output);
+            return;
+        }
+        wl_output_add_listener(wl_output, &output_listener, output);
+
+        // Hotplugged after startup: set up its surface right away
+        output_create_surface(output);
     } else if (strcmp(interface, zwlr_layer_shell_v1_interface.name) == 0) {
         state.layer_shell = wl_registry_bind(registry, id, &zwlr_layer_shell_v1_interface, 1);
+    } else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+        state.presentation = wl_registry_bind(registry, id, &wp_presentation_interface, 1);
+        wp_presentation_add_listener(state.presentation, &presentation_listener, NULL);
     }
 }
 
-static void registry_global_remove(void *data, struct wl_registry *registry, uint32_t id) {}
+static void registry_global_remove(void *data, struct wl_registry *registry, uint32_t id) {
+    (void)data;
+    (void)registry;
+    for (struct output *output = state.outputs; output; output = output->next) {
+        if (output->registry_name == id) {
+            if (config.debug) {
+                printf("Output %s removed\n", output->name ? output->name : "(unnamed)");
+            }
+            output_destroy(output);
+            return;
+        }
+    }
+}
 
 static const struct wl_registry_listener registry_listener = {
     .global = registry_global,
@@ -1218,7 +3890,16 @@ void print_usage(const char *prog) {
     printf("                                   sine, expo, circ, back, elastic, snap\n");
     printf("  -f, --scale <factor>     Scale factor for panning room (default: 1.5)\n");
     printf("  -v, --vsync <0|1>        Enable vsync (default: 1)\n");
-    printf("  --fps <rate>             Target FPS (default: 144)\n");
+    printf("  --fps <rate>             Maximum FPS (default: 144)\n");
+    printf("  --no-cache               Always decode images (skip the on-disk texture cache)\n");
+    printf("  --compress               Store layers as S3TC (BC1/BC3) textures when supported\n");
+    printf("  --dmabuf                 Import layers as dma-buf EGLImages instead of copying them\n");
+    printf("  --gpu-animation          Ease layer offsets in the compositing shader instead of on the CPU\n");
+    printf("  --texture-budget <MiB>   Evict textures of hidden or covered layers past this (default: off)\n");
+    printf("  --dynamic-resolution     Draw animated frames at a lower resolution when the GPU falls behind\n");
+    printf("  --render-scale-min <0.1-1> Lowest resolution it may drop to (default: %.1f)\n", RESSCALE_MIN_DEFAULT);
+    printf("  --power-policy           Apply the config's ac/battery/fullscreen render profiles\n");
+    printf("  --deferred-mips          Show layers from level 0 and upload mipmaps between animations\n");
     printf("  --debug                  Enable debug output\n");
     printf("  --version                Show version information\n");
     printf("  -h, --help               Show this help\n");
@@ -1231,6 +3912,13 @@ void print_usage(const char *prog) {
     printf("                           duration: per-layer animation duration (optional)\n");
     printf("                           blur: blur amount for depth (0.0-10.0, default 0.0)\n");
     printf("  --config <file>          Load layers from config file\n");
+    printf("  --watch-config           Re-apply the config file whenever it is saved\n");
+    printf("  --blur-downscale <0.1-1> Resolution of cached blur textures (default: 0.5)\n");
+    printf("\nBenchmark Mode:\n");
+    printf("  --bench                  Render offscreen (no compositor) and report frame timings\n");
+    printf("  --bench-size <WxH>       Offscreen resolution (default: 1920x1080)\n");
+    printf("  --bench-script <list>    Workspace switches to replay (default: %s)\n", BENCH_DEFAULT_SCRIPT);
+    printf("  --bench-blur <amount>    Override blur on every layer\n");
     printf("\nExamples:\n");
     printf("  # Single image (classic mode)\n");
     printf("  %s wallpaper.jpg\n", prog);
@@ -1240,311 +3928,775 @@ void print_usage(const char *prog) {
     printf("  %s --layer background.png:0.3:1.0:expo:0:1.0:3.0 --layer midground.png:0.6:0.8:expo:0.1:1.0:1.0 --layer foreground.png:1.0:1.0\n", prog);
 }
 
-void print_version() {
-    printf("hyprlax %s\n", HYPRLAX_VERSION);
-    printf("Smooth parallax wallpaper animations for Hyprland\n");
+void print_version() {
+    printf("hyprlax %s\n", HYPRLAX_VERSION);
+    printf("Smooth parallax wallpaper animations for Hyprland\n");
+}
+
+// Where config_parse_file() puts layers: an array of GL layers, grown as needed
+struct layer_list {
+    struct layer **layers;
+    int *count;
+    int *max;
+};
+
+static int append_config_layer(const config_layer_t *entry, void *data) {
+    struct layer_list *list = data;
+
+    // Initialize layer array if needed
+    if (!*list->layers) {
+        *list->max = INITIAL_MAX_LAYERS;
+        *list->layers = calloc(*list->max, sizeof(struct layer));
+        if (!*list->layers) {
+            fprintf(stderr, "Error: Failed to allocate memory for layers\n");
+            free(entry->image_path);
+            return -1;
+        }
+        *list->count = 0;
+        config.multi_layer_mode = 1;
+    }
+
+    // Grow the layer array if needed
+    if (*list->count >= *list->max) {
+        // Check for integer overflow and reasonable limits
+        if (*list->max > INT_MAX / 2 || *list->max > 1000) {
+            fprintf(stderr, "Error: Maximum layer limit reached (%d layers)\n", *list->max);
+            free(entry->image_path);
+            return -1;
+        }
+        int new_max = *list->max * 2;
+
+        // Check multiplication overflow for size calculation
+        if (new_max > SIZE_MAX / sizeof(struct layer)) {
+            fprintf(stderr, "Error: Layer array size would exceed memory limits\n");
+            free(entry->image_path);
+            return -1;
+        }
+
+        struct layer *new_layers = realloc(*list->layers, new_max * sizeof(struct layer));
+        if (!new_layers) {
+            fprintf(stderr, "Failed to allocate memory for %d layers\n", new_max);
+            free(entry->image_path);
+            return -1;
+        }
+        memset(new_layers + *list->max, 0, (new_max - *list->max) * sizeof(struct layer));
+        *list->layers = new_layers;
+        *list->max = new_max;
+    }
+
+    struct layer *layer = &(*list->layers)[*list->count];
+    layer->image_path = entry->image_path;
+    layer->from_config = 1;
+    layer->shift_multiplier = entry->shift_multiplier;
+    layer->opacity = entry->opacity;
+    layer->blur_amount = entry->blur_amount;
+    if (config.debug) {
+        fprintf(stderr, "Stored layer %d: blur_amount=%.2f\n", *list->count, layer->blur_amount);
+    }
+    // Set defaults for Phase 3 features
+    layer->easing = entry->easing;
+    layer->animation_delay = 0.0f;
+    layer->animation_duration = entry->animation_duration;
+    (*list->count)++;
+    return 0;
+}
+
+// Parse a config file, appending its layers to *layers (grown as needed) and applying the
+// global settings as they are read
+static int parse_config(const char *filename, struct layer **layers, int *layer_count,
+                        int *max_layers) {
+    struct layer_list list = { layers, layer_count, max_layers };
+    return config_parse_file(filename, append_config_layer, &list);
+}
+
+int parse_config_file(const char *filename) {
+    return parse_config(filename, &state.layers, &state.layer_count, &state.max_layers);
 }
 
-// Helper: Check if path is in a sensitive directory
-static int is_sensitive_path(const char *resolved_path) {
-    const char *sensitive_dirs[] = {
-        "/etc", "/sys", "/proc", "/dev",
-        "/boot", "/root", NULL
-    };
+// Move one output's layers to the current workspace with the (possibly new) shifts and timing.
+// from[i] is the row layer i had before the reload; freshly loaded layers (-1) start at their
+// target instead of sweeping in from the origin.
+static void retarget_reloaded_layers(struct output *output, const int *from) {
+    if (anim_table_remap(&output->anims, from, state.layer_count) < 0) {
+        fprintf(stderr, "Error: Failed to allocate animation state for %d layers\n",
+                state.layer_count);
+    }
+    float base_target = (output->current_workspace - 1) * config.shift_per_workspace;
+    for (int i = 0; i < output->anims.count; i++) {
+        if (from[i] >= 0) continue;
+        anim_table_set(&output->anims, i, base_target * state.layers[i].shift_multiplier);
+    }
+    start_workspace_animation(output, output->current_workspace);
+}
 
-    for (int i = 0; sensitive_dirs[i]; i++) {
-        size_t dir_len = strlen(sensitive_dirs[i]);
-        if (strncmp(resolved_path, sensitive_dirs[i], dir_len) == 0 &&
-            (resolved_path[dir_len] == '/' || resolved_path[dir_len] == '\0')) {
-            fprintf(stderr, "Error: Path validation failed - access to sensitive directory '%s' denied\n",
-                    sensitive_dirs[i]);
-            return 1;
+// Release a config layer that a reload dropped; it is no longer in state.layers
+static void release_reloaded_layer(struct layer *layer) {
+    if (layer->ipc_id) {
+        idmap_remove(&state.ipc_slots, layer->ipc_id);
+        ipc_remove_layer(state.ipc_ctx, layer->ipc_id);
+    }
+    release_layer_texture(layer);
+    release_layer_tiles(layer);
+    release_layer_blur(layer);
+    free(layer->image_path);
+}
+
+// Slots moved: re-index IPC ids and bring the hyprlax-ctl view of config layers up to date.
+// Layers of a scene that is still preloading stay out of it until they are shown.
+static void reindex_config_layers(void) {
+    for (int i = 0; i < state.layer_count; i++) {
+        struct layer *layer = &state.layers[i];
+        if (!state.ipc_ctx || !layer->from_config || layer->scene == SCENE_INCOMING) {
+            if (layer->ipc_id) idmap_put(&state.ipc_slots, layer->ipc_id, i);
+            continue;
         }
+        layer_t *ipc_layer = layer->ipc_id ? ipc_find_layer(state.ipc_ctx, layer->ipc_id) : NULL;
+        if (!ipc_layer) {
+            bind_ipc_layer(i, ipc_add_layer(state.ipc_ctx, layer->image_path,
+                                            layer->shift_multiplier, layer->opacity,
+                                            0.0f, 0.0f, i));
+            continue;
+        }
+        ipc_layer->scale = layer->shift_multiplier;
+        ipc_layer->opacity = layer->opacity;
+        ipc_layer->z_index = i;
+        ipc_layer->visible = true;
+        idmap_put(&state.ipc_slots, layer->ipc_id, i);
     }
-    return 0;
+    if (state.ipc_ctx) ipc_sort_layers(state.ipc_ctx);
 }
 
-// Helper: Resolve path for non-existent files
-static char *resolve_nonexistent_path(const char *path) {
-    char *path_copy = strdup(path);
-    if (!path_copy) {
-        fprintf(stderr, "Error: Path validation failed - memory allocation error\n");
-        return NULL;
+// Re-read the config file and apply it in place. Layers whose image is unchanged keep their
+// texture and blur cache and only take the new parameters, new images decode in the
+// background, and layers no longer listed are released; layers added with hyprlax-ctl stay
+// on top. If the file can't be parsed, nothing changes.
+// render_scale_min may have changed; outputs read it only when created
+static void apply_render_scale_min(void) {
+    for (struct output *output = state.outputs; output; output = output->next) {
+        resscale_set_min(&output->resscale, config.render_scale_min);
     }
+}
 
-    char *dir = dirname(path_copy);
-    char *resolved_dir = realpath(dir, NULL);
+static int reload_config(char *result, size_t size) {
+    if (!config.multi_layer_mode || !config.config_file_path) {
+        snprintf(result, size, "Error: No config file to reload (start with --config)\n");
+        return -1;
+    }
+    if (state.scene_pending) {
+        snprintf(result, size, "Error: A scene switch is under way, reload once it is shown\n");
+        return -1;
+    }
 
-    if (!resolved_dir) {
-        fprintf(stderr, "Error: Path validation failed - parent directory '%s' does not exist\n", dir);
-        free(path_copy);
-        return NULL;
+    // parse_config replaces config_file_path and applies settings as it reads them. Settings
+    // the file no longer sets go back to what they were before it was first read, and
+    // options that followed --config on the command line still win over it.
+    struct config saved = config;
+    char *path = strdup(config.config_file_path);
+    struct layer *fresh = NULL;
+    int fresh_count = 0, fresh_max = 0;
+    config_copy_settings(&config, &state.file_base, CONFIG_SET_FILE);
+    int parsed = path ? parse_config(path, &fresh, &fresh_count, &fresh_max) : -1;
+    free(path);
+    config_copy_settings(&config, &state.cli_settings, state.cli_overrides);
+    if (parsed < 0) {
+        char *file_path = config.config_file_path;
+        config = saved;
+        config.config_file_path = file_path;
+        for (int i = 0; i < fresh_count; i++) free(fresh[i].image_path);
+        free(fresh);
+        snprintf(result, size, "Error: Failed to parse %s, keeping the current layers\n",
+                 config.config_file_path);
+        return -1;
     }
 
-    // Construct the resolved path
-    char *base = basename((char *)path);
-    size_t path_len = strlen(resolved_dir) + strlen(base) + 2;
-    char *resolved_path = malloc(path_len);
-    if (!resolved_path) {
-        fprintf(stderr, "Error: Path validation failed - memory allocation error\n");
-        free(resolved_dir);
-        free(path_copy);
-        return NULL;
+    int live_count = state.layer_count;
+    int capacity = state.max_layers > 0 ? state.max_layers : INITIAL_MAX_LAYERS;
+    while (capacity < fresh_count + live_count) capacity *= 2;
+    struct layer *next = calloc(capacity, sizeof(struct layer));
+    int *taken = calloc(live_count + 1, sizeof(int));
+    int *from = calloc(capacity, sizeof(int));
+    if (!next || !taken || !from) {
+        free(next);
+        free(taken);
+        free(from);
+        for (int i = 0; i < fresh_count; i++) free(fresh[i].image_path);
+        free(fresh);
+        snprintf(result, size, "Error: Out of memory reloading config\n");
+        return -1;
+    }
+
+    struct layer *live = state.layers;
+    state.layers = next;
+    state.max_layers = capacity;
+    state.layer_count = 0;
+
+    int kept = 0, queued = 0, failed = 0;
+    for (int i = 0; i < fresh_count; i++) {
+        struct layer *spec = &fresh[i];
+        int match = -1;
+        for (int j = 0; j < live_count && match < 0; j++) {
+            if (!taken[j] && live[j].from_config && strcmp(live[j].image_path, spec->image_path) == 0) {
+                match = j;
+            }
+        }
+
+        struct layer *layer = &state.layers[state.layer_count];
+        if (match >= 0) {
+            // Same image: keep the texture, swap in the new parameters
+            taken[match] = 1;
+            *layer = live[match];
+            layer->shift_multiplier = spec->shift_multiplier;
+            layer->opacity = spec->opacity;
+            layer->blur_amount = spec->blur_amount;
+            layer->easing = spec->easing;
+            layer->animation_delay = spec->animation_delay;
+            layer->animation_duration = spec->animation_duration;
+            free(spec->image_path);
+            kept++;
+        } else {
+            *layer = *spec;
+            if (load_layer(layer, layer->image_path, layer->shift_multiplier, layer->opacity,
+                           layer->blur_amount) < 0) {
+                free(layer->image_path);
+                memset(layer, 0, sizeof(*layer));
+                failed++;
+                continue;
+            }
+            queued++;
+        }
+        from[state.layer_count++] = match;  // Row on each output before the reload, -1 if new
+    }
+    free(fresh);
+
+    // Layers added over IPC aren't part of the file and keep their place above it
+    for (int j = 0; j < live_count; j++) {
+        if (!live[j].from_config) {
+            from[state.layer_count] = j;
+            state.layers[state.layer_count++] = live[j];
+            taken[j] = 1;
+        }
+    }
+
+    int removed = 0;
+    for (int j = 0; j < live_count; j++) {
+        if (!taken[j]) {
+            release_reloaded_layer(&live[j]);
+            removed++;
+        }
     }
+    free(live);
+    free(taken);
 
-    snprintf(resolved_path, path_len, "%s/%s", resolved_dir, base);
-    free(resolved_dir);
-    free(path_copy);
+    reindex_config_layers();
 
-    return resolved_path;
+    for (struct output *output = state.outputs; output; output = output->next) {
+        retarget_reloaded_layers(output, from);
+    }
+    free(from);
+    state.layer_groups_valid = 0;
+    apply_render_scale_min();
+    mark_outputs_dirty();
+
+    snprintf(result, size, "Config reloaded: %d layers kept, %d loading, %d removed%s\n",
+             kept, queued, removed, failed ? ", some images failed to load" : "");
+    if (config.debug) {
+        printf("%s", result);
+    }
+    return 0;
 }
 
-// Validate path to prevent directory traversal
-int validate_path(const char *path) {
-    if (!path) {
-        fprintf(stderr, "Error: Path validation failed - NULL path provided\n");
-        return 0;
+static bool ipc_reload_config(char *response, size_t size) {
+    return reload_config(response, size) == 0;
+}
+
+// Drop the layers of a scene that has not started fading in
+static void drop_incoming_scene(void) {
+    for (int i = state.layer_count - 1; i >= 0; i--) {
+        if (state.layers[i].scene == SCENE_INCOMING) remove_layer_at(i);
     }
+    free(state.scene_settings.config_file_path);
+    state.scene_settings.config_file_path = NULL;
+    state.scene_pending = 0;
+    state.layer_groups_valid = 0;
+}
 
-    // Try to resolve the path directly
-    char *resolved_path = realpath(path, NULL);
+// Preload the layers of another config file as the next scene. They are decoded (and
+// their blur built) in the background, hidden above the current config layers, and
+// crossfade in over `fade` seconds once all have loaded and `delay` seconds have passed.
+// A scene queued while another is still loading replaces it.
+static int queue_scene(const char *path, double delay, double fade, char *result, size_t size) {
+    if (!config.multi_layer_mode) {
+        snprintf(result, size, "Error: Scenes need multi-layer mode (start with --config or --layer)\n");
+        return -1;
+    }
+    if (state.scene_fade_start > 0.0) {
+        snprintf(result, size, "Error: A scene is fading in, queue the next one once it is shown\n");
+        return -1;
+    }
 
-    // If file doesn't exist, resolve parent directory
-    if (!resolved_path) {
-        resolved_path = resolve_nonexistent_path(path);
-        if (!resolved_path) {
-            return 0;
+    // parse_config applies the file's settings as it reads them; keep them for the switch.
+    // As on reload, they start from the settings before any file and command-line options
+    // given after --config win.
+    struct config live = config;
+    config.config_file_path = NULL;  // Replaced by the scene's path, which images resolve against
+    struct layer *fresh = NULL;
+    int fresh_count = 0, fresh_max = 0;
+    config_copy_settings(&config, &state.file_base, CONFIG_SET_FILE);
+    int parsed = parse_config(path, &fresh, &fresh_count, &fresh_max);
+    config_copy_settings(&config, &state.cli_settings, state.cli_overrides);
+    struct config settings = config;
+    config = live;
+    if (parsed < 0 || fresh_count == 0) {
+        for (int i = 0; i < fresh_count; i++) free(fresh[i].image_path);
+        free(fresh);
+        free(settings.config_file_path);
+        snprintf(result, size, "Error: No layers in scene %s\n", path);
+        return -1;
+    }
+
+    if (state.scene_pending) drop_incoming_scene();
+
+    int live_count = state.layer_count;
+    int capacity = state.max_layers > 0 ? state.max_layers : INITIAL_MAX_LAYERS;
+    while (capacity < fresh_count + live_count) capacity *= 2;
+    struct layer *next = calloc(capacity, sizeof(struct layer));
+    int *from = calloc(capacity, sizeof(int));
+    if (!next || !from) {
+        free(next);
+        free(from);
+        for (int i = 0; i < fresh_count; i++) free(fresh[i].image_path);
+        free(fresh);
+        free(settings.config_file_path);
+        snprintf(result, size, "Error: Out of memory loading scene\n");
+        return -1;
+    }
+
+    // Scene layers go between the config layers and those added with hyprlax-ctl
+    struct layer *previous = state.layers;
+    state.layers = next;
+    state.max_layers = capacity;
+    state.layer_count = 0;
+    for (int j = 0; j < live_count; j++) {
+        if (!previous[j].from_config) continue;
+        from[state.layer_count] = j;
+        state.layers[state.layer_count++] = previous[j];
+    }
+
+    // New layers take the scene's default easing and duration
+    config = settings;
+    int queued = 0, failed = 0;
+    for (int i = 0; i < fresh_count; i++) {
+        struct layer *layer = &state.layers[state.layer_count];
+        *layer = fresh[i];
+        layer->scene = SCENE_INCOMING;
+        if (load_layer(layer, layer->image_path, layer->shift_multiplier, layer->opacity,
+                       layer->blur_amount) < 0) {
+            free(layer->image_path);
+            memset(layer, 0, sizeof(*layer));
+            failed++;
+            continue;
         }
+        from[state.layer_count++] = -1;
+        queued++;
+    }
+    settings = config;
+    config = live;
+    free(fresh);
+
+    for (int j = 0; j < live_count; j++) {
+        if (previous[j].from_config) continue;
+        from[state.layer_count] = j;
+        state.layers[state.layer_count++] = previous[j];
+    }
+    free(previous);
+
+    for (int i = 0; i < state.layer_count; i++) {
+        if (state.layers[i].ipc_id) idmap_put(&state.ipc_slots, state.layers[i].ipc_id, i);
+    }
+    for (struct output *output = state.outputs; output; output = output->next) {
+        retarget_reloaded_layers(output, from);
+    }
+    free(from);
+    state.layer_groups_valid = 0;
+
+    state.scene_pending = 1;
+    state.scene_switch_at = get_time() + delay;
+    state.scene_fade_start = 0.0;
+    state.scene_fade = fade;
+    state.scene_settings = settings;
+
+    snprintf(result, size, "Scene queued: %d layers loading%s, switching in %.1fs over %.1fs\n",
+             queued, failed ? ", some images failed to load" : "", delay, fade);
+    if (config.debug) {
+        printf("%s", result);
+    }
+    return 0;
+}
+
+// Start the crossfade once every layer of a queued scene has finished decoding and its
+// switch time has come. Returns how long poll may sleep before that time, in milliseconds
+// (-1 when nothing is waiting on the clock).
+static int advance_scene(void) {
+    if (!state.scene_pending || state.scene_fade_start > 0.0) return -1;
+
+    int loading = 0, loaded = 0;
+    for (int i = 0; i < state.layer_count; i++) {
+        const struct layer *layer = &state.layers[i];
+        if (layer->scene != SCENE_INCOMING) continue;
+        if (layer->load_id) loading++;
+        else if (layer->texture || layer->tiles) loaded++;
+    }
+    if (loading) return -1;  // The decode completion wakes the loop up again
+    if (!loaded) {
+        fprintf(stderr, "No layer of the queued scene could be loaded, keeping the current one\n");
+        drop_incoming_scene();
+        return -1;
     }
 
-    // Check for sensitive directories
-    int is_valid = !is_sensitive_path(resolved_path);
+    double now = get_time();
+    if (now < state.scene_switch_at) {
+        return (int)ceil((state.scene_switch_at - now) * 1000.0);
+    }
 
-    free(resolved_path);
-    return is_valid;
+    state.scene_fade_start = now;
+    for (int i = 0; i < state.layer_count; i++) {
+        struct layer *layer = &state.layers[i];
+        if (layer->from_config && layer->scene == SCENE_CURRENT) layer->scene = SCENE_OUTGOING;
+    }
+    state.layer_groups_valid = 0;
+    mark_outputs_dirty();
+    if (config.debug) {
+        printf("Crossfading to scene %s over %.1fs\n", state.scene_settings.config_file_path,
+               state.scene_fade);
+    }
+    return -1;
 }
 
-// Resolve path relative to config file directory
-char* resolve_config_relative_path(const char *path) {
-    if (!path) return NULL;
+// The crossfade is over: release the previous scene, make the new one the config layers
+// and apply its settings. `reload` re-reads the scene's file from now on.
+static void finish_scene_switch(void) {
+    int *from = calloc(state.layer_count + 1, sizeof(int));
+    if (!from) return;  // Retried on the next frame
 
-    // If path is already absolute, return a copy
-    if (path[0] == '/') {
-        return strdup(path);
+    // Release first, so textures shared with the new scene are seen as still in use
+    for (int i = 0; i < state.layer_count; i++) {
+        if (state.layers[i].scene == SCENE_OUTGOING) release_reloaded_layer(&state.layers[i]);
+    }
+    int count = 0;
+    for (int i = 0; i < state.layer_count; i++) {
+        if (state.layers[i].scene == SCENE_OUTGOING) continue;
+        from[count] = i;
+        state.layers[count] = state.layers[i];
+        state.layers[count++].scene = SCENE_CURRENT;
     }
+    memset(&state.layers[count], 0, (state.layer_count - count) * sizeof(struct layer));
+    state.layer_count = count;
+
+    // Only what the scene's file sets; the rest (detected workspaces, the scale factor
+    // adjusted for them) stays as it is
+    config_copy_settings(&config, &state.scene_settings, CONFIG_SET_FILE);
+    free(config.config_file_path);
+    config.config_file_path = state.scene_settings.config_file_path;
+    state.scene_settings.config_file_path = NULL;
+    state.scene_pending = 0;
+    state.scene_fade_start = 0.0;
+
+    reindex_config_layers();
+    for (struct output *output = state.outputs; output; output = output->next) {
+        retarget_reloaded_layers(output, from);
+    }
+    free(from);
+    state.layer_groups_valid = 0;
+    apply_render_scale_min();
+    mark_outputs_dirty();
 
-    // If no config file path stored, treat as relative to current directory
-    if (!config.config_file_path) {
-        return strdup(path);
+    if (config.debug) {
+        printf("Scene %s is shown, previous scene released\n", config.config_file_path);
     }
+}
+
+static bool ipc_queue_scene(const char *path, double delay, double fade, char *response,
+                            size_t size) {
+    return queue_scene(path, delay, fade, response, size) == 0;
+}
 
-    // Get directory of config file
-    char *config_dir = strdup(config.config_file_path);
-    if (!config_dir) return NULL;
+// Memory lines for `hyprlax-ctl status`
+static void ipc_format_memory(char *out, size_t size) {
+    size_t cpu_bytes = 0;
+    int evicted = 0;
+    for (int i = 0; i < state.layer_count; i++) {
+        cpu_bytes += layer_cpu_bytes(&state.layers[i]);
+        evicted += state.layers[i].evicted;
+    }
+    char budget[32] = "none";
+    if (config.texture_budget_mb > 0) snprintf(budget, sizeof(budget), "%d MiB", config.texture_budget_mb);
+    snprintf(out, size,
+             "GPU memory: %.1f MiB (peak %.1f MiB, budget %s)\nCPU memory: %.1f MiB\n"
+             "Evicted layers: %d\n",
+             state.texture_bytes / (1024.0 * 1024.0), state.peak_texture_bytes / (1024.0 * 1024.0),
+             budget, cpu_bytes / (1024.0 * 1024.0), evicted);
+}
 
-    char *last_slash = strrchr(config_dir, '/');
-    if (last_slash) {
-        *last_slash = '\0';  // Terminate at last slash to get directory
+// Start watching the directory of the config file; editors often save by renaming a
+// temporary file over it, which a watch on the file itself would miss
+static void watch_config_file(void) {
+    state.config_watch_fd = -1;
+    if (!config.watch_config || !config.config_file_path) return;
+
+    char *dir_copy = strdup(config.config_file_path);
+    if (!dir_copy) return;
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd >= 0 && inotify_add_watch(fd, dirname(dir_copy), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0) {
+        state.config_watch_fd = fd;
     } else {
-        // Config file is in current directory
-        free(config_dir);
-        return strdup(path);
+        fprintf(stderr, "Warning: Failed to watch config file: %s\n", strerror(errno));
+        if (fd >= 0) close(fd);
     }
+    free(dir_copy);
+}
 
-    // Build full path
-    size_t dir_len = strlen(config_dir);
-    size_t path_len = strlen(path);
-    char *full_path = malloc(dir_len + path_len + 2);
-    if (!full_path) {
-        free(config_dir);
-        return NULL;
+// Drain the watch and reload once if the config file itself was written or replaced
+static void process_config_events(void) {
+    char *base_copy = strdup(config.config_file_path);
+    if (!base_copy) return;
+    const char *name = basename(base_copy);
+
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int changed = 0;
+    ssize_t length;
+    while ((length = read(state.config_watch_fd, buffer, sizeof(buffer))) > 0) {
+        for (char *p = buffer; p < buffer + length;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            if (event->len > 0 && strcmp(event->name, name) == 0) changed = 1;
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    free(base_copy);
+
+    if (changed) {
+        char result[256];
+        if (reload_config(result, sizeof(result)) < 0) {
+            fprintf(stderr, "%s", result);
+        }
     }
+}
 
-    snprintf(full_path, dir_len + path_len + 2, "%s/%s", config_dir, path);
-    free(config_dir);
+// Load the layers given on the command line / config file, or the single image
+int load_configured_images(const char *image_path) {
+    if (config.multi_layer_mode) {
+        // Load all layers
+        for (int i = 0; i < state.layer_count; i++) {
+            struct layer *layer = &state.layers[i];
+            if (load_layer(layer, layer->image_path, layer->shift_multiplier, layer->opacity, layer->blur_amount) < 0) {
+                fprintf(stderr, "Failed to load layer %d '%s'\n", i, layer->image_path);
+                return -1;
+            }
+        }
+        if (config.debug) {
+            printf("Queued %d layers for loading\n", state.layer_count);
+        }
+    } else {
+        // Load single image
+        if (load_image(image_path) < 0) return -1;
+    }
 
-    return full_path;
+    return 0;
 }
 
-// Parse config file
-int parse_config_file(const char *filename) {
-    // Validate the config file path
-    if (!validate_path(filename)) {
-        fprintf(stderr, "Error: Invalid config file path: %s\n", filename);
+// Parse a comma-separated list of workspace numbers for --bench-script
+static int parse_bench_script(const char *script, int *workspaces, int max_count) {
+    char *copy = strdup(script);
+    if (!copy) {
+        fprintf(stderr, "Error: Failed to allocate memory for benchmark script\n");
         return -1;
     }
 
-    // Store the config file path (resolve to absolute path)
-    char *resolved_config_path = realpath(filename, NULL);
-    if (resolved_config_path) {
-        if (config.config_file_path) {
-            free(config.config_file_path);
+    int count = 0;
+    char *saveptr = NULL;
+    for (char *tok = strtok_r(copy, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr)) {
+        int ws = atoi(tok);
+        if (ws <= 0) {
+            fprintf(stderr, "Error: Invalid workspace '%s' in benchmark script\n", tok);
+            free(copy);
+            return -1;
         }
-        config.config_file_path = resolved_config_path;
-    } else {
-        // If realpath fails, store the original path
-        if (config.config_file_path) {
-            free(config.config_file_path);
+        if (count >= max_count) {
+            fprintf(stderr, "Error: Benchmark script exceeds %d switches\n", max_count);
+            free(copy);
+            return -1;
         }
-        config.config_file_path = strdup(filename);
+        workspaces[count++] = ws;
+    }
+
+    free(copy);
+    return count;
+}
+
+// Headless benchmark: composite the configured layers into an offscreen pbuffer and replay
+// a scripted list of workspace switches through the normal animation and render path
+int run_benchmark(const char *image_path) {
+    int workspaces[BENCH_MAX_SWITCHES];
+    int switch_count = parse_bench_script(config.bench_script, workspaces, BENCH_MAX_SWITCHES);
+    if (switch_count <= 0) {
+        fprintf(stderr, "Error: Benchmark script must list at least one workspace\n");
+        return -1;
     }
 
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        fprintf(stderr, "Error: Cannot open config file: %s\n", filename);
+    // Prefer a surfaceless platform display so no compositor or GPU output is needed
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    state.egl_display = EGL_NO_DISPLAY;
+    if (get_platform_display) {
+        state.egl_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (state.egl_display == EGL_NO_DISPLAY) {
+        state.egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (state.egl_display == EGL_NO_DISPLAY || !eglInitialize(state.egl_display, NULL, NULL)) {
+        fprintf(stderr, "Benchmark: failed to initialize EGL display\n");
         return -1;
     }
+    eglBindAPI(EGL_OPENGL_ES_API);
 
-    char line[MAX_CONFIG_LINE_SIZE];
-    int line_num = 0;
+    EGLint attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_NONE
+    };
 
-    while (fgets(line, MAX_CONFIG_LINE_SIZE, file)) {
-        line_num++;
+    EGLConfig config_egl;
+    EGLint num_configs = 0;
+    if (!eglChooseConfig(state.egl_display, attributes, &config_egl, 1, &num_configs) || num_configs < 1) {
+        fprintf(stderr, "Benchmark: no pbuffer-capable EGL config\n");
+        eglTerminate(state.egl_display);
+        return -1;
+    }
 
-        // Check if line was truncated (no newline found)
-        if (!strchr(line, '\n')) {
-            // Only report error if not at EOF (EOF without newline is acceptable)
-            if (!feof(file)) {
-                fprintf(stderr, "Error: Line %d exceeds buffer size of %d characters\n",
-                        line_num, MAX_CONFIG_LINE_SIZE - 1);
-                // Skip rest of the line safely
-                int c;
-                while ((c = fgetc(file)) != EOF) {
-                    if (c == '\n') break;
-                }
-                continue;
-            }
-        }
+    EGLint context_attribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+    state.egl_context = eglCreateContext(state.egl_display, config_egl, EGL_NO_CONTEXT, context_attribs);
 
-        // Skip comments and empty lines
-        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+    EGLint pbuffer_attribs[] = {
+        EGL_WIDTH, config.bench_width,
+        EGL_HEIGHT, config.bench_height,
+        EGL_NONE
+    };
+    // A virtual output backed by a pbuffer stands in for the monitor
+    struct output *output = output_create(NULL, 0);
+    if (!output) {
+        eglTerminate(state.egl_display);
+        return -1;
+    }
+    output->egl_surface = eglCreatePbufferSurface(state.egl_display, config_egl, pbuffer_attribs);
+    if (state.egl_context == EGL_NO_CONTEXT || output->egl_surface == EGL_NO_SURFACE ||
+        !eglMakeCurrent(state.egl_display, output->egl_surface, output->egl_surface, state.egl_context)) {
+        fprintf(stderr, "Benchmark: failed to create offscreen %dx%d context\n",
+                config.bench_width, config.bench_height);
+        eglTerminate(state.egl_display);
+        return -1;
+    }
 
-        // Remove newline
-        char *newline = strchr(line, '\n');
-        if (newline) *newline = '\0';
+    output->width = config.bench_width;
+    output->height = config.bench_height;
+    output->configured = 1;
+    config.vsync = 0;  // Measure throughput, not the refresh rate
 
-        // Parse tokens
-        char *cmd = strtok(line, " \t");
-        if (!cmd) continue;
+    if (init_gl() < 0) return -1;
+    glViewport(0, 0, output->width, output->height);
 
-        if (strcmp(cmd, "layer") == 0) {
-            char *image = strtok(NULL, " \t");
-            char *shift_str = strtok(NULL, " \t");
-            char *opacity_str = strtok(NULL, " \t");
-            char *blur_str = strtok(NULL, " \t");
+    double load_start = get_time();
+    if (load_configured_images(image_path) < 0) return -1;
+    wait_for_layer_decodes();
+    double load_time = get_time() - load_start;
 
-            if (!image) {
-                fprintf(stderr, "Config line %d: layer requires image path\n", line_num);
-                continue;
-            }
+    // With --deferred-mips the load ends at level 0; the rest goes up before the replay
+    double mips_start = get_time();
+    while (upload_deferred_mips()) {}
+    double mips_time = get_time() - mips_start;
 
-            // Resolve path relative to config file if needed
-            char *resolved_image_path = resolve_config_relative_path(image);
-            if (!resolved_image_path) {
-                fprintf(stderr, "Error: Failed to resolve image path at line %d: %s\n", line_num, image);
-                fclose(file);
-                return -1;
-            }
+    for (int i = 0; i < state.layer_count; i++) {
+        if (!state.layers[i].texture && !state.layers[i].tiles) {
+            fprintf(stderr, "Error: Layer %d '%s' failed to load\n", i, state.layers[i].image_path);
+            return -1;
+        }
+    }
 
-            // Validate resolved image path
-            if (!validate_path(resolved_image_path)) {
-                fprintf(stderr, "Error: Invalid image path at line %d: %s\n", line_num, resolved_image_path);
-                free(resolved_image_path);
-                fclose(file);
-                return -1;
-            }
+    if (config.bench_blur >= 0.0f) {
+        for (int i = 0; i < state.layer_count; i++) {
+            state.layers[i].blur_amount = config.bench_blur;
+        }
+    }
 
-            float shift = shift_str ? atof(shift_str) : 1.0f;
-            float opacity = opacity_str ? atof(opacity_str) : 1.0f;
-            float blur = blur_str ? atof(blur_str) : 0.0f;
-            
-            if (config.debug) {
-                fprintf(stderr, "Config parse layer: image=%s, shift=%.2f, opacity=%.2f, blur=%.2f\n",
-                        image, shift, opacity, blur);
-            }
+    stats_init(&state.stats, config.target_fps);
 
-            // Initialize layer array if needed
-            if (!state.layers) {
-                state.max_layers = INITIAL_MAX_LAYERS;
-                state.layers = calloc(state.max_layers, sizeof(struct layer));
-                if (!state.layers) {
-                    fprintf(stderr, "Error: Failed to allocate memory for layers at line %d\n", line_num);
-                    fclose(file);
-                    return -1;
-                }
-                state.layer_count = 0;
-                config.multi_layer_mode = 1;
-            }
+    long frames = 0;
+    double gpu_total_ms = 0.0, gpu_max_ms = 0.0;
+    long gpu_samples = 0;
+    double bench_start = get_time();
 
-            // Grow the layer array if needed
-            if (state.layer_count >= state.max_layers) {
-                // Check for integer overflow and reasonable limits
-                if (state.max_layers > INT_MAX / 2 || state.max_layers > 1000) {
-                    fprintf(stderr, "Error: Maximum layer limit reached (%d layers) at line %d\n", state.max_layers, line_num);
-                    fclose(file);
-                    return -1;
-                }
-                int new_max = state.max_layers * 2;
+    for (int s = 0; s < switch_count; s++) {
+        start_workspace_animation(output, workspaces[s]);
 
-                // Check multiplication overflow for size calculation
-                if (new_max > SIZE_MAX / sizeof(struct layer)) {
-                    fprintf(stderr, "Error: Layer array size would exceed memory limits at line %d\n", line_num);
-                    fclose(file);
-                    return -1;
-                }
+        // Only submitted frames count; idle ones (e.g. during layer delays) cost nothing
+        for (int f = 0; f < BENCH_MAX_FRAMES_PER_SWITCH && output->animating;) {
+            if (!render_frame(output)) continue;
 
-                struct layer *new_layers = realloc(state.layers, new_max * sizeof(struct layer));
-                if (!new_layers) {
-                    fprintf(stderr, "Failed to allocate memory for %d layers at line %d\n", new_max, line_num);
-                    fclose(file);
-                    return -1;
-                }
-                memset(new_layers + state.max_layers, 0, (new_max - state.max_layers) * sizeof(struct layer));
-                state.layers = new_layers;
-                state.max_layers = new_max;
-            }
+            // Keep CPU and GPU in lockstep so frames/sec reflects the whole pipeline,
+            // which also makes render_frame's GPU timing available right away
+            glFinish();
+            frames++;
+            f++;
 
-            if (state.layer_count < state.max_layers) {
-                struct layer *layer = &state.layers[state.layer_count];
-                layer->image_path = resolved_image_path;  // Use the resolved path directly
-                // Note: resolved_image_path is now owned by the layer, don't free it
-                layer->shift_multiplier = shift;
-                layer->opacity = opacity;
-                layer->blur_amount = blur;
-                if (config.debug) {
-                    fprintf(stderr, "Stored layer %d: blur_amount=%.2f\n", state.layer_count, layer->blur_amount);
-                }
-                // Set defaults for Phase 3 features
-                layer->easing = config.easing;
-                layer->animation_delay = 0.0f;
-                layer->animation_duration = config.animation_duration;
-                state.layer_count++;
-            }
-        } else if (strcmp(cmd, "duration") == 0) {
-            char *val = strtok(NULL, " \t");
-            if (val) config.animation_duration = atof(val);
-        } else if (strcmp(cmd, "shift") == 0) {
-            char *val = strtok(NULL, " \t");
-            if (val) config.shift_per_workspace = atof(val);
-        } else if (strcmp(cmd, "easing") == 0) {
-            char *val = strtok(NULL, " \t");
-            if (val) {
-                if (strcmp(val, "linear") == 0) config.easing = EASE_LINEAR;
-                else if (strcmp(val, "quad") == 0) config.easing = EASE_QUAD_OUT;
-                else if (strcmp(val, "cubic") == 0) config.easing = EASE_CUBIC_OUT;
-                else if (strcmp(val, "quart") == 0) config.easing = EASE_QUART_OUT;
-                else if (strcmp(val, "quint") == 0) config.easing = EASE_QUINT_OUT;
-                else if (strcmp(val, "sine") == 0) config.easing = EASE_SINE_OUT;
-                else if (strcmp(val, "expo") == 0) config.easing = EASE_EXPO_OUT;
-                else if (strcmp(val, "circ") == 0) config.easing = EASE_CIRC_OUT;
-                else if (strcmp(val, "back") == 0) config.easing = EASE_BACK_OUT;
-                else if (strcmp(val, "elastic") == 0) config.easing = EASE_ELASTIC_OUT;
-                else if (strcmp(val, "snap") == 0) config.easing = EASE_CUSTOM_SNAP;
+            double ms = collect_gpu_time(output);
+            if (ms >= 0.0) {
+                gpu_total_ms += ms;
+                if (ms > gpu_max_ms) gpu_max_ms = ms;
+                gpu_samples++;
             }
         }
     }
 
-    fclose(file);
+    double elapsed = get_time() - bench_start;
+
+    printf("hyprlax benchmark\n");
+    printf("Resolution: %dx%d\n", output->width, output->height);
+    printf("Layers: %d\n", config.multi_layer_mode ? state.layer_count : 1);
+    if (config.bench_blur >= 0.0f) {
+        printf("Blur override: %.2f\n", config.bench_blur);
+    }
+    printf("Switches: %d (%s)\n", switch_count, config.bench_script);
+    printf("Load time: %.1f ms\n", load_time * 1000.0);
+    if (config.deferred_mips) {
+        printf("Deferred mipmaps: %.1f ms\n", mips_time * 1000.0);
+    }
+    printf("Frames: %ld in %.3f s\n", frames, elapsed);
+    printf("FPS: %.1f\n", elapsed > 0.0 ? frames / elapsed : 0.0);
+    if (gpu_samples > 0) {
+        printf("GPU time: avg %.3f ms, max %.3f ms (%ld samples)\n",
+               gpu_total_ms / gpu_samples, gpu_max_ms, gpu_samples);
+    } else {
+        printf("GPU time: unavailable (no GL_EXT_disjoint_timer_query)\n");
+    }
+    if (config.dynamic_resolution) {
+        printf("Render scale: %.0f%% at the end of the run\n", output->resscale.scale * 100.0f);
+    }
+    printf("Peak texture memory: %.1f MiB\n", state.peak_texture_bytes / (1024.0 * 1024.0));
+
+    char report[IPC_MAX_MESSAGE_SIZE];
+    if (stats_format(&state.stats, report, sizeof(report)) > 0) {
+        printf("%s", report);
+    }
+
+    output_destroy(output);
+    eglMakeCurrent(state.egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(state.egl_display, state.egl_context);
+    eglTerminate(state.egl_display);
+
     return 0;
 }
 
@@ -1560,7 +4712,22 @@ int main(int argc, char *argv[]) {
         {"fps", required_argument, 0, 0},
         {"layer", required_argument, 0, 0},
         {"config", required_argument, 0, 0},
+        {"blur-downscale", required_argument, 0, 0},
+        {"no-cache", no_argument, 0, 0},
+        {"compress", no_argument, 0, 0},
+        {"dmabuf", no_argument, 0, 0},
+        {"gpu-animation", no_argument, 0, 0},
+        {"watch-config", no_argument, 0, 0},
+        {"texture-budget", required_argument, 0, 0},
+        {"dynamic-resolution", no_argument, 0, 0},
+        {"render-scale-min", required_argument, 0, 0},
+        {"power-policy", no_argument, 0, 0},
+        {"deferred-mips", no_argument, 0, 0},
         {"debug", no_argument, 0, 0},
+        {"bench", no_argument, 0, 0},
+        {"bench-size", required_argument, 0, 0},
+        {"bench-script", required_argument, 0, 0},
+        {"bench-blur", required_argument, 0, 0},
         {"version", no_argument, 0, 0},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
@@ -1568,16 +4735,24 @@ int main(int argc, char *argv[]) {
 
     int option_index = 0;
     int c;
+    unsigned cli_overrides = 0;  // Settings given since the last --config
+
+    // Profiles are only applied with --power-policy; parallax.conf can override them
+    power_profiles_default(config.power_profiles);
+    state.file_base = config;  // Replaced at --config by the settings given before it
 
     while ((c = getopt_long(argc, argv, "s:d:e:f:v:h", long_options, &option_index)) != -1) {
         switch (c) {
             case 's':
                 config.shift_per_workspace = atof(optarg);
+                cli_overrides |= CONFIG_SET_SHIFT;
                 break;
             case 'd':
                 config.animation_duration = atof(optarg);
+                cli_overrides |= CONFIG_SET_DURATION;
                 break;
             case 'e':
+                cli_overrides |= CONFIG_SET_EASING;
                 if (strcmp(optarg, "linear") == 0) config.easing = EASE_LINEAR;
                 else if (strcmp(optarg, "quad") == 0) config.easing = EASE_QUAD_OUT;
                 else if (strcmp(optarg, "cubic") == 0) config.easing = EASE_CUBIC_OUT;
@@ -1703,11 +4878,56 @@ int main(int argc, char *argv[]) {
 
                     free(spec);
                 } else if (strcmp(long_options[option_index].name, "config") == 0) {
+                    state.file_base = config;  // What reload_config resets the file's settings to
                     if (parse_config_file(optarg) < 0) {
                         return 1;
                     }
+                    cli_overrides = 0;
+                } else if (strcmp(long_options[option_index].name, "blur-downscale") == 0) {
+                    config.blur_downscale = clamp_blur_downscale(atof(optarg));
+                    cli_overrides |= CONFIG_SET_BLUR_DOWNSCALE;
+                } else if (strcmp(long_options[option_index].name, "no-cache") == 0) {
+                    config.texture_cache = 0;
+                } else if (strcmp(long_options[option_index].name, "compress") == 0) {
+                    config.compress_textures = 1;
+                    cli_overrides |= CONFIG_SET_COMPRESS_TEXTURES;
+                } else if (strcmp(long_options[option_index].name, "dmabuf") == 0) {
+                    config.dmabuf_upload = 1;
+                    cli_overrides |= CONFIG_SET_DMABUF_UPLOAD;
+                } else if (strcmp(long_options[option_index].name, "gpu-animation") == 0) {
+                    config.gpu_animation = 1;
+                    cli_overrides |= CONFIG_SET_GPU_ANIMATION;
+                } else if (strcmp(long_options[option_index].name, "watch-config") == 0) {
+                    config.watch_config = 1;
+                } else if (strcmp(long_options[option_index].name, "texture-budget") == 0) {
+                    config.texture_budget_mb = atoi(optarg) > 0 ? atoi(optarg) : 0;
+                    cli_overrides |= CONFIG_SET_TEXTURE_BUDGET;
+                } else if (strcmp(long_options[option_index].name, "dynamic-resolution") == 0) {
+                    config.dynamic_resolution = 1;
+                    cli_overrides |= CONFIG_SET_DYNAMIC_RESOLUTION;
+                } else if (strcmp(long_options[option_index].name, "render-scale-min") == 0) {
+                    config.render_scale_min = clamp_render_scale_min(atof(optarg));
+                    cli_overrides |= CONFIG_SET_RENDER_SCALE_MIN;
+                } else if (strcmp(long_options[option_index].name, "power-policy") == 0) {
+                    config.power_policy = 1;
+                    cli_overrides |= CONFIG_SET_POWER_POLICY;
+                } else if (strcmp(long_options[option_index].name, "deferred-mips") == 0) {
+                    config.deferred_mips = 1;
+                    cli_overrides |= CONFIG_SET_DEFERRED_MIPS;
                 } else if (strcmp(long_options[option_index].name, "debug") == 0) {
                     config.debug = 1;
+                } else if (strcmp(long_options[option_index].name, "bench") == 0) {
+                    config.bench = 1;
+                } else if (strcmp(long_options[option_index].name, "bench-size") == 0) {
+                    if (sscanf(optarg, "%dx%d", &config.bench_width, &config.bench_height) != 2 ||
+                        config.bench_width <= 0 || config.bench_height <= 0) {
+                        fprintf(stderr, "Error: Invalid benchmark size '%s' (expected WIDTHxHEIGHT)\n", optarg);
+                        return 1;
+                    }
+                } else if (strcmp(long_options[option_index].name, "bench-script") == 0) {
+                    config.bench_script = optarg;
+                } else if (strcmp(long_options[option_index].name, "bench-blur") == 0) {
+                    config.bench_blur = atof(optarg);
                 } else if (strcmp(long_options[option_index].name, "version") == 0) {
                     print_version();
                     return 0;
@@ -1722,6 +4942,9 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    state.cli_settings = config;
+    state.cli_overrides = cli_overrides;
+
     const char *image_path = NULL;
 
     // Check if we have layers or a single image
@@ -1764,6 +4987,19 @@ int main(int argc, char *argv[]) {
         printf("  Target FPS: %d\n", config.target_fps);
     }
 
+    // Layer images decode on worker threads; falls back to inline decoding without it
+    state.decode_pool = pool_create(DECODE_THREADS);
+    if (!state.decode_pool) {
+        fprintf(stderr, "Warning: Failed to start image decode threads, loading synchronously\n");
+    }
+
+    // Headless benchmark never touches Wayland or Hyprland
+    if (config.bench) {
+        int result = run_benchmark(image_path);
+        pool_destroy(state.decode_pool);
+        return result < 0 ? 1 : 0;
+    }
+
     // Connect to Wayland
     state.display = wl_display_connect(NULL);
     if (!state.display) {
@@ -1781,26 +5017,10 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    // Create surface
-    state.surface = wl_compositor_create_surface(state.compositor);
-
-    // Create layer surface
-    state.layer_surface = zwlr_layer_shell_v1_get_layer_surface(
-        state.layer_shell, state.surface, state.output,
-        ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND, "hyprlax");
-
-    zwlr_layer_surface_v1_add_listener(state.layer_surface, &layer_surface_listener, NULL);
-    zwlr_layer_surface_v1_set_exclusive_zone(state.layer_surface, -1);
-    zwlr_layer_surface_v1_set_anchor(state.layer_surface,
-        ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP |
-        ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM |
-        ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT |
-        ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT);
-
-    wl_surface_commit(state.surface);
+    // Second roundtrip delivers the wl_output name events
     wl_display_roundtrip(state.display);
 
-    // Initialize EGL
+    // Initialize EGL; one context is shared by every output's surface
     state.egl_display = eglGetDisplay((EGLNativeDisplayType)state.display);
     eglInitialize(state.egl_display, NULL, NULL);
 
@@ -1812,24 +5032,44 @@ int main(int argc, char *argv[]) {
         EGL_NONE
     };
 
-    EGLConfig config_egl;
     EGLint num_configs;
-    eglChooseConfig(state.egl_display, attributes, &config_egl, 1, &num_configs);
+    eglChooseConfig(state.egl_display, attributes, &state.egl_config, 1, &num_configs);
 
     EGLint context_attribs[] = {
         EGL_CONTEXT_CLIENT_VERSION, 2,
         EGL_NONE
     };
 
-    state.egl_context = eglCreateContext(state.egl_display, config_egl, EGL_NO_CONTEXT, context_attribs);
+    state.egl_context = eglCreateContext(state.egl_display, state.egl_config, EGL_NO_CONTEXT, context_attribs);
+    if (state.egl_context == EGL_NO_CONTEXT) {
+        fprintf(stderr, "Failed to create EGL context\n");
+        return 1;
+    }
 
-    // Create EGL window with initial dimensions (will be resized on configure)
-    int initial_width = 1;
-    int initial_height = 1;
-    state.egl_window = wl_egl_window_create(state.surface, initial_width, initial_height);
-    state.egl_surface = eglCreateWindowSurface(state.egl_display, config_egl, state.egl_window, NULL);
+    // Lets frames carry damage instead of EGL damaging the whole surface
+    const char *egl_extensions = eglQueryString(state.egl_display, EGL_EXTENSIONS);
+    if (egl_extensions && strstr(egl_extensions, "EGL_KHR_swap_buffers_with_damage")) {
+        state.swap_buffers_with_damage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)
+            eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+    } else if (egl_extensions && strstr(egl_extensions, "EGL_EXT_swap_buffers_with_damage")) {
+        state.swap_buffers_with_damage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)
+            eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+    }
+
+    // Create a background layer surface on every output
+    for (struct output *output = state.outputs; output; output = output->next) {
+        output_create_surface(output);
+        if (config.debug) {
+            printf("Created surface for output %s\n", output->name ? output->name : "(unnamed)");
+        }
+    }
+    if (!state.outputs) {
+        fprintf(stderr, "Warning: No outputs yet, waiting for one to be connected\n");
+    }
 
-    eglMakeCurrent(state.egl_display, state.egl_surface, state.egl_surface, state.egl_context);
+    // GL state lives in the context; bind it surfaceless if no output exists yet
+    EGLSurface initial_surface = state.outputs ? state.outputs->egl_surface : EGL_NO_SURFACE;
+    eglMakeCurrent(state.egl_display, initial_surface, initial_surface, state.egl_context);
 
     // Initialize OpenGL
     if (init_gl() < 0) return 1;
@@ -1837,34 +5077,20 @@ int main(int argc, char *argv[]) {
     // Don't set viewport yet - wait for configuration from compositor
 
     // Load images
-    if (config.multi_layer_mode) {
-        // Load all layers
-        for (int i = 0; i < state.layer_count; i++) {
-            struct layer *layer = &state.layers[i];
-            if (load_layer(layer, layer->image_path, layer->shift_multiplier, layer->opacity, layer->blur_amount) < 0) {
-                fprintf(stderr, "Failed to load layer %d '%s': %s\n", i, layer->image_path, stbi_failure_reason());
-                return 1;
-            }
-        }
-        if (config.debug) {
-            printf("Loaded %d layers successfully\n", state.layer_count);
-        }
-    } else {
-        // Load single image
-        if (load_image(image_path) < 0) return 1;
-    }
-
-    // Detect maximum number of workspaces
-    config.max_workspaces = detect_max_workspaces();
-    if (config.debug) {
-        printf("Maximum workspaces detected: %d\n", config.max_workspaces);
-    }
+    if (load_configured_images(image_path) < 0) return 1;
 
     // Connect to Hyprland IPC
     if (connect_hyprland_ipc() < 0) {
         fprintf(stderr, "Warning: Failed to connect to Hyprland IPC\n");
     }
 
+    // Detect the maximum number of workspaces; the reply arrives in the main loop
+    state.workspace_query_fd = -1;
+    request_workspace_count();
+
+    // Frame statistics are collected regardless of debug mode
+    stats_init(&state.stats, config.target_fps);
+
     // Initialize hyprlax IPC for dynamic layer management
     state.ipc_ctx = ipc_init();
     if (!state.ipc_ctx) {
@@ -1873,120 +5099,171 @@ int main(int argc, char *argv[]) {
         // Add config-loaded layers to IPC context so they can be managed
         for (int i = 0; i < state.layer_count; i++) {
             if (state.layers[i].image_path) {
-                ipc_add_layer(state.ipc_ctx, state.layers[i].image_path,
-                             state.layers[i].shift_multiplier,
-                             state.layers[i].opacity,
-                             0.0f, 0.0f, i);
+                bind_ipc_layer(i, ipc_add_layer(state.ipc_ctx, state.layers[i].image_path,
+                                                state.layers[i].shift_multiplier,
+                                                state.layers[i].opacity,
+                                                0.0f, 0.0f, i));
             }
         }
+        ipc_clear_changes(state.ipc_ctx);  // Already in sync
         if (config.debug) {
             printf("Added %d config layers to IPC context\n", state.layer_count);
         }
     }
 
-    // Get initial workspace
-    state.current_workspace = 1;
-    state.previous_workspace = 1;
-    state.current_offset = 0;
-    state.target_offset = 0;
+    if (state.ipc_ctx) {
+        state.ipc_ctx->stats = &state.stats;
+        state.ipc_ctx->reload_config = ipc_reload_config;
+        state.ipc_ctx->format_memory = ipc_format_memory;
+        state.ipc_ctx->queue_scene = ipc_queue_scene;
+    }
+    watch_config_file();
 
     // Initialize timers
-    state.last_frame_time = get_time();
-    state.fps_timer = state.last_frame_time;
+    state.fps_timer = get_time();
 
-    // Commit the surface to trigger configuration from compositor
-    wl_surface_commit(state.surface);
-    wl_display_flush(state.display);
+    state.running = 1;
 
     // Wait for initial configuration before rendering
-    while (!state.configured && state.running) {
-        wl_display_dispatch(state.display);
+    wl_display_flush(state.display);
+    while (state.running && outputs_awaiting_configure() > 0) {
+        if (wl_display_dispatch(state.display) < 0) break;
     }
 
-    // Main loop
-    state.running = 1;
+    // Set up poll descriptors; optional sources get an index only when present
+    int nfds = 0;
+    struct pollfd fds[6 + IPC_MAX_CLIENTS];
+    int wayland_idx = nfds;
+    fds[nfds].fd = wl_display_get_fd(state.display);
+    fds[nfds++].events = POLLIN;
+    int hyprland_idx = nfds;
+    fds[nfds].fd = state.ipc_fd;
+    fds[nfds++].events = POLLIN;
+
+    // Decode completions are uploaded on this thread, which owns the GL context
+    int decode_idx = -1;
+    if (state.decode_pool) {
+        decode_idx = nfds;
+        fds[nfds].fd = pool_get_fd(state.decode_pool);
+        fds[nfds++].events = POLLIN;
+    }
 
-    // Set up poll descriptors
-    int nfds = 2;
-    struct pollfd fds[3];
-    fds[0].fd = wl_display_get_fd(state.display);
-    fds[0].events = POLLIN;
-    fds[1].fd = state.ipc_fd;
-    fds[1].events = POLLIN;
+    // Workspace queries come and go; the slot is ignored while its fd is -1
+    int workspace_query_idx = nfds;
+    fds[nfds++].events = POLLIN;
 
-    // Add our IPC socket if available
-    if (state.ipc_ctx && state.ipc_ctx->socket_fd >= 0) {
-        fds[2].fd = state.ipc_ctx->socket_fd;
-        fds[2].events = POLLIN;
-        nfds = 3;
+    int config_watch_idx = -1;
+    if (state.config_watch_fd >= 0) {
+        config_watch_idx = nfds;
+        fds[nfds].fd = state.config_watch_fd;
+        fds[nfds++].events = POLLIN;
     }
 
+    // Our IPC socket and its connected clients go last, since the client set changes
+    int ipc_idx = nfds;
+    int poll_timeout = update_power_state();
+
+    // Main loop
     while (state.running) {
         // Dispatch Wayland events
         wl_display_dispatch_pending(state.display);
         wl_display_flush(state.display);
 
-        // Calculate timeout for target FPS
-        int timeout = -1;
-        if (state.animating) {
-            double frame_time = 1.0 / config.target_fps;
-            double elapsed = get_time() - state.last_frame_time;
-            timeout = (int)((frame_time - elapsed) * 1000);
-            if (timeout < 0) timeout = 0;
-        }
+        fds[hyprland_idx].fd = state.ipc_fd;  // -1 (ignored by poll) once Hyprland hangs up
+        fds[workspace_query_idx].fd = state.workspace_query_fd;
+        int ipc_nfds = ipc_get_poll_fds(state.ipc_ctx, fds + ipc_idx, 1 + IPC_MAX_CLIENTS);
 
-        // Poll for events
-        if (poll(fds, nfds, timeout) > 0) {
-            if (fds[0].revents & POLLIN) {
+        // Frames are paced by frame callbacks; only a queued scene switch, the battery
+        // state and held-back snapshots wait on the clock
+        if (poll(fds, ipc_idx + ipc_nfds, poll_timeout) > 0) {
+            if (fds[wayland_idx].revents & POLLIN) {
                 wl_display_dispatch(state.display);
             }
-            if (fds[1].revents & POLLIN) {
+            if (fds[hyprland_idx].revents & (POLLIN | POLLHUP)) {
                 process_ipc_events();
             }
+            if (fds[workspace_query_idx].revents & (POLLIN | POLLHUP)) {
+                process_workspace_reply();
+            }
+            if (config_watch_idx >= 0 && (fds[config_watch_idx].revents & POLLIN)) {
+                process_config_events();
+            }
+            // Upload layers whose images finished decoding
+            if (decode_idx >= 0 && (fds[decode_idx].revents & POLLIN)) {
+                pool_dispatch(state.decode_pool);
+            }
             // Handle our IPC for dynamic layer management
-            if (nfds > 2 && (fds[2].revents & POLLIN)) {
-                if (ipc_process_commands(state.ipc_ctx)) {
-                    // Sync IPC layers with OpenGL textures
-                    sync_ipc_layers();
-                    // Trigger re-render
-                    state.animating = 1;
-                    state.animation_start = get_time();
+            bool ipc_ready = false;
+            for (int i = ipc_idx; i < ipc_idx + ipc_nfds; i++) {
+                if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                    ipc_ready = true;
                 }
             }
+            // Only redraw when a command (or a committed batch of them) changed what is on screen
+            if (ipc_ready && ipc_process_commands(state.ipc_ctx) && sync_ipc_layers()) {
+                mark_outputs_dirty();
+            }
+        }
+
+        // Wake up for whichever of the scene switch, the next battery read and a held-back
+        // snapshot comes first;
+        // deferred mipmaps don't wait at all once animations are idle
+        poll_timeout = advance_scene();
+        int power_timeout = update_power_state();
+        if (power_timeout >= 0 && (poll_timeout < 0 || power_timeout < poll_timeout)) {
+            poll_timeout = power_timeout;
+        }
+        int snapshot_timeout = retry_output_snapshots(get_time());
+        if (snapshot_timeout >= 0 && (poll_timeout < 0 || snapshot_timeout < poll_timeout)) {
+            poll_timeout = snapshot_timeout;
         }
 
-        // Render if animating and enough time has passed
-        if (state.animating) {
-            double current_time = get_time();
-            double frame_time = 1.0 / config.target_fps;
-            if (current_time - state.last_frame_time >= frame_time) {
-                render_frame();
+        // Start drawing outputs that an event woke up; once a frame callback is pending,
+        // frame_done draws the rest of the animation in step with the refresh
+        for (struct output *output = state.outputs; output; output = output->next) {
+            if ((output->animating || output->dirty) && output->configured &&
+                !output->frame_callback) {
+                render_frame(output);
             }
         }
+
+        if (upload_deferred_mips()) {
+            poll_timeout = 0;
+        }
     }
 
     // Cleanup
-    if (state.frame_callback) wl_callback_destroy(state.frame_callback);
+    pool_destroy(state.decode_pool);
     if (state.texture) glDeleteTextures(1, &state.texture);
     if (state.shader_program) glDeleteProgram(state.shader_program);
     if (state.blur_shader_program) glDeleteProgram(state.blur_shader_program);
+    if (state.unpremultiply_program) glDeleteProgram(state.unpremultiply_program);
+    if (state.blur_temp_texture) glDeleteTextures(1, &state.blur_temp_texture);
+    release_layer_groups();
+    if (state.blur_fbo) glDeleteFramebuffers(1, &state.blur_fbo);
     if (state.vbo) glDeleteBuffers(1, &state.vbo);
+    if (state.quad_vbo) glDeleteBuffers(1, &state.quad_vbo);
     if (state.ebo) glDeleteBuffers(1, &state.ebo);
 
-    eglDestroySurface(state.egl_display, state.egl_surface);
+    while (state.outputs) {
+        output_destroy(state.outputs);
+    }
+    if (state.presentation) wp_presentation_destroy(state.presentation);
+    eglMakeCurrent(state.egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     eglDestroyContext(state.egl_display, state.egl_context);
     eglTerminate(state.egl_display);
 
-    wl_egl_window_destroy(state.egl_window);
-    zwlr_layer_surface_v1_destroy(state.layer_surface);
-    wl_surface_destroy(state.surface);
-
     if (state.ipc_fd >= 0) close(state.ipc_fd);
+    linebuf_free(&state.ipc_events);
+    if (state.workspace_query_fd >= 0) close(state.workspace_query_fd);
+    linebuf_free(&state.workspace_reply);
+    if (state.config_watch_fd >= 0) close(state.config_watch_fd);
 
     // Clean up our IPC
     if (state.ipc_ctx) {
         ipc_cleanup(state.ipc_ctx);
     }
+    idmap_free(&state.ipc_slots);
 
     wl_display_disconnect(state.display);
 
@@ -0,0 +1,127 @@
+/*
+ * Id map for hyprlax
+ * Open-addressing hash map from non-zero 32-bit ids to array slots, used to
+ * find a layer from its IPC id without scanning the layer array
+ */
+
+#include "idmap.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Fibonacci hashing spreads sequential ids across the table
+static int bucket_for(const idmap_t* map, uint32_t id) {
+    return (int)((id * 2654435769u) & (uint32_t)(map->capacity - 1));
+}
+
+static int find_bucket(const idmap_t* map, uint32_t id) {
+    if (map->capacity == 0) return -1;
+
+    int mask = map->capacity - 1;
+    for (int i = bucket_for(map, id); ; i = (i + 1) & mask) {
+        if (map->keys[i] == id) return i;
+        if (map->keys[i] == 0) return -1;
+    }
+}
+
+static int resize(idmap_t* map, int capacity) {
+    uint32_t* keys = calloc(capacity, sizeof(uint32_t));
+    int* values = calloc(capacity, sizeof(int));
+    if (!keys || !values) {
+        free(keys);
+        free(values);
+        return -1;
+    }
+
+    uint32_t* old_keys = map->keys;
+    int* old_values = map->values;
+    int old_capacity = map->capacity;
+    map->keys = keys;
+    map->values = values;
+    map->capacity = capacity;
+
+    int mask = capacity - 1;
+    for (int i = 0; i < old_capacity; i++) {
+        if (old_keys[i] == 0) continue;
+        int j = bucket_for(map, old_keys[i]);
+        while (keys[j] != 0) j = (j + 1) & mask;
+        keys[j] = old_keys[i];
+        values[j] = old_values[i];
+    }
+
+    free(old_keys);
+    free(old_values);
+    return 0;
+}
+
+void idmap_free(idmap_t* map) {
+    if (!map) return;
+
+    free(map->keys);
+    free(map->values);
+    memset(map, 0, sizeof(*map));
+}
+
+void idmap_clear(idmap_t* map) {
+    if (!map || map->capacity == 0) return;
+
+    memset(map->keys, 0, map->capacity * sizeof(uint32_t));
+    map->count = 0;
+}
+
+int idmap_put(idmap_t* map, uint32_t id, int value) {
+    if (!map || id == 0) return -1;
+
+    int bucket = find_bucket(map, id);
+    if (bucket >= 0) {
+        map->values[bucket] = value;
+        return 0;
+    }
+
+    // Keep probe chains short
+    if ((map->count + 1) * 10 > map->capacity * 7) {
+        int capacity = map->capacity ? map->capacity * 2 : IDMAP_MIN_CAPACITY;
+        if (resize(map, capacity) < 0) return -1;
+    }
+
+    int mask = map->capacity - 1;
+    bucket = bucket_for(map, id);
+    while (map->keys[bucket] != 0) bucket = (bucket + 1) & mask;
+    map->keys[bucket] = id;
+    map->values[bucket] = value;
+    map->count++;
+    return 0;
+}
+
+int idmap_get(const idmap_t* map, uint32_t id, int* value) {
+    if (!map || id == 0) return -1;
+
+    int bucket = find_bucket(map, id);
+    if (bucket < 0) return -1;
+    if (value) *value = map->values[bucket];
+    return 0;
+}
+
+int idmap_remove(idmap_t* map, uint32_t id) {
+    if (!map || id == 0) return -1;
+
+    int bucket = find_bucket(map, id);
+    if (bucket < 0) return -1;
+
+    // Backward-shift deletion: pull later entries of the probe chain into the hole so
+    // lookups never need tombstones
+    int mask = map->capacity - 1;
+    int hole = bucket;
+    for (int i = (hole + 1) & mask; map->keys[i] != 0; i = (i + 1) & mask) {
+        int home = bucket_for(map, map->keys[i]);
+        // Move the entry unless its home lies cyclically in (hole, i]
+        int stays = hole <= i ? (home > hole && home <= i) : (home > hole || home <= i);
+        if (!stays) {
+            map->keys[hole] = map->keys[i];
+            map->values[hole] = map->values[i];
+            hole = i;
+        }
+    }
+    map->keys[hole] = 0;
+    map->count--;
+    return 0;
+}
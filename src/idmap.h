@@ -0,0 +1,34 @@
+/*
+ * Id map for hyprlax
+ * Open-addressing hash map from non-zero 32-bit ids to array slots, used to
+ * find a layer from its IPC id without scanning the layer array
+ */
+
+#ifndef HYPRLAX_IDMAP_H
+#define HYPRLAX_IDMAP_H
+
+#include <stdint.h>
+
+#define IDMAP_MIN_CAPACITY 16  // Power of two; the table doubles past 70% load
+
+typedef struct {
+    uint32_t* keys;  // 0 marks an empty bucket
+    int* values;
+    int capacity;
+    int count;
+} idmap_t;
+
+// Lifecycle; a zeroed idmap_t is a valid empty map
+void idmap_free(idmap_t* map);
+void idmap_clear(idmap_t* map);
+
+// Insert or overwrite; returns -1 for id 0 or on allocation failure
+int idmap_put(idmap_t* map, uint32_t id, int value);
+
+// Returns 0 and stores the value if present, -1 otherwise
+int idmap_get(const idmap_t* map, uint32_t id, int* value);
+
+// Returns 0 if the id was present
+int idmap_remove(idmap_t* map, uint32_t id);
+
+#endif // HYPRLAX_IDMAP_H
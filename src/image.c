@@ -0,0 +1,259 @@
+/*
+ * Image decoding for hyprlax
+ * Thin wrapper around stb_image that is safe to call from worker threads
+ */
+
+#include "image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+int image_load(const char* path, image_t* image, char* error, size_t error_size) {
+    if (!path || !image) return -1;
+
+    memset(image, 0, sizeof(*image));
+
+    // stb_image keeps its failure reason in thread-local storage
+    int channels;
+    image->pixels = stbi_load(path, &image->width, &image->height, &channels, 4);
+    if (!image->pixels) {
+        if (error && error_size > 0) {
+            snprintf(error, error_size, "%s", stbi_failure_reason());
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+int image_probe(const char* path, int* width, int* height) {
+    int channels;
+    if (!path || !width || !height) return -1;
+    return stbi_info(path, width, height, &channels) ? 0 : -1;
+}
+
+// Source range and weights contributing to one destination pixel along an axis
+typedef struct {
+    int start;
+    int count;
+    int weights;  // Offset into the shared weight array
+} resample_span_t;
+
+// Coverage weights of source pixels [start, start + count) for each destination pixel
+static float* build_spans(int src_size, int dst_size, resample_span_t* spans) {
+    double scale = (double)src_size / dst_size;
+    int max_taps = (int)scale + 2;
+    float* weights = malloc((size_t)dst_size * max_taps * sizeof(float));
+    if (!weights) return NULL;
+
+    for (int i = 0; i < dst_size; i++) {
+        double begin = i * scale;
+        double end = begin + scale;
+        int first = (int)begin;
+        int last = (int)end;
+        if (end == (int)end && last > first) last--;  // Span ends exactly on a pixel edge
+        if (last >= src_size) last = src_size - 1;
+
+        spans[i].start = first;
+        spans[i].count = last - first + 1;
+        spans[i].weights = i * max_taps;
+
+        float* w = weights + spans[i].weights;
+        double total = 0.0;
+        for (int j = 0; j < spans[i].count; j++) {
+            double lo = first + j > begin ? first + j : begin;
+            double hi = first + j + 1 < end ? first + j + 1 : end;
+            w[j] = hi > lo ? (float)(hi - lo) : 0.0f;
+            total += w[j];
+        }
+        for (int j = 0; j < spans[i].count; j++) {
+            w[j] = total > 0.0 ? (float)(w[j] / total) : 0.0f;
+        }
+    }
+
+    return weights;
+}
+
+int image_resize(const image_t* src, image_t* dst, int width, int height) {
+    if (!src || !src->pixels || !dst || width < 1 || height < 1) return -1;
+
+    memset(dst, 0, sizeof(*dst));
+    resample_span_t* x_spans = malloc((size_t)width * sizeof(resample_span_t));
+    resample_span_t* y_spans = malloc((size_t)height * sizeof(resample_span_t));
+    float* row = malloc((size_t)src->width * 4 * sizeof(float));
+    float* x_weights = x_spans ? build_spans(src->width, width, x_spans) : NULL;
+    float* y_weights = y_spans ? build_spans(src->height, height, y_spans) : NULL;
+    dst->pixels = malloc((size_t)width * height * 4);
+
+    int result = -1;
+    if (x_spans && y_spans && row && x_weights && y_weights && dst->pixels) {
+        dst->width = width;
+        dst->height = height;
+
+        // Vertical pass into one float row, then horizontal pass out of it; the row stays
+        // in cache and the flat per-channel loops vectorize well
+        for (int y = 0; y < height; y++) {
+            const resample_span_t* ys = &y_spans[y];
+            const float* yw = y_weights + ys->weights;
+            const size_t row_values = (size_t)src->width * 4;
+
+            for (size_t i = 0; i < row_values; i++) row[i] = 0.0f;
+            for (int j = 0; j < ys->count; j++) {
+                const unsigned char* in = src->pixels + (size_t)(ys->start + j) * row_values;
+                const float weight = yw[j];
+                for (size_t i = 0; i < row_values; i++) {
+                    row[i] += in[i] * weight;
+                }
+            }
+
+            unsigned char* out = dst->pixels + (size_t)y * width * 4;
+            for (int x = 0; x < width; x++) {
+                const resample_span_t* xs = &x_spans[x];
+                const float* xw = x_weights + xs->weights;
+                const float* in = row + (size_t)xs->start * 4;
+                float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (int j = 0; j < xs->count; j++) {
+                    for (int c = 0; c < 4; c++) {
+                        acc[c] += in[j * 4 + c] * xw[j];
+                    }
+                }
+                for (int c = 0; c < 4; c++) {
+                    float value = acc[c] + 0.5f;
+                    out[x * 4 + c] = value >= 255.0f ? 255 : (unsigned char)value;
+                }
+            }
+        }
+        result = 0;
+    }
+
+    free(x_spans);
+    free(y_spans);
+    free(row);
+    free(x_weights);
+    free(y_weights);
+    if (result < 0) {
+        free(dst->pixels);
+        memset(dst, 0, sizeof(*dst));
+    }
+    return result;
+}
+
+void image_free(image_t* image) {
+    if (!image) return;
+
+    stbi_image_free(image->pixels);
+    image->pixels = NULL;
+    image->width = image->height = 0;
+}
+
+// Halve an RGBA8 image, averaging 2x2 blocks; odd edges reuse the last row/column
+static int downsample(const image_t* src, image_t* dst) {
+    int width = src->width > 1 ? src->width / 2 : 1;
+    int height = src->height > 1 ? src->height / 2 : 1;
+
+    dst->pixels = malloc((size_t)width * height * 4);
+    if (!dst->pixels) return -1;
+    dst->width = width;
+    dst->height = height;
+
+    for (int y = 0; y < height; y++) {
+        int y0 = y * 2 < src->height ? y * 2 : src->height - 1;
+        int y1 = y0 + 1 < src->height ? y0 + 1 : y0;
+        const unsigned char* row0 = src->pixels + (size_t)y0 * src->width * 4;
+        const unsigned char* row1 = src->pixels + (size_t)y1 * src->width * 4;
+        unsigned char* out = dst->pixels + (size_t)y * width * 4;
+
+        for (int x = 0; x < width; x++) {
+            int x0 = x * 2 < src->width ? x * 2 : src->width - 1;
+            int x1 = x0 + 1 < src->width ? x0 + 1 : x0;
+            for (int c = 0; c < 4; c++) {
+                int sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] +
+                          row1[x0 * 4 + c] + row1[x1 * 4 + c];
+                out[x * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+
+    return 0;
+}
+
+int image_generate_mips(image_t* levels, int max_levels) {
+    if (!levels || !levels[0].pixels || max_levels < 1) return 0;
+
+    int count = 1;
+    while (count < max_levels &&
+           (levels[count - 1].width > 1 || levels[count - 1].height > 1)) {
+        if (downsample(&levels[count - 1], &levels[count]) < 0) break;
+        count++;
+    }
+
+    return count;
+}
+
+void image_analyze_coverage(const image_t* image, image_coverage_t* coverage) {
+    if (!coverage) return;
+
+    coverage->opaque = 1;
+    coverage->empty = 0;
+    coverage->u0 = coverage->v0 = 0.0f;
+    coverage->u1 = coverage->v1 = 1.0f;
+    if (!image || !image->pixels || image->width <= 0 || image->height <= 0) return;
+
+    int min_x = image->width, min_y = image->height, max_x = -1, max_y = -1;
+    for (int y = 0; y < image->height; y++) {
+        const unsigned char* row = image->pixels + (size_t)y * image->width * 4;
+        int row_min = -1, row_max = -1;
+        for (int x = 0; x < image->width; x++) {
+            unsigned char alpha = row[x * 4 + 3];
+            if (alpha != 255) coverage->opaque = 0;
+            if (alpha == 0) continue;
+            if (row_min < 0) row_min = x;
+            row_max = x;
+        }
+        if (row_min < 0) continue;
+        if (row_min < min_x) min_x = row_min;
+        if (row_max > max_x) max_x = row_max;
+        if (min_y > y) min_y = y;
+        max_y = y;
+    }
+
+    if (max_x < 0) {
+        coverage->empty = 1;
+        coverage->u0 = coverage->v0 = coverage->u1 = coverage->v1 = 0.0f;
+        return;
+    }
+
+    coverage->u0 = (float)min_x / image->width;
+    coverage->v0 = (float)min_y / image->height;
+    coverage->u1 = (float)(max_x + 1) / image->width;
+    coverage->v1 = (float)(max_y + 1) / image->height;
+}
+
+uint64_t image_content_hash(const image_t* image) {
+    if (!image || !image->pixels) return 0;
+
+    // Word at a time (FxHash-style rotate, xor, multiply), then a final avalanche; this
+    // runs on worker threads over every decoded layer, so it must stay cheap
+    const uint64_t k = 0x517cc1b727220a95ULL;
+    uint64_t hash = ((uint64_t)image->width << 32) | (uint32_t)image->height;
+    const unsigned char* bytes = image->pixels;
+    size_t size = (size_t)image->width * image->height * 4;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (((hash << 5) | (hash >> 59)) ^ word) * k;
+    }
+    for (; i < size; i++) {
+        hash = (((hash << 5) | (hash >> 59)) ^ bytes[i]) * k;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
@@ -0,0 +1,46 @@
+/*
+ * Image decoding for hyprlax
+ * Thin wrapper around stb_image that is safe to call from worker threads
+ */
+
+#ifndef HYPRLAX_IMAGE_H
+#define HYPRLAX_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    unsigned char* pixels;  // RGBA8, row-major, top row first
+    int width;
+    int height;
+} image_t;
+
+// Where an image's alpha channel lets lower layers show through
+typedef struct {
+    int opaque;              // Every pixel has alpha 255
+    int empty;               // No pixel has alpha > 0
+    float u0, v0, u1, v1;    // Bounding box of pixels with alpha > 0, in texture coordinates
+} image_coverage_t;
+
+// Decode a file to RGBA8; on failure returns -1 and writes a reason to error
+int image_load(const char* path, image_t* image, char* error, size_t error_size);
+void image_free(image_t* image);
+
+// Read only the dimensions from the file header (no decode)
+int image_probe(const char* path, int* width, int* height);
+
+// Area-average (box) resample to width x height; meant for downscaling, where every
+// source pixel contributes in proportion to its coverage of the destination pixel
+int image_resize(const image_t* src, image_t* dst, int width, int height);
+
+// Box-filter levels[1..] from levels[0] down to 1x1 (or max_levels); returns the
+// total level count, each generated level must be released with image_free()
+int image_generate_mips(image_t* levels, int max_levels);
+
+// Scan the alpha channel once; a NULL or empty image reports full opaque coverage
+void image_analyze_coverage(const image_t* image, image_coverage_t* coverage);
+
+// 64-bit hash of the dimensions and pixels; equal hashes mean layers can share a texture
+uint64_t image_content_hash(const image_t* image);
+
+#endif // HYPRLAX_IMAGE_H
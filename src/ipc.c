@@ -13,6 +13,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <poll.h>
 #include <pwd.h>
 
 static void get_socket_path(char* buffer, size_t size) {
@@ -24,6 +25,60 @@ static void get_socket_path(char* buffer, size_t size) {
     snprintf(buffer, size, "%s%s.sock", IPC_SOCKET_PATH_PREFIX, user);
 }
 
+// Journal a layer change. A modify is folded into an earlier add or modify of the same
+// layer, since the renderer reads the layer's latest state anyway.
+static void append_change(ipc_change_t* changes, int* count, bool* overflowed,
+                          ipc_change_type_t type, uint32_t layer_id) {
+    if (*overflowed) return;
+
+    if (type == IPC_CHANGE_MODIFY) {
+        for (int i = 0; i < *count; i++) {
+            if (changes[i].layer_id == layer_id && changes[i].type != IPC_CHANGE_REMOVE) {
+                return;
+            }
+        }
+    }
+
+    if (*count >= IPC_MAX_CHANGES) {
+        *overflowed = true;
+        *count = 0;
+        return;
+    }
+    changes[*count].type = type;
+    changes[*count].layer_id = layer_id;
+    (*count)++;
+}
+
+// Journal a change for the renderer, or for the open transaction it was made in
+static void record_change(ipc_context_t* ctx, ipc_change_type_t type, uint32_t layer_id) {
+    ipc_client_t* client = ctx->transaction_client;
+    if (client) {
+        append_change(client->pending, &client->pending_count, &client->pending_overflowed,
+                      type, layer_id);
+    } else {
+        append_change(ctx->changes, &ctx->change_count, &ctx->changes_overflowed, type, layer_id);
+    }
+}
+
+// Close a client's transaction, moving the changes made in it to the renderer's journal.
+// Returns true if there were any.
+static bool commit_transaction(ipc_context_t* ctx, ipc_client_t* client) {
+    bool changed = client->pending_count > 0 || client->pending_overflowed;
+    if (client->pending_overflowed) {
+        ctx->changes_overflowed = true;
+        ctx->change_count = 0;
+    }
+    for (int i = 0; i < client->pending_count; i++) {
+        append_change(ctx->changes, &ctx->change_count, &ctx->changes_overflowed,
+                      client->pending[i].type, client->pending[i].layer_id);
+    }
+    client->pending_count = 0;
+    client->pending_overflowed = false;
+    client->in_transaction = false;
+    ctx->open_transactions--;
+    return changed;
+}
+
 static ipc_command_t parse_command(const char* cmd) {
     if (strcmp(cmd, "add") == 0) return IPC_CMD_ADD_LAYER;
     if (strcmp(cmd, "remove") == 0 || strcmp(cmd, "rm") == 0) return IPC_CMD_REMOVE_LAYER;
@@ -31,7 +86,11 @@ static ipc_command_t parse_command(const char* cmd) {
     if (strcmp(cmd, "list") == 0 || strcmp(cmd, "ls") == 0) return IPC_CMD_LIST_LAYERS;
     if (strcmp(cmd, "clear") == 0) return IPC_CMD_CLEAR_LAYERS;
     if (strcmp(cmd, "reload") == 0) return IPC_CMD_RELOAD_CONFIG;
+    if (strcmp(cmd, "scene") == 0) return IPC_CMD_SCENE;
     if (strcmp(cmd, "status") == 0) return IPC_CMD_GET_STATUS;
+    if (strcmp(cmd, "stats") == 0) return IPC_CMD_GET_STATS;
+    if (strcmp(cmd, "begin") == 0) return IPC_CMD_BEGIN;
+    if (strcmp(cmd, "commit") == 0) return IPC_CMD_COMMIT;
     return IPC_CMD_UNKNOWN;
 }
 
@@ -78,6 +137,10 @@ ipc_context_t* ipc_init(void) {
     // Set socket permissions to user-only
     chmod(ctx->socket_path, 0600);
 
+    for (int i = 0; i < IPC_MAX_CLIENTS; i++) {
+        ctx->clients[i].fd = -1;
+    }
+
     ctx->active = true;
     ctx->next_layer_id = 1;
 
@@ -90,6 +153,12 @@ void ipc_cleanup(ipc_context_t* ctx) {
 
     ctx->active = false;
 
+    for (int i = 0; i < IPC_MAX_CLIENTS; i++) {
+        if (ctx->clients[i].fd >= 0) {
+            close(ctx->clients[i].fd);
+        }
+    }
+
     // Clear all layers
     ipc_clear_layers(ctx);
 
@@ -102,48 +171,54 @@ void ipc_cleanup(ipc_context_t* ctx) {
     free(ctx);
 }
 
-bool ipc_process_commands(ipc_context_t* ctx) {
-    if (!ctx || !ctx->active) return false;
-
-    // Accept new connections
-    struct sockaddr_un client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    int client_fd = accept(ctx->socket_fd, (struct sockaddr*)&client_addr, &client_len);
-
-    if (client_fd < 0) {
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            fprintf(stderr, "Failed to accept IPC connection: %s\n", strerror(errno));
+// Write a whole response, waiting briefly if the client's receive buffer is full
+static bool send_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent > 0) {
+            data += sent;
+            length -= (size_t)sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+            if (poll(&pfd, 1, IPC_SEND_TIMEOUT_MS) > 0) continue;
         }
         return false;
     }
+    return true;
+}
 
-    // Read command
-    char buffer[IPC_MAX_MESSAGE_SIZE];
-    ssize_t bytes = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-    if (bytes <= 0) {
-        close(client_fd);
-        return false;
+static void close_client(ipc_context_t* ctx, ipc_client_t* client) {
+    // A client that goes away mid-transaction commits what it sent
+    if (client->in_transaction && commit_transaction(ctx, client)) {
+        ctx->sync_pending = true;
     }
-    buffer[bytes] = '\0';
+    close(client->fd);
+    client->fd = -1;
+    client->length = 0;
+    client->framed = false;
+}
 
-    // Parse and execute command
-    char* cmd = strtok(buffer, " \n");
+// Execute one command line, writing its response. Returns false for read-only commands
+// and failures, which need no layer sync.
+static bool execute_command(ipc_context_t* ctx, ipc_client_t* client, char* line,
+                            char* response, size_t size) {
+    char* cmd = strtok(line, " \t");
     if (!cmd) {
-        const char* error = "Error: No command specified\n";
-        send(client_fd, error, strlen(error), 0);
-        close(client_fd);
+        snprintf(response, size, "Error: No command specified\n");
         return false;
     }
 
     ipc_command_t command = parse_command(cmd);
-    char response[IPC_MAX_MESSAGE_SIZE];
     bool success = false;
 
     switch (command) {
         case IPC_CMD_ADD_LAYER: {
-            char* path = strtok(NULL, " \n");
+            char* path = strtok(NULL, " \t");
             if (!path) {
-                snprintf(response, sizeof(response), "Error: Image path required\n");
+                snprintf(response, size, "Error: Image path required\n");
                 break;
             }
 
@@ -152,7 +227,7 @@ bool ipc_process_commands(ipc_context_t* ctx) {
             int z_index = ctx->layer_count;
 
             char* param;
-            while ((param = strtok(NULL, " \n"))) {
+            while ((param = strtok(NULL, " \t"))) {
                 if (strncmp(param, "scale=", 6) == 0) {
                     scale = atof(param + 6);
                 } else if (strncmp(param, "opacity=", 8) == 0) {
@@ -168,47 +243,47 @@ bool ipc_process_commands(ipc_context_t* ctx) {
 
             uint32_t id = ipc_add_layer(ctx, path, scale, opacity, x_offset, y_offset, z_index);
             if (id > 0) {
-                snprintf(response, sizeof(response), "Layer added with ID: %u\n", id);
+                snprintf(response, size, "Layer added with ID: %u\n", id);
                 success = true;
             } else {
-                snprintf(response, sizeof(response), "Error: Failed to add layer\n");
+                snprintf(response, size, "Error: Failed to add layer\n");
             }
             break;
         }
 
         case IPC_CMD_REMOVE_LAYER: {
-            char* id_str = strtok(NULL, " \n");
+            char* id_str = strtok(NULL, " \t");
             if (!id_str) {
-                snprintf(response, sizeof(response), "Error: Layer ID required\n");
+                snprintf(response, size, "Error: Layer ID required\n");
                 break;
             }
 
             uint32_t id = atoi(id_str);
             if (ipc_remove_layer(ctx, id)) {
-                snprintf(response, sizeof(response), "Layer %u removed\n", id);
+                snprintf(response, size, "Layer %u removed\n", id);
                 success = true;
             } else {
-                snprintf(response, sizeof(response), "Error: Layer %u not found\n", id);
+                snprintf(response, size, "Error: Layer %u not found\n", id);
             }
             break;
         }
 
         case IPC_CMD_MODIFY_LAYER: {
-            char* id_str = strtok(NULL, " \n");
-            char* property = strtok(NULL, " \n");
-            char* value = strtok(NULL, " \n");
+            char* id_str = strtok(NULL, " \t");
+            char* property = strtok(NULL, " \t");
+            char* value = strtok(NULL, " \t");
 
             if (!id_str || !property || !value) {
-                snprintf(response, sizeof(response), "Error: Usage: modify <id> <property> <value>\n");
+                snprintf(response, size, "Error: Usage: modify <id> <property> <value>\n");
                 break;
             }
 
             uint32_t id = atoi(id_str);
             if (ipc_modify_layer(ctx, id, property, value)) {
-                snprintf(response, sizeof(response), "Layer %u modified\n", id);
+                snprintf(response, size, "Layer %u modified\n", id);
                 success = true;
             } else {
-                snprintf(response, sizeof(response), "Error: Failed to modify layer %u\n", id);
+                snprintf(response, size, "Error: Failed to modify layer %u\n", id);
             }
             break;
         }
@@ -216,42 +291,258 @@ bool ipc_process_commands(ipc_context_t* ctx) {
         case IPC_CMD_LIST_LAYERS: {
             char* list = ipc_list_layers(ctx);
             if (list) {
-                strncpy(response, list, sizeof(response) - 1);
-                response[sizeof(response) - 1] = '\0';
+                strncpy(response, list, size - 1);
+                response[size - 1] = '\0';
                 free(list);
-                success = true;
             } else {
-                snprintf(response, sizeof(response), "No layers\n");
-                success = true;
+                snprintf(response, size, "No layers\n");
             }
+            success = true;
             break;
         }
 
         case IPC_CMD_CLEAR_LAYERS:
             ipc_clear_layers(ctx);
-            snprintf(response, sizeof(response), "All layers cleared\n");
+            snprintf(response, size, "All layers cleared\n");
             success = true;
             break;
 
-        case IPC_CMD_GET_STATUS:
-            snprintf(response, sizeof(response),
+        case IPC_CMD_GET_STATUS: {
+            int len = snprintf(response, size,
                 "Status: Active\nLayers: %d/%d\nSocket: %s\n",
                 ctx->layer_count, IPC_MAX_LAYERS, ctx->socket_path);
+            if (ctx->format_memory && len >= 0 && (size_t)len < size) {
+                ctx->format_memory(response + len, size - len);
+            }
             success = true;
             break;
+        }
+
+        case IPC_CMD_GET_STATS: {
+            if (!ctx->stats) {
+                snprintf(response, size, "Error: Frame statistics not available\n");
+                break;
+            }
+
+            char* arg = strtok(NULL, " \t");
+            if (arg && strcmp(arg, "reset") == 0) {
+                stats_reset(ctx->stats);
+                snprintf(response, size, "Frame statistics reset\n");
+            } else if (stats_format(ctx->stats, response, size) < 0) {
+                snprintf(response, size, "Error: Failed to format frame statistics\n");
+            }
+            // Read-only query: no layer sync or redraw needed, which would skew the numbers
+            break;
+        }
+
+        case IPC_CMD_RELOAD_CONFIG:
+            if (!ctx->reload_config) {
+                snprintf(response, size, "Error: Config reload not available\n");
+                break;
+            }
+            success = ctx->reload_config(response, size);
+            break;
+
+        case IPC_CMD_SCENE: {
+            char* path = strtok(NULL, " \t");
+            if (!path) {
+                snprintf(response, size, "Error: Usage: scene <config> [in=seconds] [fade=seconds]\n");
+                break;
+            }
+
+            double delay = 0.0, fade = IPC_SCENE_DEFAULT_FADE;
+            char* param;
+            while ((param = strtok(NULL, " \t"))) {
+                if (strncmp(param, "in=", 3) == 0) {
+                    delay = atof(param + 3);
+                } else if (strncmp(param, "fade=", 5) == 0) {
+                    fade = atof(param + 5);
+                }
+            }
+            if (delay < 0.0) delay = 0.0;
+            if (fade < 0.0) fade = 0.0;
+
+            if (!ctx->queue_scene) {
+                snprintf(response, size, "Error: Scenes not available\n");
+                break;
+            }
+            success = ctx->queue_scene(path, delay, fade, response, size);
+            break;
+        }
+
+        case IPC_CMD_BEGIN:
+            if (client->in_transaction) {
+                snprintf(response, size, "Error: Transaction already open\n");
+                break;
+            }
+            client->in_transaction = true;
+            ctx->open_transactions++;
+            snprintf(response, size, "Transaction started\n");
+            break;
+
+        case IPC_CMD_COMMIT:
+            if (!client->in_transaction) {
+                snprintf(response, size, "Error: No transaction open\n");
+                break;
+            }
+            success = commit_transaction(ctx, client);
+            snprintf(response, size, "Transaction committed\n");
+            break;
 
         default:
-            snprintf(response, sizeof(response), "Error: Unknown command '%s'\n", cmd);
+            snprintf(response, size, "Error: Unknown command '%s'\n", cmd);
             break;
     }
 
-    // Send response
-    send(client_fd, response, strlen(response), 0);
-    close(client_fd);
-
     return success;
 }
 
+// Run one command from a client and answer it. Returns false if the client must be dropped.
+static bool handle_line(ipc_context_t* ctx, ipc_client_t* client, char* line) {
+    size_t length = strlen(line);
+    if (length > 0 && line[length - 1] == '\r') {
+        line[--length] = '\0';
+    }
+    // Blank lines get no response, so they don't shift a pipelining client's count
+    if (client->framed && strspn(line, " \t") == length) return true;
+
+    // Inside a transaction, changes are journaled for the client until it commits
+    char response[IPC_MAX_MESSAGE_SIZE];
+    ctx->transaction_client = client->in_transaction ? client : NULL;
+    bool success = execute_command(ctx, client, line, response, sizeof(response) - 1);
+    if (success && !client->in_transaction) {
+        ctx->sync_pending = true;
+    }
+    ctx->transaction_client = NULL;
+
+    // Legacy clients read a single bare response until the connection closes
+    if (client->framed) {
+        strcat(response, "\n");
+    }
+    return send_all(client->fd, response, strlen(response));
+}
+
+// Execute every complete line in the client's buffer, keeping any partial tail
+static bool handle_lines(ipc_context_t* ctx, ipc_client_t* client) {
+    size_t start = 0;
+    char* newline;
+    while ((newline = memchr(client->buffer + start, '\n', client->length - start))) {
+        *newline = '\0';
+        client->framed = true;
+        if (!handle_line(ctx, client, client->buffer + start)) return false;
+        start = (size_t)(newline - client->buffer) + 1;
+    }
+
+    client->length -= start;
+    memmove(client->buffer, client->buffer + start, client->length);
+    return true;
+}
+
+// Drain a client socket. Returns false once the client has gone away or must be dropped.
+static bool read_client(ipc_context_t* ctx, ipc_client_t* client) {
+    for (;;) {
+        // Leave room for the terminator of a final unterminated command
+        size_t space = sizeof(client->buffer) - 1 - client->length;
+        if (space == 0) {
+            send_all(client->fd, "Error: Command too long\n\n", 25);
+            return false;
+        }
+
+        ssize_t bytes = recv(client->fd, client->buffer + client->length, space, 0);
+        if (bytes > 0) {
+            client->length += (size_t)bytes;
+            if (!handle_lines(ctx, client)) return false;
+            continue;
+        }
+        if (bytes < 0 && errno == EINTR) continue;
+
+        bool drained = bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        if (drained && (client->framed || client->length == 0)) {
+            return true;  // Wait for the rest of the line
+        }
+        if (bytes < 0 && !drained) return false;
+
+        // End of stream, or a legacy client that sent one command without a newline:
+        // run what is left and hang up
+        if (client->length > 0) {
+            client->buffer[client->length] = '\0';
+            handle_line(ctx, client, client->buffer);
+        }
+        return false;
+    }
+}
+
+static void accept_clients(ipc_context_t* ctx) {
+    for (;;) {
+        int client_fd = accept(ctx->socket_fd, NULL, NULL);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                fprintf(stderr, "Failed to accept IPC connection: %s\n", strerror(errno));
+            }
+            return;
+        }
+
+        fcntl(client_fd, F_SETFL, O_NONBLOCK);
+        fcntl(client_fd, F_SETFD, FD_CLOEXEC);
+
+        ipc_client_t* client = NULL;
+        for (int i = 0; i < IPC_MAX_CLIENTS; i++) {
+            if (ctx->clients[i].fd < 0) {
+                client = &ctx->clients[i];
+                break;
+            }
+        }
+        if (!client) {
+            const char* error = "Error: Too many IPC clients\n";
+            send(client_fd, error, strlen(error), MSG_NOSIGNAL);
+            close(client_fd);
+            continue;
+        }
+
+        client->fd = client_fd;
+        client->length = 0;
+        client->framed = false;
+        client->in_transaction = false;
+        client->pending_count = 0;
+        client->pending_overflowed = false;
+    }
+}
+
+bool ipc_process_commands(ipc_context_t* ctx) {
+    if (!ctx || !ctx->active) return false;
+
+    accept_clients(ctx);
+
+    for (int i = 0; i < IPC_MAX_CLIENTS; i++) {
+        ipc_client_t* client = &ctx->clients[i];
+        if (client->fd >= 0 && !read_client(ctx, client)) {
+            close_client(ctx, client);
+        }
+    }
+
+    // A transaction's changes only reach the journal on commit, so the whole batch is
+    // applied with one sync and one redraw
+    if (!ctx->sync_pending) return false;
+    ctx->sync_pending = false;
+    return true;
+}
+
+int ipc_get_poll_fds(const ipc_context_t* ctx, struct pollfd* fds, int max_fds) {
+    if (!ctx || !ctx->active || !fds || max_fds <= 0) return 0;
+
+    int count = 0;
+    fds[count].fd = ctx->socket_fd;
+    fds[count++].events = POLLIN;
+    for (int i = 0; i < IPC_MAX_CLIENTS && count < max_fds; i++) {
+        if (ctx->clients[i].fd >= 0) {
+            fds[count].fd = ctx->clients[i].fd;
+            fds[count++].events = POLLIN;
+        }
+    }
+    return count;
+}
+
 uint32_t ipc_add_layer(ipc_context_t* ctx, const char* image_path, float scale, float opacity, float x_offset, float y_offset, int z_index) {
     if (!ctx || !image_path || ctx->layer_count >= IPC_MAX_LAYERS) {
         return 0;
@@ -277,6 +568,7 @@ uint32_t ipc_add_layer(ipc_context_t* ctx, const char* image_path, float scale,
 
     ctx->layers[ctx->layer_count++] = layer;
     ipc_sort_layers(ctx);
+    record_change(ctx, IPC_CHANGE_ADD, layer->id);
 
     return layer->id;
 }
@@ -295,6 +587,7 @@ bool ipc_remove_layer(ipc_context_t* ctx, uint32_t layer_id) {
                 ctx->layers[j] = ctx->layers[j + 1];
             }
             ctx->layers[--ctx->layer_count] = NULL;
+            record_change(ctx, IPC_CHANGE_REMOVE, layer_id);
 
             return true;
         }
@@ -331,6 +624,7 @@ bool ipc_modify_layer(ipc_context_t* ctx, uint32_t layer_id, const char* propert
     if (needs_sort) {
         ipc_sort_layers(ctx);
     }
+    record_change(ctx, IPC_CHANGE_MODIFY, layer_id);
 
     return true;
 }
@@ -362,6 +656,7 @@ void ipc_clear_layers(ipc_context_t* ctx) {
 
     for (int i = 0; i < ctx->layer_count; i++) {
         if (ctx->layers[i]) {
+            record_change(ctx, IPC_CHANGE_REMOVE, ctx->layers[i]->id);
             free(ctx->layers[i]->image_path);
             free(ctx->layers[i]);
             ctx->layers[i] = NULL;
@@ -370,6 +665,33 @@ void ipc_clear_layers(ipc_context_t* ctx) {
     ctx->layer_count = 0;
 }
 
+void ipc_clear_changes(ipc_context_t* ctx) {
+    if (!ctx) return;
+
+    ctx->change_count = 0;
+    ctx->changes_overflowed = false;
+}
+
+bool ipc_sync_layers(ipc_context_t* ctx, const ipc_sync_ops_t* ops) {
+    if (!ctx || !ops) return false;
+
+    bool changed = false;
+    if (ctx->changes_overflowed) {
+        // Too much happened to journal: reconcile every layer on both sides
+        changed |= ops->prune(ops->data);
+        for (int i = 0; i < ctx->layer_count; i++) {
+            changed |= ops->apply(ctx->layers[i]->id, ops->data);
+        }
+    } else {
+        for (int i = 0; i < ctx->change_count; i++) {
+            changed |= ops->apply(ctx->changes[i].layer_id, ops->data);
+        }
+    }
+
+    ipc_clear_changes(ctx);
+    return changed;
+}
+
 layer_t* ipc_find_layer(ipc_context_t* ctx, uint32_t layer_id) {
     if (!ctx) return NULL;
 
@@ -6,12 +6,20 @@
 #ifndef HYPRLAX_IPC_H
 #define HYPRLAX_IPC_H
 
+#include <poll.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "stats.h"
+
 #define IPC_SOCKET_PATH_PREFIX "/tmp/hyprlax-"
 #define IPC_MAX_MESSAGE_SIZE 4096
 #define IPC_MAX_LAYERS 32
+#define IPC_MAX_CHANGES 64  // Journal entries kept between renderer syncs
+#define IPC_MAX_CLIENTS 8   // Persistent connections served at once
+#define IPC_SEND_TIMEOUT_MS 100  // How long a client may stall a response before it is dropped
+#define IPC_SCENE_DEFAULT_FADE 1.0  // Seconds a `scene` crossfade takes unless fade= is given
 
 typedef enum {
     IPC_CMD_ADD_LAYER,
@@ -20,7 +28,11 @@ typedef enum {
     IPC_CMD_LIST_LAYERS,
     IPC_CMD_CLEAR_LAYERS,
     IPC_CMD_RELOAD_CONFIG,
+    IPC_CMD_SCENE,
     IPC_CMD_GET_STATUS,
+    IPC_CMD_GET_STATS,
+    IPC_CMD_BEGIN,
+    IPC_CMD_COMMIT,
     IPC_CMD_UNKNOWN
 } ipc_command_t;
 
@@ -35,11 +47,49 @@ typedef struct {
     uint32_t id;
 } layer_t;
 
+typedef enum {
+    IPC_CHANGE_ADD,
+    IPC_CHANGE_REMOVE,
+    IPC_CHANGE_MODIFY
+} ipc_change_type_t;
+
+// One journal entry; the renderer re-reads the layer's current state by id
+typedef struct {
+    ipc_change_type_t type;
+    uint32_t layer_id;
+} ipc_change_t;
+
+// Renderer side of ipc_sync_layers()
+typedef struct {
+    // Bring the renderer's layer for one id in line with ipc_find_layer(); returns true
+    // if the composited frame changed
+    bool (*apply)(uint32_t layer_id, void* data);
+    // After the journal overflowed: drop renderer layers whose id no longer exists;
+    // returns true if the composited frame changed
+    bool (*prune)(void* data);
+    void* data;
+} ipc_sync_ops_t;
+
 typedef struct {
     ipc_command_t command;
     char args[IPC_MAX_MESSAGE_SIZE - sizeof(ipc_command_t)];
 } ipc_message_t;
 
+// A connected client. Commands are newline-terminated and answered in order; each
+// response ends with a blank line so pipelining clients can split them.
+typedef struct {
+    int fd;                             // -1 when the slot is free
+    char buffer[IPC_MAX_MESSAGE_SIZE];  // Received bytes not yet terminated by a newline
+    size_t length;
+    bool framed;                        // Has sent a newline; otherwise a legacy one-shot client
+    bool in_transaction;                // Between begin and commit
+    // Layer changes made inside the open transaction, handed to the renderer's journal
+    // on commit so other clients' changes keep syncing meanwhile
+    ipc_change_t pending[IPC_MAX_CHANGES];
+    int pending_count;
+    bool pending_overflowed;
+} ipc_client_t;
+
 typedef struct {
     int socket_fd;
     char socket_path[256];
@@ -47,12 +97,32 @@ typedef struct {
     layer_t* layers[IPC_MAX_LAYERS];
     int layer_count;
     uint32_t next_layer_id;
+    frame_stats_t* stats;  // Render loop timings, owned by the renderer (may be NULL)
+    // Renderer hook for `reload`: re-applies the config file and writes the result into
+    // response; returns false if nothing changed because the file couldn't be used (may be NULL)
+    bool (*reload_config)(char* response, size_t size);
+    // Renderer hook for `scene`: preloads the layers of another config file and crossfades
+    // to them `delay` seconds from now over `fade` seconds (may be NULL)
+    bool (*queue_scene)(const char* path, double delay, double fade, char* response, size_t size);
+    // Renderer hook for `status`: writes texture memory totals into out (may be NULL)
+    void (*format_memory)(char* out, size_t size);
+
+    // Layer changes since the renderer last synced, oldest first
+    ipc_change_t changes[IPC_MAX_CHANGES];
+    int change_count;
+    bool changes_overflowed;  // Journal filled up; the renderer must resync every layer
+
+    ipc_client_t clients[IPC_MAX_CLIENTS];
+    int open_transactions;  // Clients between begin and commit
+    bool sync_pending;      // Changes reached the journal since ipc_process_commands last returned true
+    ipc_client_t* transaction_client;  // Client whose in-transaction command is running
 } ipc_context_t;
 
 // IPC lifecycle functions
 ipc_context_t* ipc_init(void);
 void ipc_cleanup(ipc_context_t* ctx);
 bool ipc_process_commands(ipc_context_t* ctx);
+int ipc_get_poll_fds(const ipc_context_t* ctx, struct pollfd* fds, int max_fds);
 
 // Layer management functions
 uint32_t ipc_add_layer(ipc_context_t* ctx, const char* image_path, float scale, float opacity, float x_offset, float y_offset, int z_index);
@@ -61,6 +131,13 @@ bool ipc_modify_layer(ipc_context_t* ctx, uint32_t layer_id, const char* propert
 char* ipc_list_layers(ipc_context_t* ctx);
 void ipc_clear_layers(ipc_context_t* ctx);
 
+// Change journal, consumed by the renderer
+void ipc_clear_changes(ipc_context_t* ctx);
+
+// Hand the journaled layers to the renderer (every layer, after a prune, if the journal
+// overflowed) and clear the journal. Returns true if the composited frame changed.
+bool ipc_sync_layers(ipc_context_t* ctx, const ipc_sync_ops_t* ops);
+
 // Helper functions
 layer_t* ipc_find_layer(ipc_context_t* ctx, uint32_t layer_id);
 void ipc_sort_layers(ipc_context_t* ctx);
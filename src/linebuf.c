@@ -0,0 +1,89 @@
+/*
+ * Line buffer for hyprlax
+ * Growing buffer that frames a non-blocking byte stream into newline-terminated
+ * lines, keeping a partial line until the rest of it arrives
+ */
+
+#include "linebuf.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+void linebuf_free(linebuf_t* buf) {
+    if (!buf) return;
+
+    free(buf->data);
+    memset(buf, 0, sizeof(*buf));
+}
+
+// Make room for at least `extra` more bytes after the data,
+// moving the unconsumed tail to the front before growing. Returns 1 when the buffer
+// is at its limit but holds complete lines the caller should consume first.
+static int reserve(linebuf_t* buf, size_t extra) {
+    if (buf->start > 0) {
+        buf->length -= buf->start;
+        memmove(buf->data, buf->data + buf->start, buf->length);
+        buf->start = 0;
+    }
+
+    size_t needed = buf->length + extra;
+    if (needed <= buf->capacity) return 0;
+
+    if (needed > LINEBUF_MAX_CAPACITY) {
+        if (memchr(buf->data, '\n', buf->length)) return 1;
+
+        fprintf(stderr, "Discarding %zu byte line without a newline\n", buf->length);
+        buf->length = 0;
+        needed = extra;
+        if (needed <= buf->capacity) return 0;
+    }
+
+    size_t capacity = buf->capacity ? buf->capacity : LINEBUF_MIN_CAPACITY;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    char* data = realloc(buf->data, capacity);
+    if (!data) return -1;
+    buf->data = data;
+    buf->capacity = capacity;
+    return 0;
+}
+
+long linebuf_fill(linebuf_t* buf, int fd) {
+    if (!buf || fd < 0) return LINEBUF_CLOSED;
+
+    long total = 0;
+    for (;;) {
+        // Read straight into the buffer, growing it when a read fills it up.
+        // A full buffer stops early; the fd is still readable, so poll wakes us again.
+        int reserved = reserve(buf, LINEBUF_MIN_CAPACITY);
+        if (reserved < 0) return LINEBUF_NO_MEMORY;
+        if (reserved > 0) return total;
+
+        size_t space = buf->capacity - buf->length;
+        ssize_t n = read(fd, buf->data + buf->length, space);
+        if (n > 0) {
+            buf->length += (size_t)n;
+            total += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return total;
+        return LINEBUF_CLOSED;
+    }
+}
+
+char* linebuf_next(linebuf_t* buf) {
+    if (!buf || buf->start >= buf->length) return NULL;
+
+    char* line = buf->data + buf->start;
+    char* newline = memchr(line, '\n', buf->length - buf->start);
+    if (!newline) return NULL;
+
+    *newline = '\0';
+    buf->start = (size_t)(newline - buf->data) + 1;
+    return line;
+}
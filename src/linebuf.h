@@ -0,0 +1,40 @@
+/*
+ * Line buffer for hyprlax
+ * Growing buffer that frames a non-blocking byte stream into newline-terminated
+ * lines, keeping a partial line until the rest of it arrives
+ */
+
+#ifndef HYPRLAX_LINEBUF_H
+#define HYPRLAX_LINEBUF_H
+
+#include <stddef.h>
+
+#define LINEBUF_MIN_CAPACITY 1024
+#define LINEBUF_MAX_CAPACITY (1024 * 1024)  // A longer unterminated line is discarded
+
+// linebuf_fill() errors
+#define LINEBUF_CLOSED -1     // Peer closed the stream, or a read error
+#define LINEBUF_NO_MEMORY -2  // The buffer couldn't grow; the stream is still open
+
+typedef struct {
+    char* data;
+    size_t capacity;
+    size_t start;   // First byte not yet returned as a line
+    size_t length;  // End of the received bytes
+} linebuf_t;
+
+// Lifecycle; a zeroed linebuf_t is a valid empty buffer
+void linebuf_free(linebuf_t* buf);
+
+// Read from a non-blocking fd until it would block (or the buffer is full of
+// complete lines). Returns the number of bytes read, LINEBUF_CLOSED once the peer
+// has closed the stream or on a read error, or LINEBUF_NO_MEMORY if the buffer
+// couldn't grow, in which case the fd stays readable and the fill can be retried.
+// Lines already buffered stay readable either way.
+long linebuf_fill(linebuf_t* buf, int fd);
+
+// Next complete line, without its newline, or NULL if only a partial line is left.
+// The pointer is valid until the next fill.
+char* linebuf_next(linebuf_t* buf);
+
+#endif // HYPRLAX_LINEBUF_H
@@ -0,0 +1,203 @@
+/*
+ * Worker thread pool for hyprlax
+ * Runs blocking jobs (image decoding) off the render thread and hands the
+ * results back through an eventfd that the main loop can poll
+ */
+
+#include "pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+typedef struct pool_job {
+    pool_run_fn run;
+    pool_done_fn done;
+    void* arg;
+    struct pool_job* next;
+} pool_job_t;
+
+typedef struct {
+    pool_job_t* head;
+    pool_job_t* tail;
+} job_queue_t;
+
+struct worker_pool {
+    pthread_t threads[POOL_MAX_THREADS];
+    int thread_count;
+    int event_fd;
+    int pending;  // Only touched by the owning thread
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    job_queue_t queued;     // Waiting for a worker
+    job_queue_t completed;  // Waiting for pool_dispatch()
+    int shutdown;
+};
+
+static void queue_push(job_queue_t* queue, pool_job_t* job) {
+    job->next = NULL;
+    if (queue->tail) {
+        queue->tail->next = job;
+    } else {
+        queue->head = job;
+    }
+    queue->tail = job;
+}
+
+static pool_job_t* queue_pop(job_queue_t* queue) {
+    pool_job_t* job = queue->head;
+    if (job) {
+        queue->head = job->next;
+        if (!queue->head) queue->tail = NULL;
+    }
+    return job;
+}
+
+static void* worker_main(void* data) {
+    worker_pool_t* pool = data;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->queued.head && !pool->shutdown) {
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        }
+        if (pool->shutdown) break;
+
+        pool_job_t* job = queue_pop(&pool->queued);
+        pthread_mutex_unlock(&pool->lock);
+
+        if (job->run) job->run(job->arg);
+
+        pthread_mutex_lock(&pool->lock);
+        queue_push(&pool->completed, job);
+
+        uint64_t one = 1;
+        if (write(pool->event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            perror("pool: eventfd write");
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+worker_pool_t* pool_create(int threads) {
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > POOL_MAX_THREADS) threads = POOL_MAX_THREADS;
+
+    worker_pool_t* pool = calloc(1, sizeof(worker_pool_t));
+    if (!pool) return NULL;
+
+    pool->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (pool->event_fd < 0) {
+        perror("pool: eventfd");
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            fprintf(stderr, "pool: failed to start worker thread %d\n", i);
+            break;
+        }
+        pool->thread_count++;
+    }
+
+    if (pool->thread_count == 0) {
+        pool_destroy(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void pool_destroy(worker_pool_t* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    // Workers are gone; hand every remaining job back so its owner can free it
+    pool_job_t* job;
+    while ((job = queue_pop(&pool->completed))) {
+        if (job->done) job->done(job->arg, 1);
+        free(job);
+    }
+    while ((job = queue_pop(&pool->queued))) {
+        if (job->done) job->done(job->arg, 1);
+        free(job);
+    }
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+    close(pool->event_fd);
+    free(pool);
+}
+
+int pool_submit(worker_pool_t* pool, pool_run_fn run, pool_done_fn done, void* arg) {
+    if (!pool || !run) return -1;
+
+    pool_job_t* job = malloc(sizeof(pool_job_t));
+    if (!job) return -1;
+    job->run = run;
+    job->done = done;
+    job->arg = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    queue_push(&pool->queued, job);
+    pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool->pending++;
+    return 0;
+}
+
+int pool_get_fd(const worker_pool_t* pool) {
+    return pool ? pool->event_fd : -1;
+}
+
+int pool_dispatch(worker_pool_t* pool) {
+    if (!pool) return 0;
+
+    // Reset the counter first so completions racing with us re-arm the fd
+    uint64_t count;
+    if (read(pool->event_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        perror("pool: eventfd read");
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool_job_t* job = pool->completed.head;
+    pool->completed.head = pool->completed.tail = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    int dispatched = 0;
+    while (job) {
+        pool_job_t* next = job->next;
+        if (job->done) job->done(job->arg, 0);
+        free(job);
+        pool->pending--;
+        dispatched++;
+        job = next;
+    }
+
+    return dispatched;
+}
+
+int pool_pending(const worker_pool_t* pool) {
+    return pool ? pool->pending : 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * Worker thread pool for hyprlax
+ * Runs blocking jobs (image decoding) off the render thread and hands the
+ * results back through an eventfd that the main loop can poll
+ */
+
+#ifndef HYPRLAX_POOL_H
+#define HYPRLAX_POOL_H
+
+#define POOL_MAX_THREADS 8
+
+// Runs on a worker thread; must not touch GL or global state
+typedef void (*pool_run_fn)(void* arg);
+
+// Runs on the thread calling pool_dispatch(); cancelled is set for jobs still
+// outstanding when the pool is destroyed, so the callback only needs to free arg
+typedef void (*pool_done_fn)(void* arg, int cancelled);
+
+typedef struct worker_pool worker_pool_t;
+
+// Lifecycle (threads <= 0 picks a count from the online CPUs)
+worker_pool_t* pool_create(int threads);
+void pool_destroy(worker_pool_t* pool);
+
+// Queue a job; returns 0 on success, -1 on failure (arg is untouched)
+int pool_submit(worker_pool_t* pool, pool_run_fn run, pool_done_fn done, void* arg);
+
+// Completion notification: readable when finished jobs are waiting
+int pool_get_fd(const worker_pool_t* pool);
+
+// Run done callbacks for all finished jobs; returns how many were dispatched
+int pool_dispatch(worker_pool_t* pool);
+
+// Jobs submitted but not yet dispatched
+int pool_pending(const worker_pool_t* pool);
+
+#endif // HYPRLAX_POOL_H
@@ -0,0 +1,104 @@
+/*
+ * Power-aware render policy for hyprlax
+ * Reads the battery state from sysfs and holds the render profile applied on AC,
+ * on battery and while a fullscreen window covers the focused output
+ */
+
+#include "power.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+
+static const char* profile_names[POWER_PROFILE_COUNT] = {
+    "ac", "battery", "fullscreen"
+};
+
+void power_profiles_default(power_profile_t profiles[POWER_PROFILE_COUNT]) {
+    for (int i = 0; i < POWER_PROFILE_COUNT; i++) {
+        profiles[i].fps = 0;
+        profiles[i].duration_scale = 1.0f;
+        profiles[i].blur_layers = 1;
+        profiles[i].pause = 0;
+    }
+    profiles[POWER_PROFILE_BATTERY].fps = 60;
+}
+
+int power_profile_from_name(const char* name) {
+    if (!name) return -1;
+    for (int i = 0; i < POWER_PROFILE_COUNT; i++) {
+        if (strcmp(name, profile_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+const char* power_profile_name(power_profile_id_t id) {
+    return (unsigned)id < POWER_PROFILE_COUNT ? profile_names[id] : "unknown";
+}
+
+int power_profile_set(power_profile_t* profile, const char* setting, const char* value) {
+    if (!profile || !setting || !value) return -1;
+
+    char* end;
+    double number = strtod(value, &end);
+    if (end == value || *end != '\0' || number < 0.0) return -1;
+
+    if (strcmp(setting, "fps") == 0) {
+        profile->fps = (int)number;
+    } else if (strcmp(setting, "duration_scale") == 0) {
+        profile->duration_scale = (float)number;
+    } else if (strcmp(setting, "blur_layers") == 0) {
+        profile->blur_layers = number != 0.0;
+    } else if (strcmp(setting, "pause") == 0) {
+        profile->pause = number != 0.0;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// First line of a sysfs attribute, without the newline
+static int read_attribute(const char* dir, const char* supply, const char* name,
+                          char* out, size_t size) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s/%s", dir, supply, name);
+    FILE* file = fopen(path, "r");
+    if (!file) return -1;
+
+    int result = fgets(out, (int)size, file) ? 0 : -1;
+    fclose(file);
+    if (result == 0) out[strcspn(out, "\n")] = '\0';
+    return result;
+}
+
+int power_on_battery(const char* supply_dir) {
+    DIR* dir = opendir(supply_dir);
+    if (!dir) return -1;
+
+    int external_online = 0, discharging = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir))) {
+        if (entry->d_name[0] == '.') continue;
+
+        char type[32], value[32];
+        if (read_attribute(supply_dir, entry->d_name, "type", type, sizeof(type)) < 0) continue;
+
+        if (strcmp(type, "Battery") == 0) {
+            // Peripheral batteries (mice, headsets) don't power the machine
+            if (read_attribute(supply_dir, entry->d_name, "scope", value, sizeof(value)) == 0 &&
+                strcmp(value, "Device") == 0) {
+                continue;
+            }
+            if (read_attribute(supply_dir, entry->d_name, "status", value, sizeof(value)) == 0 &&
+                strcmp(value, "Discharging") == 0) {
+                discharging = 1;
+            }
+        } else if (read_attribute(supply_dir, entry->d_name, "online", value, sizeof(value)) == 0 &&
+                   atoi(value) == 1) {
+            external_online = 1;  // Mains, USB (including USB-C PD) and wireless chargers
+        }
+    }
+    closedir(dir);
+
+    return !external_online && discharging;
+}
@@ -0,0 +1,44 @@
+/*
+ * Power-aware render policy for hyprlax
+ * Reads the battery state from sysfs and holds the render profile applied on AC,
+ * on battery and while a fullscreen window covers the focused output
+ */
+
+#ifndef HYPRLAX_POWER_H
+#define HYPRLAX_POWER_H
+
+#define POWER_SUPPLY_DIR "/sys/class/power_supply"
+#define POWER_POLL_INTERVAL 10.0  // Seconds between battery state reads
+
+typedef enum {
+    POWER_PROFILE_AC,
+    POWER_PROFILE_BATTERY,
+    POWER_PROFILE_FULLSCREEN,
+    POWER_PROFILE_COUNT
+} power_profile_id_t;
+
+typedef struct {
+    int fps;               // Frame cap, applied when below --fps (0 = keep --fps)
+    float duration_scale;  // Multiplies animation durations and delays
+    int blur_layers;       // Draw layers with blur (0 skips them)
+    int pause;             // Don't animate; workspace switches jump to their target
+} power_profile_t;
+
+// Profiles as used when parallax.conf sets nothing: battery caps animations at 60 FPS,
+// the others change nothing. An output under a fullscreen window is never drawn anyway;
+// the fullscreen profile applies to the other outputs meanwhile.
+void power_profiles_default(power_profile_t profiles[POWER_PROFILE_COUNT]);
+
+// Profile id for "ac", "battery" or "fullscreen"; -1 if unknown
+int power_profile_from_name(const char* name);
+const char* power_profile_name(power_profile_id_t id);
+
+// Apply one "<setting> <value>" pair of a profile line: fps, duration_scale,
+// blur_layers or pause. Returns 0, or -1 for an unknown setting or a bad value.
+int power_profile_set(power_profile_t* profile, const char* setting, const char* value);
+
+// 1 if the machine runs on battery: no mains or USB supply is online and a battery
+// is discharging. 0 on AC or without a battery, -1 if supply_dir can't be read.
+int power_on_battery(const char* supply_dir);
+
+#endif // HYPRLAX_POWER_H
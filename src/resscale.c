@@ -0,0 +1,64 @@
+/*
+ * Dynamic resolution for hyprlax
+ * Picks the fraction of an output's resolution to composite animated frames at,
+ * from measured GPU frame times, so a busy GPU costs sharpness instead of frames
+ */
+
+#include "resscale.h"
+#include <math.h>
+
+static float quantize(float scale, float min_scale) {
+    scale = floorf(scale / RESSCALE_STEP + 0.001f) * RESSCALE_STEP;
+    if (scale < min_scale) scale = min_scale;
+    if (scale > 1.0f) scale = 1.0f;
+    return scale;
+}
+
+void resscale_init(resscale_t* rs, float min_scale) {
+    if (!rs) return;
+
+    if (min_scale < RESSCALE_STEP) min_scale = RESSCALE_STEP;
+    if (min_scale > 1.0f) min_scale = 1.0f;
+    rs->scale = 1.0f;
+    rs->min_scale = min_scale;
+    rs->average_ms = 0.0;
+    rs->samples = 0;
+}
+
+int resscale_set_min(resscale_t* rs, float min_scale) {
+    if (!rs) return 0;
+
+    if (min_scale < RESSCALE_STEP) min_scale = RESSCALE_STEP;
+    if (min_scale > 1.0f) min_scale = 1.0f;
+    rs->min_scale = min_scale;
+    if (rs->scale >= min_scale) return 0;
+
+    rs->scale = min_scale;
+    rs->samples = 0;
+    return 1;
+}
+
+int resscale_update(resscale_t* rs, double gpu_ms, double budget_ms) {
+    if (!rs || gpu_ms < 0.0 || budget_ms <= 0.0) return 0;
+
+    rs->average_ms = rs->samples == 0 ? gpu_ms :
+                     rs->average_ms + (gpu_ms - rs->average_ms) * RESSCALE_SMOOTHING;
+    if (++rs->samples < RESSCALE_SETTLE_SAMPLES) return 0;
+
+    float scale = rs->scale;
+    if (rs->average_ms > budget_ms) {
+        // Shrink straight to the scale whose pixel count fits the budget
+        scale = quantize(rs->scale * (float)sqrt(budget_ms / rs->average_ms), rs->min_scale);
+    } else if (rs->average_ms < budget_ms * RESSCALE_GROW_BELOW && rs->scale < 1.0f) {
+        // Grow a step at a time; a load that went away may come back
+        float next = quantize(rs->scale + RESSCALE_STEP, rs->min_scale);
+        double ratio = (double)next / rs->scale;
+        if (rs->average_ms * ratio * ratio < budget_ms) scale = next;
+    }
+    if (scale == rs->scale) return 0;
+
+    // The average restarts from frames drawn at the new scale
+    rs->scale = scale;
+    rs->samples = 0;
+    return 1;
+}
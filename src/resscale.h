@@ -0,0 +1,35 @@
+/*
+ * Dynamic resolution for hyprlax
+ * Picks the fraction of an output's resolution to composite animated frames at,
+ * from measured GPU frame times, so a busy GPU costs sharpness instead of frames
+ */
+
+#ifndef HYPRLAX_RESSCALE_H
+#define HYPRLAX_RESSCALE_H
+
+#define RESSCALE_STEP 0.05f          // Scales are multiples of this, so targets are rarely resized
+#define RESSCALE_MIN_DEFAULT 0.5f    // Lowest scale unless configured otherwise
+#define RESSCALE_BUDGET 0.5          // Share of the frame period the composite may take on the GPU
+#define RESSCALE_GROW_BELOW 0.5      // Scale back up once frames take less than this of the budget
+#define RESSCALE_SETTLE_SAMPLES 8    // Frames measured at a new scale before it changes again
+#define RESSCALE_SMOOTHING 0.25      // Weight of each new sample in the running average
+
+typedef struct {
+    float scale;       // Current fraction of the output resolution, per axis
+    float min_scale;
+    double average_ms; // Smoothed GPU time of one composite at the current scale
+    int samples;       // Samples since the scale last changed
+} resscale_t;
+
+// Start at full resolution; min_scale is clamped to [RESSCALE_STEP, 1]
+void resscale_init(resscale_t* rs, float min_scale);
+
+// Change the minimum of a running scaler, e.g. after a reload; a scale now below it is
+// raised to it. Returns 1 if the scale changed.
+int resscale_set_min(resscale_t* rs, float min_scale);
+
+// Feed the GPU time of one composite against the time it may take. Returns 1 if the
+// scale changed. Cost is taken to follow the pixel count, i.e. the square of the scale.
+int resscale_update(resscale_t* rs, double gpu_ms, double budget_ms);
+
+#endif // HYPRLAX_RESSCALE_H
@@ -0,0 +1,120 @@
+/*
+ * Frame timing statistics for hyprlax
+ * Keeps a fixed-size ring buffer of per-frame timings for the render loop
+ */
+
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* metric_names[STATS_METRIC_COUNT] = {
+    "update", "draw", "swap", "interval", "gpu"
+};
+
+void stats_init(frame_stats_t* stats, int target_fps) {
+    if (!stats) return;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->frame_period_ms = target_fps > 0 ? 1000.0 / target_fps : 1000.0 / 60.0;
+}
+
+void stats_reset(frame_stats_t* stats) {
+    if (!stats) return;
+
+    double period = stats->frame_period_ms;
+    memset(stats, 0, sizeof(*stats));
+    stats->frame_period_ms = period;
+}
+
+void stats_record(frame_stats_t* stats, stats_metric_t metric, double ms) {
+    if (!stats || (unsigned)metric >= STATS_METRIC_COUNT) return;
+
+    stats_ring_t* ring = &stats->rings[metric];
+    ring->values[ring->head] = (float)ms;
+    ring->head = (ring->head + 1) % STATS_RING_SIZE;
+    if (ring->count < STATS_RING_SIZE) {
+        ring->count++;
+    }
+}
+
+void stats_record_frame(frame_stats_t* stats, double update_ms, double draw_ms, double swap_ms) {
+    if (!stats) return;
+
+    stats_record(stats, STATS_UPDATE, update_ms);
+    stats_record(stats, STATS_DRAW, draw_ms);
+    stats_record(stats, STATS_SWAP, swap_ms);
+    stats->total_frames++;
+}
+
+void stats_record_interval(frame_stats_t* stats, double interval_ms) {
+    if (!stats || interval_ms < 0.0) return;
+
+    stats_record(stats, STATS_INTERVAL, interval_ms);
+
+    // A gap of N periods means N - 1 refreshes went by without a new frame
+    if (stats->frame_period_ms > 0.0 &&
+        interval_ms > stats->frame_period_ms * STATS_MISSED_FRAME_FACTOR) {
+        uint64_t periods = (uint64_t)(interval_ms / stats->frame_period_ms + 0.5);
+        stats->missed_frames += periods > 1 ? periods - 1 : 1;
+    }
+}
+
+static int float_compare(const void* a, const void* b) {
+    float fa = *(const float*)a;
+    float fb = *(const float*)b;
+    return (fa > fb) - (fa < fb);
+}
+
+float stats_percentile(const frame_stats_t* stats, stats_metric_t metric, float percentile) {
+    if (!stats || (unsigned)metric >= STATS_METRIC_COUNT) return 0.0f;
+
+    const stats_ring_t* ring = &stats->rings[metric];
+    if (ring->count == 0) return 0.0f;
+
+    // Order of samples in the ring doesn't matter for percentiles
+    float sorted[STATS_RING_SIZE];
+    memcpy(sorted, ring->values, ring->count * sizeof(float));
+    qsort(sorted, ring->count, sizeof(float), float_compare);
+
+    if (percentile <= 0.0f) return sorted[0];
+    if (percentile >= 100.0f) return sorted[ring->count - 1];
+
+    // Nearest-rank method
+    int rank = (int)(percentile / 100.0f * ring->count + 0.5f);
+    if (rank < 1) rank = 1;
+    if (rank > ring->count) rank = ring->count;
+    return sorted[rank - 1];
+}
+
+float stats_max(const frame_stats_t* stats, stats_metric_t metric) {
+    return stats_percentile(stats, metric, 100.0f);
+}
+
+int stats_format(const frame_stats_t* stats, char* buffer, size_t size) {
+    if (!stats || !buffer || size == 0) return -1;
+
+    int offset = snprintf(buffer, size,
+        "Frames: %llu | Missed: %llu | Period: %.2f ms\n"
+        "%-10s %9s %9s %9s %9s %8s\n",
+        (unsigned long long)stats->total_frames,
+        (unsigned long long)stats->missed_frames,
+        stats->frame_period_ms,
+        "metric", "p50 ms", "p95 ms", "p99 ms", "max ms", "samples");
+    if (offset < 0 || (size_t)offset >= size) return -1;
+
+    for (int i = 0; i < STATS_METRIC_COUNT; i++) {
+        int written = snprintf(buffer + offset, size - offset,
+            "%-10s %9.3f %9.3f %9.3f %9.3f %8d\n",
+            metric_names[i],
+            stats_percentile(stats, i, 50.0f),
+            stats_percentile(stats, i, 95.0f),
+            stats_percentile(stats, i, 99.0f),
+            stats_max(stats, i),
+            stats->rings[i].count);
+        if (written < 0 || (size_t)(offset + written) >= size) return -1;
+        offset += written;
+    }
+
+    return offset;
+}
@@ -0,0 +1,51 @@
+/*
+ * Frame timing statistics for hyprlax
+ * Keeps a fixed-size ring buffer of per-frame timings for the render loop
+ */
+
+#ifndef HYPRLAX_STATS_H
+#define HYPRLAX_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATS_RING_SIZE 512
+#define STATS_MISSED_FRAME_FACTOR 1.5  // Callback gap (in frame periods) that counts as a miss
+
+typedef enum {
+    STATS_UPDATE,    // Animation update (easing, offsets)
+    STATS_DRAW,      // GL command submission for all layers
+    STATS_SWAP,      // eglSwapBuffers latency
+    STATS_INTERVAL,  // Gap between consecutive frame_done callbacks
+    STATS_GPU,       // GPU time of a frame's composite (GL_EXT_disjoint_timer_query)
+    STATS_METRIC_COUNT
+} stats_metric_t;
+
+typedef struct {
+    float values[STATS_RING_SIZE];  // Milliseconds
+    int head;
+    int count;
+} stats_ring_t;
+
+typedef struct frame_stats {
+    stats_ring_t rings[STATS_METRIC_COUNT];
+    uint64_t total_frames;
+    uint64_t missed_frames;
+    double frame_period_ms;  // Expected frame period used for miss detection
+} frame_stats_t;
+
+// Lifecycle
+void stats_init(frame_stats_t* stats, int target_fps);
+void stats_reset(frame_stats_t* stats);
+
+// Recording
+void stats_record(frame_stats_t* stats, stats_metric_t metric, double ms);
+void stats_record_frame(frame_stats_t* stats, double update_ms, double draw_ms, double swap_ms);
+void stats_record_interval(frame_stats_t* stats, double interval_ms);
+
+// Reporting
+float stats_percentile(const frame_stats_t* stats, stats_metric_t metric, float percentile);
+float stats_max(const frame_stats_t* stats, stats_metric_t metric);
+int stats_format(const frame_stats_t* stats, char* buffer, size_t size);
+
+#endif // HYPRLAX_STATS_H
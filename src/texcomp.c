@@ -0,0 +1,179 @@
+/*
+ * Texture compression for hyprlax
+ * CPU encoders for the S3TC block formats, so cached layers can be uploaded with
+ * glCompressedTexImage2D at a quarter (BC3) or an eighth (BC1) of the RGBA8 size
+ */
+
+#include "texcomp.h"
+#include <string.h>
+
+static size_t block_count(int width, int height) {
+    return (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4);
+}
+
+size_t texcomp_bc1_size(int width, int height) {
+    return block_count(width, height) * TEXCOMP_BC1_BLOCK_BYTES;
+}
+
+size_t texcomp_bc3_size(int width, int height) {
+    return block_count(width, height) * TEXCOMP_BC3_BLOCK_BYTES;
+}
+
+// Gather a 4x4 block; blocks past the right or bottom edge repeat the last texels
+static void load_block(const image_t* src, int bx, int by, unsigned char block[16][4]) {
+    for (int y = 0; y < 4; y++) {
+        int sy = by + y < src->height ? by + y : src->height - 1;
+        for (int x = 0; x < 4; x++) {
+            int sx = bx + x < src->width ? bx + x : src->width - 1;
+            memcpy(block[y * 4 + x], src->pixels + ((size_t)sy * src->width + sx) * 4, 4);
+        }
+    }
+}
+
+static unsigned short pack_565(const int color[3]) {
+    return (unsigned short)(((color[0] * 31 + 127) / 255) << 11 |
+                            ((color[1] * 63 + 127) / 255) << 5 |
+                            ((color[2] * 31 + 127) / 255));
+}
+
+static void unpack_565(unsigned short packed, int color[3]) {
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+static void put_u16(unsigned char* dst, unsigned short value) {
+    dst[0] = value & 0xff;
+    dst[1] = value >> 8;
+}
+
+// Four-color block: endpoints on the diagonal of the colors' bounding box that follows
+// their correlation, pulled in by 1/16 of the range, then nearest palette entry per texel
+static void encode_color_block(unsigned char block[16][4], unsigned char* dst) {
+    int lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+    int mean[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            if (block[i][c] < lo[c]) lo[c] = block[i][c];
+            if (block[i][c] > hi[c]) hi[c] = block[i][c];
+            mean[c] += block[i][c];
+        }
+    }
+
+    // Green is the reference axis; swap red or blue ends if they fall as green rises
+    int cov_rg = 0, cov_bg = 0;
+    for (int i = 0; i < 16; i++) {
+        int dg = block[i][1] * 16 - mean[1];
+        cov_rg += (block[i][0] * 16 - mean[0]) * dg / 16;
+        cov_bg += (block[i][2] * 16 - mean[2]) * dg / 16;
+    }
+    if (cov_rg < 0) { int t = lo[0]; lo[0] = hi[0]; hi[0] = t; }
+    if (cov_bg < 0) { int t = lo[2]; lo[2] = hi[2]; hi[2] = t; }
+
+    for (int c = 0; c < 3; c++) {
+        int inset = (hi[c] - lo[c]) / 16;
+        hi[c] -= inset;
+        lo[c] += inset;
+    }
+
+    unsigned short c0 = pack_565(hi), c1 = pack_565(lo);
+    if (c0 < c1) {
+        unsigned short t = c0; c0 = c1; c1 = t;
+    }
+
+    unsigned int indices = 0;
+    if (c0 != c1) {
+        int palette[4][3];
+        unpack_565(c0, palette[0]);
+        unpack_565(c1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 15; i >= 0; i--) {
+            int best = 0, best_dist = 1 << 30;
+            for (int p = 0; p < 4; p++) {
+                int dr = block[i][0] - palette[p][0];
+                int dg = block[i][1] - palette[p][1];
+                int db = block[i][2] - palette[p][2];
+                int dist = dr * dr + dg * dg + db * db;
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best = p;
+                }
+            }
+            indices = (indices << 2) | (unsigned int)best;
+        }
+    }
+
+    put_u16(dst, c0);
+    put_u16(dst + 2, c1);
+    for (int i = 0; i < 4; i++) {
+        dst[4 + i] = (indices >> (i * 8)) & 0xff;
+    }
+}
+
+// Eight-level alpha block between the block's min and max alpha
+static void encode_alpha_block(unsigned char block[16][4], unsigned char* dst) {
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; i++) {
+        if (block[i][3] < lo) lo = block[i][3];
+        if (block[i][3] > hi) hi = block[i][3];
+    }
+
+    dst[0] = (unsigned char)hi;
+    dst[1] = (unsigned char)lo;
+    unsigned long long indices = 0;
+    if (hi != lo) {
+        int levels[8] = { hi, lo };
+        for (int i = 2; i < 8; i++) {
+            levels[i] = ((8 - i) * hi + (i - 1) * lo) / 7;
+        }
+
+        for (int i = 15; i >= 0; i--) {
+            int best = 0, best_dist = 256;
+            for (int l = 0; l < 8; l++) {
+                int dist = block[i][3] > levels[l] ? block[i][3] - levels[l] : levels[l] - block[i][3];
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best = l;
+                }
+            }
+            indices = (indices << 3) | (unsigned long long)best;
+        }
+    }
+    for (int i = 0; i < 6; i++) {
+        dst[2 + i] = (indices >> (i * 8)) & 0xff;
+    }
+}
+
+int texcomp_encode_bc1(const image_t* src, unsigned char* dst) {
+    if (!src || !src->pixels || !dst || src->width <= 0 || src->height <= 0) return -1;
+
+    unsigned char block[16][4];
+    for (int by = 0; by < src->height; by += 4) {
+        for (int bx = 0; bx < src->width; bx += 4) {
+            load_block(src, bx, by, block);
+            encode_color_block(block, dst);
+            dst += TEXCOMP_BC1_BLOCK_BYTES;
+        }
+    }
+    return 0;
+}
+
+int texcomp_encode_bc3(const image_t* src, unsigned char* dst) {
+    if (!src || !src->pixels || !dst || src->width <= 0 || src->height <= 0) return -1;
+
+    unsigned char block[16][4];
+    for (int by = 0; by < src->height; by += 4) {
+        for (int bx = 0; bx < src->width; bx += 4) {
+            load_block(src, bx, by, block);
+            encode_alpha_block(block, dst);
+            encode_color_block(block, dst + 8);
+            dst += TEXCOMP_BC3_BLOCK_BYTES;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+/*
+ * Texture compression for hyprlax
+ * CPU encoders for the S3TC block formats, so cached layers can be uploaded with
+ * glCompressedTexImage2D at a quarter (BC3) or an eighth (BC1) of the RGBA8 size
+ */
+
+#ifndef HYPRLAX_TEXCOMP_H
+#define HYPRLAX_TEXCOMP_H
+
+#include <stddef.h>
+
+#include "image.h"
+
+#define TEXCOMP_BC1_BLOCK_BYTES 8   // 4x4 texels of opaque RGB (DXT1)
+#define TEXCOMP_BC3_BLOCK_BYTES 16  // 4x4 texels of RGBA (DXT5)
+
+// Bytes of a width x height level; partial blocks at the edges count as whole ones
+size_t texcomp_bc1_size(int width, int height);
+size_t texcomp_bc3_size(int width, int height);
+
+// Encode an RGBA8 image into dst, which must hold texcomp_bc*_size() bytes.
+// BC1 ignores alpha, so it is only meant for opaque images.
+int texcomp_encode_bc1(const image_t* src, unsigned char* dst);
+int texcomp_encode_bc3(const image_t* src, unsigned char* dst);
+
+#endif // HYPRLAX_TEXCOMP_H
@@ -0,0 +1,571 @@
+// Microbenchmarks for the CPU hot paths of hyprlax, linked against the real sources.
+// Reports ns/op and heap allocations per op, writes them as JSON, and compares a run
+// against an earlier JSON file so regressions show up before a release.
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "../src/config.h"
+#include "../src/easing.h"
+#include "../src/idmap.h"
+#include "../src/ipc.h"
+
+#define MICROBENCH_FORMAT 1        // Bump when a benchmark's definition changes
+#define MICROBENCH_MIN_TIME 0.1    // Seconds a timed run lasts at least
+#define MICROBENCH_RUNS 5          // The fastest of this many timed runs is reported
+#define MICROBENCH_MAX 64
+#define MICROBENCH_NAME_SIZE 64
+#define MICROBENCH_SLOWER 1.25     // Flagged as slower past this ratio to the baseline
+#define CONFIG_BENCH_LAYERS 200    // Layer lines in the generated parallax.conf
+#define IPC_BENCH_BATCH 16         // Commands sent per ipc_process_commands() call
+
+// Heap allocation counting. glibc lets a program replace malloc and friends and routes
+// its own allocations (strdup, fopen, realpath) through the replacement as well.
+static unsigned long long alloc_count = 0;
+static unsigned long long alloc_bytes = 0;
+
+#ifdef __GLIBC__
+#define ALLOCS_COUNTED 1
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+void* malloc(size_t size)
+{
+    alloc_count++;
+    alloc_bytes += size;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    alloc_count++;
+    alloc_bytes += count * size;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    alloc_count++;
+    alloc_bytes += size;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+    __libc_free(ptr);
+}
+#else
+#define ALLOCS_COUNTED 0
+#endif
+
+typedef struct {
+    char name[MICROBENCH_NAME_SIZE];
+    long (*run)(void* arg, long ops);  // Performs at least `ops` operations, returns how many
+    void* arg;
+} benchmark_t;
+
+typedef struct {
+    char name[MICROBENCH_NAME_SIZE];
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+    long ops;
+} result_t;
+
+// Keeps results alive so the compiler can't drop the work
+static volatile float sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Grow the op count until a run takes MICROBENCH_MIN_TIME, then keep the fastest of
+// MICROBENCH_RUNS runs of that length
+static void measure(const benchmark_t* bench, result_t* result)
+{
+    long ops = 1;
+    for (;;) {
+        double start = now_ns();
+        long done = bench->run(bench->arg, ops);
+        double elapsed = now_ns() - start;
+        if (elapsed >= MICROBENCH_MIN_TIME * 1e9 || done >= LONG_MAX / 100) {
+            ops = done;
+            break;
+        }
+        double scale = elapsed > 0.0 ? MICROBENCH_MIN_TIME * 1e9 / elapsed * 1.2 : 100.0;
+        ops = scale >= 100.0 ? done * 100 : (long)(done * scale) + 1;
+    }
+
+    memcpy(result->name, bench->name, sizeof(result->name));
+    result->ns_per_op = -1.0;
+    for (int run = 0; run < MICROBENCH_RUNS; run++) {
+        unsigned long long allocs = alloc_count;
+        unsigned long long bytes = alloc_bytes;
+        double start = now_ns();
+        long done = bench->run(bench->arg, ops);
+        double elapsed = now_ns() - start;
+
+        double ns = elapsed / done;
+        if (result->ns_per_op < 0.0 || ns < result->ns_per_op) result->ns_per_op = ns;
+        result->allocs_per_op = (double)(alloc_count - allocs) / done;
+        result->bytes_per_op = (double)(alloc_bytes - bytes) / done;
+        result->ops = done;
+    }
+}
+
+// Easing curves, by their command-line names
+
+static const char* easing_names[EASE_COUNT] = {
+    "linear", "quad", "cubic", "quart", "quint", "sine",
+    "expo", "circ", "back", "elastic", "snap"
+};
+
+static easing_type_t easing_types[EASE_COUNT];
+
+static long run_easing_apply(void* arg, long ops)
+{
+    easing_type_t type = *(const easing_type_t*)arg;
+    float sum = 0.0f;
+    for (long i = 0; i < ops; i++) {
+        sum += easing_apply((float)(i & 1023) * (1.0f / 1023.0f), type);
+    }
+    sink = sum;
+    return ops;
+}
+
+static long run_easing_lookup(void* arg, long ops)
+{
+    easing_type_t type = *(const easing_type_t*)arg;
+    float sum = 0.0f;
+    for (long i = 0; i < ops; i++) {
+        sum += easing_lookup((float)(i & 1023) * (1.0f / 1023.0f), type);
+    }
+    sink = sum;
+    return ops;
+}
+
+// One frame of 32 layers animating with every easing curve; time stays within the
+// animation so no row ever settles
+static anim_table_t bench_anims;
+
+static int setup_anims(void)
+{
+    if (anim_table_resize(&bench_anims, IPC_MAX_LAYERS) < 0) return -1;
+    for (int row = 0; row < bench_anims.count; row++) {
+        anim_table_retarget(&bench_anims, row, 200.0f * (row + 1), 0.0,
+                            0.0f, 1.0f, (easing_type_t)(row % EASE_COUNT));
+    }
+    return 0;
+}
+
+static long run_anim_table_update(void* arg, long ops)
+{
+    (void)arg;
+    int changed = 0;
+    for (long i = 0; i < ops; i++) {
+        anim_table_update(&bench_anims, (double)(i % 1000) * 0.001, &changed);
+    }
+    sink = bench_anims.current[bench_anims.count - 1];
+    return ops;
+}
+
+// parallax.conf with CONFIG_BENCH_LAYERS layers, settings and power profiles
+
+static char bench_dir[64];
+static char config_path[128];
+static char image_path[128];
+
+static int write_config(void)
+{
+    snprintf(config_path, sizeof(config_path), "%s/parallax.conf", bench_dir);
+    FILE* file = fopen(config_path, "w");
+    if (!file) return -1;
+
+    fprintf(file, "# Generated by microbench\n");
+    fprintf(file, "duration 1.2\nshift 250\neasing expo\ndelay 0.1\nblur_downscale 0.5\n");
+    fprintf(file, "power_policy 1\nprofile battery fps 30 duration_scale 0.5 blur_layers 0\n");
+    fprintf(file, "profile fullscreen pause 1\n\n");
+    for (int i = 0; i < CONFIG_BENCH_LAYERS; i++) {
+        char layer_path[160];
+        snprintf(layer_path, sizeof(layer_path), "%s/images/layer_%03d.png", bench_dir, i);
+        FILE* image = fopen(layer_path, "w");
+        if (image) fclose(image);
+
+        fprintf(file, "# Layer %d\nlayer images/layer_%03d.png %.2f %.2f %.1f\n",
+                i, i, 0.1f + i * 0.01f, 1.0f - i * 0.001f, (float)(i % 4));
+    }
+    return fclose(file);
+}
+
+static int drop_config_layer(const config_layer_t* layer, void* data)
+{
+    (*(int*)data)++;
+    free(layer->image_path);
+    return 0;
+}
+
+static long run_config_parse(void* arg, long ops)
+{
+    (void)arg;
+    for (long i = 0; i < ops; i++) {
+        int layers = 0;
+        if (config_parse_file(config_path, drop_config_layer, &layers) < 0 ||
+            layers != CONFIG_BENCH_LAYERS) {
+            fprintf(stderr, "Error: config_parse_file failed on %s\n", config_path);
+            exit(1);
+        }
+    }
+    return ops;
+}
+
+// An IPC context with IPC_MAX_LAYERS layers, served over a private socket, and the
+// renderer-side bookkeeping that sync_ipc_layers() does besides loading textures
+
+typedef struct {
+    uint32_t id;
+    float opacity;
+    float shift_multiplier;
+} bench_layer_t;
+
+static ipc_context_t* bench_ipc;
+static int client_fd = -1;
+static idmap_t bench_slots;
+static bench_layer_t bench_layers[IPC_MAX_LAYERS];
+static char ipc_batch[IPC_BENCH_BATCH * 48];
+
+static int setup_ipc(void)
+{
+    bench_ipc = calloc(1, sizeof(ipc_context_t));
+    if (!bench_ipc) return -1;
+    for (int i = 0; i < IPC_MAX_CLIENTS; i++) {
+        bench_ipc->clients[i].fd = -1;
+    }
+    bench_ipc->next_layer_id = 1;
+    bench_ipc->active = true;
+
+    // Listening socket in the abstract namespace, so nothing in /tmp (such as a running
+    // hyprlax's socket) is touched; no one ever connects to it
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path + 1, sizeof(addr.sun_path) - 1, "hyprlax-microbench-%d", (int)getpid());
+    bench_ipc->socket_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (bench_ipc->socket_fd < 0 ||
+        bind(bench_ipc->socket_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(bench_ipc->socket_fd, 1) < 0) {
+        return -1;
+    }
+
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, pair) < 0) return -1;
+    bench_ipc->clients[0].fd = pair[0];
+    client_fd = pair[1];
+
+    for (int i = 0; i < IPC_MAX_LAYERS; i++) {
+        uint32_t id = ipc_add_layer(bench_ipc, image_path, 1.0f + i * 0.1f, 1.0f, 0.0f, 0.0f, i);
+        if (id == 0 || idmap_put(&bench_slots, id, i) < 0) return -1;
+        bench_layers[i].id = id;
+    }
+    ipc_clear_changes(bench_ipc);
+
+    size_t length = 0;
+    for (int i = 0; i < IPC_BENCH_BATCH; i++) {
+        length += snprintf(ipc_batch + length, sizeof(ipc_batch) - length,
+                           "modify %u opacity 0.%d\n", bench_layers[i].id, 10 + i);
+    }
+    return 0;
+}
+
+static void drain_client(void)
+{
+    char buffer[IPC_MAX_MESSAGE_SIZE];
+    while (recv(client_fd, buffer, sizeof(buffer), 0) > 0) {}
+}
+
+static long run_ipc_process_commands(void* arg, long ops)
+{
+    (void)arg;
+    size_t length = strlen(ipc_batch);
+    long done = 0;
+    while (done < ops) {
+        if (send(client_fd, ipc_batch, length, MSG_NOSIGNAL) != (ssize_t)length ||
+            !ipc_process_commands(bench_ipc)) {
+            fprintf(stderr, "Error: IPC commands were not processed\n");
+            exit(1);
+        }
+        drain_client();
+        ipc_clear_changes(bench_ipc);
+        done += IPC_BENCH_BATCH;
+    }
+    return done;
+}
+
+static long run_ipc_list_layers(void* arg, long ops)
+{
+    (void)arg;
+    for (long i = 0; i < ops; i++) {
+        char* list = ipc_list_layers(bench_ipc);
+        sink = list ? list[0] : 0;
+        free(list);
+    }
+    return ops;
+}
+
+// What apply_ipc_layer() does for a layer that stays loaded: find its slot and copy the
+// IPC layer's settings over
+static bool bench_apply(uint32_t layer_id, void* data)
+{
+    (void)data;
+    layer_t* ipc_layer = ipc_find_layer(bench_ipc, layer_id);
+    int slot = -1;
+    idmap_get(&bench_slots, layer_id, &slot);
+    if (!ipc_layer || slot < 0) return false;
+
+    bench_layer_t* layer = &bench_layers[slot];
+    bool changed = layer->opacity != ipc_layer->opacity;
+    layer->opacity = ipc_layer->opacity;
+    layer->shift_multiplier = ipc_layer->scale;
+    return changed;
+}
+
+// What prune_ipc_layers() does when every layer still exists
+static bool bench_prune(void* data)
+{
+    (void)data;
+    bool changed = false;
+    for (int i = IPC_MAX_LAYERS - 1; i >= 0; i--) {
+        if (!ipc_find_layer(bench_ipc, bench_layers[i].id)) changed = true;
+    }
+    return changed;
+}
+
+static long run_sync_journal(void* arg, long ops)
+{
+    (void)arg;
+    const ipc_sync_ops_t sync = { .apply = bench_apply, .prune = bench_prune };
+    for (long i = 0; i < ops; i++) {
+        for (int j = 0; j < IPC_MAX_LAYERS; j++) {
+            bench_ipc->changes[j].type = IPC_CHANGE_MODIFY;
+            bench_ipc->changes[j].layer_id = bench_layers[j].id;
+            bench_ipc->layers[j]->opacity = (float)((i + j) & 1);
+        }
+        bench_ipc->change_count = IPC_MAX_LAYERS;
+        sink = ipc_sync_layers(bench_ipc, &sync);
+    }
+    return ops;
+}
+
+static long run_sync_overflow(void* arg, long ops)
+{
+    (void)arg;
+    const ipc_sync_ops_t sync = { .apply = bench_apply, .prune = bench_prune };
+    for (long i = 0; i < ops; i++) {
+        bench_ipc->changes_overflowed = true;
+        sink = ipc_sync_layers(bench_ipc, &sync);
+    }
+    return ops;
+}
+
+// JSON output, one benchmark per line so runs diff cleanly
+
+static int write_json(const char* path, const result_t* results, int count)
+{
+    FILE* file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot write %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    fprintf(file, "{\n  \"format\": %d,\n  \"allocs_counted\": %s,\n  \"benchmarks\": [\n",
+            MICROBENCH_FORMAT, ALLOCS_COUNTED ? "true" : "false");
+    for (int i = 0; i < count; i++) {
+        fprintf(file, "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f, "
+                "\"bytes_per_op\": %.1f, \"ops\": %ld}%s\n",
+                results[i].name, results[i].ns_per_op, results[i].allocs_per_op,
+                results[i].bytes_per_op, results[i].ops, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return file == stdout ? 0 : fclose(file);
+}
+
+// Read a file written by write_json; returns the number of results or -1
+static int read_json(const char* path, result_t* results, int max)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot read baseline %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    char line[512];
+    int count = 0;
+    int format = -1;
+    while (fgets(line, sizeof(line), file) && count < max) {
+        result_t* result = &results[count];
+        if (sscanf(line, " \"format\": %d", &format) == 1) continue;
+        if (sscanf(line, " {\"name\": \"%63[^\"]\", \"ns_per_op\": %lf, \"allocs_per_op\": %lf, "
+                   "\"bytes_per_op\": %lf, \"ops\": %ld}",
+                   result->name, &result->ns_per_op, &result->allocs_per_op,
+                   &result->bytes_per_op, &result->ops) == 5) {
+            count++;
+        }
+    }
+    fclose(file);
+
+    if (format != MICROBENCH_FORMAT) {
+        fprintf(stderr, "Error: Baseline %s has format %d, expected %d\n", path, format,
+                MICROBENCH_FORMAT);
+        return -1;
+    }
+    return count;
+}
+
+// Print each benchmark's change against the baseline. Returns the number of benchmarks
+// that allocate more than before; timings are too noisy to fail on.
+static int compare(const result_t* results, int count, const result_t* baseline, int baseline_count)
+{
+    int regressions = 0;
+    printf("\n%-36s %12s %12s %8s %14s\n", "vs baseline", "old ns/op", "new ns/op", "change",
+           "allocs/op");
+    for (int i = 0; i < count; i++) {
+        const result_t* old = NULL;
+        for (int j = 0; j < baseline_count && !old; j++) {
+            if (strcmp(baseline[j].name, results[i].name) == 0) old = &baseline[j];
+        }
+        if (!old) {
+            printf("%-36s %12s %12.1f %8s\n", results[i].name, "-", results[i].ns_per_op, "new");
+            continue;
+        }
+
+        double ratio = old->ns_per_op > 0.0 ? results[i].ns_per_op / old->ns_per_op : 1.0;
+        int more_allocs = ALLOCS_COUNTED && results[i].allocs_per_op > old->allocs_per_op + 0.001;
+        printf("%-36s %12.1f %12.1f %+7.1f%% %6.2f -> %-5.2f%s\n", results[i].name,
+               old->ns_per_op, results[i].ns_per_op, (ratio - 1.0) * 100.0,
+               old->allocs_per_op, results[i].allocs_per_op,
+               more_allocs ? "  MORE ALLOCATIONS" : ratio > MICROBENCH_SLOWER ? "  SLOWER" : "");
+        regressions += more_allocs;
+    }
+    return regressions;
+}
+
+static void print_usage(const char* prog)
+{
+    printf("Usage: %s [--json FILE] [--baseline FILE] [--filter TEXT]\n", prog);
+    printf("  --json FILE      Write results as JSON (- for stdout)\n");
+    printf("  --baseline FILE  Compare against an earlier --json file; exits 1 if a\n");
+    printf("                   benchmark allocates more than it did\n");
+    printf("  --filter TEXT    Only run benchmarks whose name contains TEXT\n");
+}
+
+static void remove_bench_dir(void)
+{
+    char command[128];
+    snprintf(command, sizeof(command), "rm -rf '%s'", bench_dir);
+    if (system(command) != 0) {
+        fprintf(stderr, "Warning: Failed to remove %s\n", bench_dir);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* json_path = NULL;
+    const char* baseline_path = NULL;
+    const char* filter = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    snprintf(bench_dir, sizeof(bench_dir), "/tmp/hyprlax_microbench_XXXXXX");
+    if (!mkdtemp(bench_dir)) {
+        fprintf(stderr, "Error: Failed to create a temporary directory\n");
+        return 1;
+    }
+    char images_dir[96];
+    snprintf(images_dir, sizeof(images_dir), "%s/images", bench_dir);
+    snprintf(image_path, sizeof(image_path), "%s/layer.png", images_dir);
+    FILE* image = NULL;
+    if (mkdir(images_dir, 0700) < 0 || !(image = fopen(image_path, "w")) ||
+        fclose(image) != 0 || write_config() < 0 || setup_anims() < 0 || setup_ipc() < 0) {
+        fprintf(stderr, "Error: Failed to set up benchmarks\n");
+        remove_bench_dir();
+        return 1;
+    }
+
+    benchmark_t benchmarks[MICROBENCH_MAX];
+    int count = 0;
+    for (int type = 0; type < EASE_COUNT; type++) {
+        easing_types[type] = (easing_type_t)type;
+        benchmark_t* bench = &benchmarks[count++];
+        snprintf(bench->name, sizeof(bench->name), "easing_apply/%s", easing_names[type]);
+        bench->run = run_easing_apply;
+        bench->arg = &easing_types[type];
+    }
+    for (int type = 0; type < EASE_COUNT; type++) {
+        benchmark_t* bench = &benchmarks[count++];
+        snprintf(bench->name, sizeof(bench->name), "easing_lookup/%s", easing_names[type]);
+        bench->run = run_easing_lookup;
+        bench->arg = &easing_types[type];
+    }
+    benchmarks[count++] = (benchmark_t){ "anim_table_update/32_layers", run_anim_table_update, NULL };
+    benchmarks[count++] = (benchmark_t){ "config_parse_file/200_layers", run_config_parse, NULL };
+    benchmarks[count++] = (benchmark_t){ "ipc_process_commands/modify", run_ipc_process_commands, NULL };
+    benchmarks[count++] = (benchmark_t){ "ipc_list_layers/32_layers", run_ipc_list_layers, NULL };
+    benchmarks[count++] = (benchmark_t){ "sync_ipc_layers/32_changes", run_sync_journal, NULL };
+    benchmarks[count++] = (benchmark_t){ "sync_ipc_layers/32_resync", run_sync_overflow, NULL };
+
+    result_t results[MICROBENCH_MAX];
+    int result_count = 0;
+    printf("%-36s %12s %12s %12s\n", "benchmark", "ns/op", "allocs/op", "bytes/op");
+    for (int i = 0; i < count; i++) {
+        if (filter && !strstr(benchmarks[i].name, filter)) continue;
+        result_t* result = &results[result_count++];
+        measure(&benchmarks[i], result);
+        printf("%-36s %12.1f %12.2f %12.1f\n", result->name, result->ns_per_op,
+               result->allocs_per_op, result->bytes_per_op);
+        fflush(stdout);
+    }
+    if (!ALLOCS_COUNTED) {
+        printf("(allocations are only counted with glibc)\n");
+    }
+
+    int status = 0;
+    if (json_path && write_json(json_path, results, result_count) < 0) status = 1;
+    if (baseline_path) {
+        result_t baseline[MICROBENCH_MAX];
+        int baseline_count = read_json(baseline_path, baseline, MICROBENCH_MAX);
+        if (baseline_count < 0 || compare(results, result_count, baseline, baseline_count) > 0) {
+            status = 1;
+        }
+    }
+
+    ipc_cleanup(bench_ipc);
+    if (client_fd >= 0) close(client_fd);
+    idmap_free(&bench_slots);
+    anim_table_free(&bench_anims);
+    free(config.config_file_path);
+    remove_bench_dir();
+    return status;
+}
@@ -0,0 +1,487 @@
+// Test suite for the on-disk texture cache and CPU mip generation using Check framework
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "../src/cache.h"
+#include "../src/image.h"
+#include "../src/texcomp.h"
+
+static char cache_home[64];
+static char source_path[256];
+
+static void setup(void)
+{
+    snprintf(cache_home, sizeof(cache_home), "/tmp/hyprlax_cache_test_XXXXXX");
+    ck_assert_ptr_nonnull(mkdtemp(cache_home));
+    setenv("XDG_CACHE_HOME", cache_home, 1);
+
+    snprintf(source_path, sizeof(source_path), "%s/source.png", cache_home);
+    FILE* file = fopen(source_path, "w");
+    ck_assert_ptr_nonnull(file);
+    fputs("not really a png", file);
+    fclose(file);
+}
+
+static void teardown(void)
+{
+    char command[512];
+    snprintf(command, sizeof(command), "rm -rf '%s'", cache_home);
+    ck_assert_int_eq(system(command), 0);
+}
+
+// Fill an RGBA image with a single color
+static void fill_image(image_t* image, int width, int height, unsigned char value)
+{
+    image->width = width;
+    image->height = height;
+    image->pixels = malloc((size_t)width * height * 4);
+    ck_assert_ptr_nonnull(image->pixels);
+    memset(image->pixels, value, (size_t)width * height * 4);
+}
+
+// Test keys are stable and change with any input
+START_TEST(test_cache_key)
+{
+    char key1[CACHE_KEY_SIZE];
+    char key2[CACHE_KEY_SIZE];
+
+    ck_assert_int_eq(cache_make_key(source_path, 0, 0, key1, sizeof(key1)), 0);
+    ck_assert_int_eq(strlen(key1), CACHE_KEY_SIZE - 1);
+    ck_assert_int_eq(cache_make_key(source_path, 0, 0, key2, sizeof(key2)), 0);
+    ck_assert_str_eq(key1, key2);
+
+    // Different target size
+    ck_assert_int_eq(cache_make_key(source_path, 1920, 1080, key2, sizeof(key2)), 0);
+    ck_assert_str_ne(key1, key2);
+
+    // Touching the source invalidates the key
+    struct timeval times[2] = { { 1000000, 0 }, { 1000000, 0 } };
+    ck_assert_int_eq(utimes(source_path, times), 0);
+    ck_assert_int_eq(cache_make_key(source_path, 0, 0, key2, sizeof(key2)), 0);
+    ck_assert_str_ne(key1, key2);
+
+    // Missing source, short buffer
+    ck_assert_int_eq(cache_make_key("/nonexistent/image.png", 0, 0, key1, sizeof(key1)), -1);
+    ck_assert_int_eq(cache_make_key(source_path, 0, 0, key1, 4), -1);
+}
+END_TEST
+
+// Test snapshot keys separate outputs and workspaces, and never match an image key
+START_TEST(test_cache_snapshot_key)
+{
+    char key1[CACHE_KEY_SIZE];
+    char key2[CACHE_KEY_SIZE];
+
+    ck_assert_int_eq(cache_snapshot_key("DP-1", 1, key1, sizeof(key1)), 0);
+    ck_assert_int_eq(strlen(key1), CACHE_KEY_SIZE - 1);
+    ck_assert_int_eq(cache_snapshot_key("DP-1", 1, key2, sizeof(key2)), 0);
+    ck_assert_str_eq(key1, key2);
+
+    ck_assert_int_eq(cache_snapshot_key("DP-1", 2, key2, sizeof(key2)), 0);
+    ck_assert_str_ne(key1, key2);
+    ck_assert_int_eq(cache_snapshot_key("DP-2", 1, key2, sizeof(key2)), 0);
+    ck_assert_str_ne(key1, key2);
+    ck_assert_int_eq(cache_make_key(source_path, 0, 0, key2, sizeof(key2)), 0);
+    ck_assert_str_ne(key1, key2);
+
+    // Unnamed output, short buffer
+    ck_assert_int_eq(cache_snapshot_key(NULL, 1, key1, sizeof(key1)), -1);
+    ck_assert_int_eq(cache_snapshot_key("DP-1", 1, key1, 4), -1);
+}
+END_TEST
+
+// Test a stored chain maps back with identical levels
+START_TEST(test_cache_roundtrip)
+{
+    char key[CACHE_KEY_SIZE];
+    ck_assert_int_eq(cache_make_key(source_path, 0, 0, key, sizeof(key)), 0);
+
+    cache_entry_t entry;
+    ck_assert_int_eq(cache_load(key, &entry), -1);  // Cold
+
+    image_t levels[CACHE_MAX_LEVELS];
+    memset(levels, 0, sizeof(levels));
+    fill_image(&levels[0], 8, 4, 200);
+    int count = image_generate_mips(levels, CACHE_MAX_LEVELS);
+    ck_assert_int_eq(count, 4);  // 8x4, 4x2, 2x1, 1x1
+
+    ck_assert_int_eq(cache_store(key, CACHE_FORMAT_RGBA8, levels, count, NULL), 0);
+    ck_assert_int_eq(cache_load(key, &entry), 0);
+    ck_assert_int_eq(entry.format, CACHE_FORMAT_RGBA8);
+    ck_assert_int_eq(entry.level_count, count);
+    for (int i = 0; i < count; i++) {
+        ck_assert_int_eq(entry.levels[i].width, levels[i].width);
+        ck_assert_int_eq(entry.levels[i].height, levels[i].height);
+        ck_assert_int_eq(memcmp(entry.levels[i].pixels, levels[i].pixels,
+                                (size_t)levels[i].width * levels[i].height * 4), 0);
+    }
+    cache_release(&entry);
+    ck_assert_ptr_null(entry.map);
+
+    for (int i = 0; i < count; i++) {
+        image_free(&levels[i]);
+    }
+}
+END_TEST
+
+// Test compressed levels and the stored coverage/hash survive a roundtrip
+START_TEST(test_cache_compressed_roundtrip)
+{
+    char key[CACHE_KEY_SIZE];
+    ck_assert_int_eq(cache_make_key(source_path, 0, 0, key, sizeof(key)), 0);
+
+    image_t rgba[2], blocks[2];
+    fill_image(&rgba[0], 6, 5, 90);
+    fill_image(&rgba[1], 3, 2, 90);
+    for (int i = 0; i < 2; i++) {
+        blocks[i].width = rgba[i].width;
+        blocks[i].height = rgba[i].height;
+        blocks[i].pixels = malloc(cache_level_size(CACHE_FORMAT_BC3, rgba[i].width, rgba[i].height));
+        ck_assert_int_eq(texcomp_encode_bc3(&rgba[i], blocks[i].pixels), 0);
+    }
+
+    cache_meta_t meta;
+    memset(&meta, 0, sizeof(meta));
+    image_analyze_coverage(&rgba[0], &meta.coverage);
+    meta.content_hash = image_content_hash(&rgba[0]);
+    ck_assert_int_eq(cache_store(key, CACHE_FORMAT_BC3, blocks, 2, &meta), 0);
+
+    cache_entry_t entry;
+    ck_assert_int_eq(cache_load(key, &entry), 0);
+    ck_assert_int_eq(entry.format, CACHE_FORMAT_BC3);
+    ck_assert_int_eq(entry.level_count, 2);
+    ck_assert_int_eq(entry.levels[0].width, 6);
+    ck_assert_int_eq(entry.levels[1].height, 2);
+    ck_assert_int_eq(memcmp(entry.levels[0].pixels, blocks[0].pixels, 4 * TEXCOMP_BC3_BLOCK_BYTES), 0);
+    ck_assert_int_eq(memcmp(entry.levels[1].pixels, blocks[1].pixels, TEXCOMP_BC3_BLOCK_BYTES), 0);
+    ck_assert(entry.meta.content_hash == meta.content_hash);
+    ck_assert_int_eq(entry.meta.coverage.opaque, 0);
+    ck_assert_float_eq(entry.meta.coverage.u1, meta.coverage.u1);
+    cache_release(&entry);
+
+    for (int i = 0; i < 2; i++) {
+        image_free(&rgba[i]);
+        free(blocks[i].pixels);
+    }
+}
+END_TEST
+
+// Test block sizes round partial blocks up and solid colors encode exactly
+START_TEST(test_texcomp_solid_blocks)
+{
+    ck_assert_uint_eq(texcomp_bc1_size(6, 5), 4 * TEXCOMP_BC1_BLOCK_BYTES);
+    ck_assert_uint_eq(texcomp_bc3_size(1, 1), TEXCOMP_BC3_BLOCK_BYTES);
+    ck_assert_uint_eq(cache_level_size(CACHE_FORMAT_BC1, 8, 8), 4 * TEXCOMP_BC1_BLOCK_BYTES);
+
+    // Pure red packs to 565 0xf800 on both endpoints, every index 0
+    image_t image;
+    fill_image(&image, 5, 3, 0);
+    for (int i = 0; i < 5 * 3; i++) {
+        image.pixels[i * 4] = 255;
+        image.pixels[i * 4 + 3] = 255;
+    }
+    unsigned char bc1[2 * TEXCOMP_BC1_BLOCK_BYTES];
+    const unsigned char red[TEXCOMP_BC1_BLOCK_BYTES] = { 0x00, 0xf8, 0x00, 0xf8, 0, 0, 0, 0 };
+    ck_assert_int_eq(texcomp_encode_bc1(&image, bc1), 0);
+    ck_assert_int_eq(memcmp(bc1, red, sizeof(red)), 0);
+    ck_assert_int_eq(memcmp(bc1 + TEXCOMP_BC1_BLOCK_BYTES, red, sizeof(red)), 0);
+
+    // Half the texels transparent: alpha endpoints 255/0, index 1 selects alpha 0
+    for (int i = 0; i < 5 * 3; i += 2) {
+        image.pixels[i * 4 + 3] = 0;
+    }
+    unsigned char bc3[2 * TEXCOMP_BC3_BLOCK_BYTES];
+    ck_assert_int_eq(texcomp_encode_bc3(&image, bc3), 0);
+    ck_assert_int_eq(bc3[0], 255);
+    ck_assert_int_eq(bc3[1], 0);
+    ck_assert_int_eq(bc3[2] & 7, 1);         // Texel (0, 0) is transparent
+    ck_assert_int_eq((bc3[2] >> 3) & 7, 0);  // Texel (1, 0) is opaque
+    ck_assert_int_eq(memcmp(bc3 + 8, red, sizeof(red)), 0);
+
+    ck_assert_int_eq(texcomp_encode_bc1(NULL, bc1), -1);
+    image_free(&image);
+}
+END_TEST
+
+// Test truncated or foreign files are treated as misses
+START_TEST(test_cache_rejects_invalid)
+{
+    char key[CACHE_KEY_SIZE];
+    char path[CACHE_PATH_MAX];
+    ck_assert_int_eq(cache_make_key(source_path, 0, 0, key, sizeof(key)), 0);
+
+    image_t level;
+    fill_image(&level, 16, 16, 7);
+    ck_assert_int_eq(cache_store(key, CACHE_FORMAT_RGBA8, &level, 1, NULL), 0);
+    image_free(&level);
+
+    ck_assert_int_eq(cache_entry_path(key, path, sizeof(path)), 0);
+    struct stat st;
+    ck_assert_int_eq(stat(path, &st), 0);
+
+    // Cut off the pixel data
+    ck_assert_int_eq(truncate(path, st.st_size - 1), 0);
+    cache_entry_t entry;
+    ck_assert_int_eq(cache_load(key, &entry), -1);
+    ck_assert_ptr_null(entry.map);
+
+    // Wrong magic
+    FILE* file = fopen(path, "r+");
+    ck_assert_ptr_nonnull(file);
+    fputs("NOPE", file);
+    fclose(file);
+    ck_assert_int_eq(cache_load(key, &entry), -1);
+}
+END_TEST
+
+// Store a 16x16 RGBA entry for a snapshot key and backdate it by `age` seconds
+static void store_aged_entry(int workspace, long age, char* path, size_t size)
+{
+    char key[CACHE_KEY_SIZE];
+    ck_assert_int_eq(cache_snapshot_key("DP-1", workspace, key, sizeof(key)), 0);
+
+    image_t level;
+    fill_image(&level, 16, 16, (unsigned char)workspace);
+    ck_assert_int_eq(cache_store(key, CACHE_FORMAT_RGBA8, &level, 1, NULL), 0);
+    image_free(&level);
+
+    ck_assert_int_eq(cache_entry_path(key, path, size), 0);
+    struct timeval times[2];
+    gettimeofday(&times[0], NULL);
+    times[0].tv_sec -= age;
+    times[1] = times[0];
+    ck_assert_int_eq(utimes(path, times), 0);
+}
+
+// Test pruning drops expired entries, then the least recently used ones past the size
+// limit, and that a hit counts as a use
+START_TEST(test_cache_prune)
+{
+    char expired[CACHE_PATH_MAX], oldest[CACHE_PATH_MAX], used[CACHE_PATH_MAX];
+    char newest[CACHE_PATH_MAX], temp[CACHE_PATH_MAX + 16];
+    store_aged_entry(1, CACHE_MAX_AGE + 60, expired, sizeof(expired));
+    store_aged_entry(2, 3 * CACHE_TOUCH_INTERVAL, oldest, sizeof(oldest));
+    store_aged_entry(3, 2 * CACHE_TOUCH_INTERVAL, used, sizeof(used));
+    store_aged_entry(4, 60, newest, sizeof(newest));
+
+    // Loading the second oldest makes it the most recently used
+    char key[CACHE_KEY_SIZE];
+    cache_entry_t entry;
+    ck_assert_int_eq(cache_snapshot_key("DP-1", 3, key, sizeof(key)), 0);
+    ck_assert_int_eq(cache_load(key, &entry), 0);
+    cache_release(&entry);
+
+    // Leftover of an interrupted write
+    snprintf(temp, sizeof(temp), "%s.1.1.tmp", newest);
+    FILE* file = fopen(temp, "w");
+    ck_assert_ptr_nonnull(file);
+    fclose(file);
+    struct timeval times[2];
+    gettimeofday(&times[0], NULL);
+    times[0].tv_sec -= 2 * CACHE_TOUCH_INTERVAL;
+    times[1] = times[0];
+    ck_assert_int_eq(utimes(temp, times), 0);
+
+    // Room for two of the remaining three entries
+    struct stat st;
+    ck_assert_int_eq(stat(newest, &st), 0);
+    ck_assert_int_eq(cache_prune((uint64_t)st.st_size * 2, CACHE_MAX_AGE), 3);
+    ck_assert_int_ne(access(expired, F_OK), 0);
+    ck_assert_int_ne(access(oldest, F_OK), 0);
+    ck_assert_int_ne(access(temp, F_OK), 0);
+    ck_assert_int_eq(access(used, F_OK), 0);
+    ck_assert_int_eq(access(newest, F_OK), 0);
+
+    ck_assert_int_eq(cache_prune(0, CACHE_MAX_AGE), 2);
+    ck_assert_int_ne(access(newest, F_OK), 0);
+}
+END_TEST
+
+// Test box-filtered mip levels average 2x2 blocks and clamp odd sizes
+START_TEST(test_image_generate_mips)
+{
+    image_t levels[CACHE_MAX_LEVELS];
+    memset(levels, 0, sizeof(levels));
+    fill_image(&levels[0], 2, 2, 0);
+
+    // Two white and two black pixels average to mid gray
+    memset(levels[0].pixels, 255, 8);
+    int count = image_generate_mips(levels, CACHE_MAX_LEVELS);
+    ck_assert_int_eq(count, 2);
+    ck_assert_int_eq(levels[1].width, 1);
+    ck_assert_int_eq(levels[1].height, 1);
+    ck_assert_int_eq(levels[1].pixels[0], 128);
+    for (int i = 0; i < count; i++) {
+        image_free(&levels[i]);
+    }
+
+    // Odd sizes round down, the chain still ends at 1x1
+    fill_image(&levels[0], 5, 3, 9);
+    count = image_generate_mips(levels, CACHE_MAX_LEVELS);
+    ck_assert_int_eq(count, 3);  // 5x3, 2x1, 1x1
+    ck_assert_int_eq(levels[1].width, 2);
+    ck_assert_int_eq(levels[1].height, 1);
+    ck_assert_int_eq(levels[2].pixels[3], 9);
+    for (int i = 0; i < count; i++) {
+        image_free(&levels[i]);
+    }
+
+    // Level limit is honoured
+    fill_image(&levels[0], 64, 64, 1);
+    ck_assert_int_eq(image_generate_mips(levels, 3), 3);
+    for (int i = 0; i < 3; i++) {
+        image_free(&levels[i]);
+    }
+}
+END_TEST
+
+// Test area resampling preserves flat colors and averages covered pixels
+START_TEST(test_image_resize)
+{
+    image_t src;
+    image_t dst;
+
+    // Flat color survives a non-integer ratio unchanged
+    fill_image(&src, 7, 5, 77);
+    ck_assert_int_eq(image_resize(&src, &dst, 3, 2), 0);
+    ck_assert_int_eq(dst.width, 3);
+    ck_assert_int_eq(dst.height, 2);
+    for (int i = 0; i < 3 * 2 * 4; i++) {
+        ck_assert_int_eq(dst.pixels[i], 77);
+    }
+    image_free(&dst);
+    image_free(&src);
+
+    // 4x1 -> 2x1: left half white, right half black
+    fill_image(&src, 4, 1, 0);
+    memset(src.pixels, 255, 8);
+    ck_assert_int_eq(image_resize(&src, &dst, 2, 1), 0);
+    ck_assert_int_eq(dst.pixels[0], 255);
+    ck_assert_int_eq(dst.pixels[4], 0);
+    image_free(&dst);
+
+    // 4x1 -> 1x1 averages everything; 3x1 -> 2x1 splits the middle pixel
+    ck_assert_int_eq(image_resize(&src, &dst, 1, 1), 0);
+    ck_assert_int_eq(dst.pixels[0], 128);
+    image_free(&dst);
+    image_free(&src);
+
+    fill_image(&src, 3, 1, 0);
+    memset(src.pixels, 255, 4);       // Pixel 0 white
+    memset(src.pixels + 4, 120, 4);   // Pixel 1 gray
+    ck_assert_int_eq(image_resize(&src, &dst, 2, 1), 0);
+    ck_assert_int_eq(dst.pixels[0], 210);  // (255 * 1.0 + 120 * 0.5) / 1.5
+    ck_assert_int_eq(dst.pixels[4], 40);   // (120 * 0.5 + 0 * 1.0) / 1.5
+    image_free(&dst);
+    image_free(&src);
+
+    // Invalid sizes
+    ck_assert_int_eq(image_resize(NULL, &dst, 1, 1), -1);
+}
+END_TEST
+
+// Test alpha coverage: opaque flag and the bounding box of visible pixels
+START_TEST(test_image_coverage)
+{
+    image_t image;
+    image_coverage_t coverage;
+
+    fill_image(&image, 8, 4, 255);
+    image_analyze_coverage(&image, &coverage);
+    ck_assert_int_eq(coverage.opaque, 1);
+    ck_assert_int_eq(coverage.empty, 0);
+    ck_assert_float_eq(coverage.u0, 0.0f);
+    ck_assert_float_eq(coverage.v1, 1.0f);
+
+    // Clear everything, then make pixels (2,1) and (5,2) visible
+    memset(image.pixels, 0, 8 * 4 * 4);
+    image_analyze_coverage(&image, &coverage);
+    ck_assert_int_eq(coverage.opaque, 0);
+    ck_assert_int_eq(coverage.empty, 1);
+
+    image.pixels[(1 * 8 + 2) * 4 + 3] = 10;
+    image.pixels[(2 * 8 + 5) * 4 + 3] = 200;
+    image_analyze_coverage(&image, &coverage);
+    ck_assert_int_eq(coverage.opaque, 0);
+    ck_assert_int_eq(coverage.empty, 0);
+    ck_assert_float_eq_tol(coverage.u0, 2.0f / 8.0f, 0.0001f);
+    ck_assert_float_eq_tol(coverage.u1, 6.0f / 8.0f, 0.0001f);
+    ck_assert_float_eq_tol(coverage.v0, 1.0f / 4.0f, 0.0001f);
+    ck_assert_float_eq_tol(coverage.v1, 3.0f / 4.0f, 0.0001f);
+    image_free(&image);
+
+    // Missing images are treated as fully covering
+    image_analyze_coverage(NULL, &coverage);
+    ck_assert_int_eq(coverage.opaque, 1);
+}
+END_TEST
+
+// Test content hashes match for identical pixels and differ otherwise
+START_TEST(test_image_content_hash)
+{
+    image_t a, b;
+    fill_image(&a, 8, 4, 255);
+    fill_image(&b, 8, 4, 255);
+    ck_assert(image_content_hash(&a) == image_content_hash(&b));
+
+    b.pixels[5 * 4 + 1] ^= 1;
+    ck_assert(image_content_hash(&a) != image_content_hash(&b));
+    image_free(&b);
+
+    // Same bytes, different shape
+    fill_image(&b, 4, 8, 255);
+    ck_assert(image_content_hash(&a) != image_content_hash(&b));
+
+    image_free(&a);
+    image_free(&b);
+    ck_assert(image_content_hash(NULL) == 0);
+}
+END_TEST
+
+// Create the test suite
+Suite *cache_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Cache");
+
+    tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_add_test(tc_core, test_cache_key);
+    tcase_add_test(tc_core, test_cache_snapshot_key);
+    tcase_add_test(tc_core, test_cache_roundtrip);
+    tcase_add_test(tc_core, test_cache_rejects_invalid);
+    tcase_add_test(tc_core, test_cache_prune);
+    tcase_add_test(tc_core, test_cache_compressed_roundtrip);
+    tcase_add_test(tc_core, test_texcomp_solid_blocks);
+    tcase_add_test(tc_core, test_image_generate_mips);
+    tcase_add_test(tc_core, test_image_resize);
+    tcase_add_test(tc_core, test_image_coverage);
+    tcase_add_test(tc_core, test_image_content_hash);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = cache_suite();
+    sr = srunner_create(s);
+
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,91 @@
+// Test suite for udmabuf-backed layer buffers using Check framework
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "../src/dmabuf.h"
+
+// Test a buffer is page-aligned, writable and shareable, or cleanly refused without udmabuf
+START_TEST(test_dmabuf_create)
+{
+    dmabuf_image_t image;
+    int result = dmabuf_image_create(&image, 33, 7);
+
+    if (!dmabuf_supported()) {
+        ck_assert_int_eq(result, -1);
+        ck_assert_int_eq(image.fd, -1);
+        ck_assert_int_eq(image.memfd, -1);
+        ck_assert_ptr_null(image.pixels);
+        return;
+    }
+
+    ck_assert_int_eq(result, 0);
+    ck_assert_int_ge(image.fd, 0);
+    ck_assert_int_eq(image.stride, 33 * 4);
+    ck_assert_uint_ge(image.size, (size_t)33 * 4 * 7);
+    ck_assert_uint_eq(image.size % sysconf(_SC_PAGESIZE), 0);
+    ck_assert(fcntl(image.fd, F_GETFD) & FD_CLOEXEC);
+
+    memset(image.pixels, 0xab, (size_t)image.stride * image.height);
+    ck_assert_int_eq(image.pixels[image.stride * image.height - 1], 0xab);
+
+    dmabuf_image_destroy(&image);
+    ck_assert_int_eq(image.fd, -1);
+    ck_assert_ptr_null(image.pixels);
+}
+END_TEST
+
+// Test invalid sizes are rejected and destroying an unused buffer is harmless
+START_TEST(test_dmabuf_invalid)
+{
+    dmabuf_image_t image;
+    ck_assert_int_eq(dmabuf_image_create(&image, 0, 16), -1);
+    ck_assert_int_eq(dmabuf_image_create(&image, 16, -1), -1);
+    ck_assert_int_eq(image.fd, -1);
+    ck_assert_int_eq(dmabuf_image_create(NULL, 16, 16), -1);
+
+    dmabuf_image_destroy(&image);
+    dmabuf_image_destroy(NULL);
+
+    // A zeroed image (e.g. in a calloc'd job) must not close descriptor 0
+    memset(&image, 0, sizeof(image));
+    dmabuf_image_destroy(&image);
+    ck_assert_int_ne(fcntl(0, F_GETFD), -1);
+}
+END_TEST
+
+// Create the test suite
+Suite *dmabuf_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Dmabuf");
+
+    tc_core = tcase_create("Core");
+    tcase_add_test(tc_core, test_dmabuf_create);
+    tcase_add_test(tc_core, test_dmabuf_invalid);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = dmabuf_suite();
+    sr = srunner_create(s);
+
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,6 +4,8 @@
 #include <math.h>
 #include <string.h>
 
+#include "../src/easing.h"
+
 // Easing function implementations (simplified)
 float ease_linear(float t) { return t; }
 float ease_quad(float t) { return t * t; }
@@ -133,6 +135,150 @@ START_TEST(test_snap_easing)
 }
 END_TEST
 
+// Test the lookup tables track the exact curves closely enough for pixel offsets
+START_TEST(test_easing_lookup_accuracy)
+{
+    for (int type = 0; type < EASE_COUNT; type++) {
+        ck_assert_float_eq(easing_lookup(0.0f, type), easing_apply(0.0f, type));
+        ck_assert_float_eq(easing_lookup(1.0f, type), easing_apply(1.0f, type));
+
+        // Out of range times clamp to the ends
+        ck_assert_float_eq(easing_lookup(-0.5f, type), easing_apply(0.0f, type));
+        ck_assert_float_eq(easing_lookup(1.5f, type), easing_apply(1.0f, type));
+
+        for (int i = 0; i <= 10000; i++) {
+            float t = i / 10000.0f;
+            // Expo, elastic and snap jump at t = 1 (snap also at 0.4); the table spreads
+            // each jump over the interval that holds it
+            float jump = type == EASE_CUSTOM_SNAP ? 0.4f : 1.0f;
+            if (t < 1.0f && (fabsf(t - jump) < 1.0f / EASING_LUT_SIZE ||
+                             1.0f - t < 1.0f / EASING_LUT_SIZE)) {
+                continue;
+            }
+            // Under a pixel on a 10000 px pan
+            ck_assert_float_eq_tol(easing_lookup(t, type), easing_apply(t, type), 0.0001f);
+        }
+    }
+}
+END_TEST
+
+// Test the animation table moves every row along its own curve
+START_TEST(test_anim_table_update)
+{
+    anim_table_t table = {0};
+    ck_assert_int_eq(anim_table_resize(&table, 3), 0);
+    ck_assert_int_eq(table.count, 3);
+    ck_assert_float_eq(table.current[2], 0.0f);
+
+    anim_table_retarget(&table, 0, 100.0f, 10.0, 0.0f, 1.0f, EASE_LINEAR);
+    anim_table_retarget(&table, 1, 200.0f, 10.0, 0.5f, 1.0f, EASE_LINEAR);
+
+    int changed = 0;
+    ck_assert_int_eq(anim_table_update(&table, 10.25, &changed), 2);
+    ck_assert_int_eq(changed, 1);
+    ck_assert_float_eq_tol(table.current[0], 25.0f, 0.01f);
+    ck_assert_float_eq(table.current[1], 0.0f);  // Still in its delay
+    ck_assert_float_eq(table.current[2], 0.0f);  // Never started
+
+    ck_assert_int_eq(anim_table_update(&table, 11.0, NULL), 1);
+    ck_assert_float_eq(table.current[0], 100.0f);
+    ck_assert_float_eq_tol(table.current[1], 100.0f, 0.01f);
+
+    changed = 0;
+    ck_assert_int_eq(anim_table_update(&table, 12.0, &changed), 0);
+    ck_assert_float_eq(table.current[1], 200.0f);
+    ck_assert_int_eq(changed, 1);
+
+    // Settled rows don't report changes
+    changed = 0;
+    ck_assert_int_eq(anim_table_update(&table, 13.0, &changed), 0);
+    ck_assert_int_eq(changed, 0);
+
+    anim_table_free(&table);
+    ck_assert_int_eq(table.count, 0);
+}
+END_TEST
+
+// Test retargeting mid-animation continues from the current offset
+START_TEST(test_anim_table_retarget)
+{
+    anim_table_t table = {0};
+    ck_assert_int_eq(anim_table_resize(&table, 1), 0);
+
+    anim_table_retarget(&table, 0, 100.0f, 0.0, 0.0f, 1.0f, EASE_LINEAR);
+    anim_table_retarget(&table, 0, 0.0f, 0.5, 0.0f, 1.0f, EASE_LINEAR);
+    ck_assert_float_eq_tol(table.start[0], 50.0f, 0.01f);
+    ck_assert_float_eq(table.target[0], 0.0f);
+
+    anim_table_update(&table, 1.0, NULL);
+    ck_assert_float_eq_tol(table.current[0], 25.0f, 0.01f);
+
+    anim_table_free(&table);
+}
+END_TEST
+
+// Test removing and remapping rows keeps each layer's state with it
+START_TEST(test_anim_table_rows)
+{
+    anim_table_t table = {0};
+    ck_assert_int_eq(anim_table_resize(&table, 20), 0);  // Past the initial capacity
+    for (int i = 0; i < 20; i++) {
+        anim_table_set(&table, i, (float)i);
+    }
+
+    anim_table_remove(&table, 0);
+    ck_assert_int_eq(table.count, 19);
+    ck_assert_float_eq(table.current[0], 1.0f);
+    ck_assert_float_eq(table.current[18], 19.0f);
+
+    int from[] = {2, -1, 0};
+    ck_assert_int_eq(anim_table_remap(&table, from, 3), 0);
+    ck_assert_int_eq(table.count, 3);
+    ck_assert_float_eq(table.current[0], 3.0f);
+    ck_assert_float_eq(table.current[1], 0.0f);
+    ck_assert_float_eq(table.current[2], 1.0f);
+
+    // Shrinking keeps the leading rows
+    ck_assert_int_eq(anim_table_resize(&table, 1), 0);
+    ck_assert_float_eq(table.current[0], 3.0f);
+
+    anim_table_free(&table);
+}
+END_TEST
+
+// Test settling leaves curves to someone else but still finishes rows on time
+START_TEST(test_anim_table_settle)
+{
+    anim_table_t table = {0};
+    ck_assert_int_eq(anim_table_resize(&table, 3), 0);
+    anim_table_retarget(&table, 0, 100.0f, 0.0, 0.0f, 1.0f, EASE_EXPO_OUT);
+    anim_table_retarget(&table, 1, 100.0f, 0.0, 0.0f, 1.0f, EASE_EXPO_OUT);
+    anim_table_retarget(&table, 2, 100.0f, 0.0, 0.5f, 1.0f, EASE_EXPO_OUT);
+    ck_assert(anim_table_rows_match(&table, 0, 1));
+    ck_assert(!anim_table_rows_match(&table, 0, 2));
+
+    // Nothing but the delayed row's wait has passed: no visible change yet
+    int changed = 0;
+    ck_assert_int_eq(anim_table_settle(&table, 0.0, &changed), 3);
+    ck_assert_int_eq(changed, 0);
+
+    changed = 0;
+    ck_assert_int_eq(anim_table_settle(&table, 0.25, &changed), 3);
+    ck_assert_int_eq(changed, 1);
+    ck_assert_float_eq(table.current[0], 0.0f);  // Left for the shader
+    ck_assert_float_eq_tol(anim_table_offset(&table, 0, 0.25),
+                           100.0f * easing_apply(0.25f, EASE_EXPO_OUT), 0.01f);
+
+    ck_assert_int_eq(anim_table_settle(&table, 1.0, NULL), 1);
+    ck_assert_float_eq(table.current[0], 100.0f);
+    ck_assert_int_eq(anim_table_settle(&table, 1.5, NULL), 0);
+    ck_assert_float_eq(table.current[2], 100.0f);
+    ck_assert(anim_table_rows_match(&table, 0, 2));
+
+    anim_table_free(&table);
+}
+END_TEST
+
 // Create the test suite
 Suite *easing_suite(void)
 {
@@ -147,6 +293,11 @@ Suite *easing_suite(void)
     tcase_add_test(tc_core, test_easing_parsing);
     tcase_add_test(tc_core, test_easing_interpolation);
     tcase_add_test(tc_core, test_snap_easing);
+    tcase_add_test(tc_core, test_easing_lookup_accuracy);
+    tcase_add_test(tc_core, test_anim_table_update);
+    tcase_add_test(tc_core, test_anim_table_retarget);
+    tcase_add_test(tc_core, test_anim_table_rows);
+    tcase_add_test(tc_core, test_anim_table_settle);
     suite_add_tcase(s, tc_core);
     
     return s;
@@ -0,0 +1,130 @@
+// Test suite for the id -> slot hash map using Check framework
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/idmap.h"
+
+// Test basic insert, lookup, overwrite and removal
+START_TEST(test_idmap_basic)
+{
+    idmap_t map = {0};
+    int value = -1;
+
+    ck_assert_int_eq(idmap_get(&map, 1, &value), -1);
+    ck_assert_int_eq(idmap_put(&map, 1, 10), 0);
+    ck_assert_int_eq(idmap_put(&map, 2, 20), 0);
+    ck_assert_int_eq(map.count, 2);
+
+    ck_assert_int_eq(idmap_get(&map, 1, &value), 0);
+    ck_assert_int_eq(value, 10);
+    ck_assert_int_eq(idmap_put(&map, 1, 11), 0);
+    ck_assert_int_eq(idmap_get(&map, 1, &value), 0);
+    ck_assert_int_eq(value, 11);
+    ck_assert_int_eq(map.count, 2);
+
+    ck_assert_int_eq(idmap_remove(&map, 1), 0);
+    ck_assert_int_eq(idmap_get(&map, 1, &value), -1);
+    ck_assert_int_eq(idmap_remove(&map, 1), -1);
+    ck_assert_int_eq(map.count, 1);
+
+    // Id 0 is reserved for empty buckets
+    ck_assert_int_eq(idmap_put(&map, 0, 5), -1);
+
+    idmap_free(&map);
+    ck_assert_int_eq(map.capacity, 0);
+}
+END_TEST
+
+// Test growth and removals keep every remaining entry reachable
+START_TEST(test_idmap_growth_and_removal)
+{
+    idmap_t map = {0};
+    const int count = 1000;
+
+    for (int i = 1; i <= count; i++) {
+        ck_assert_int_eq(idmap_put(&map, (uint32_t)i, i * 2), 0);
+    }
+    ck_assert_int_eq(map.count, count);
+    ck_assert_int_gt(map.capacity, count);
+
+    // Remove every third id; the probe chains must stay intact
+    for (int i = 3; i <= count; i += 3) {
+        ck_assert_int_eq(idmap_remove(&map, (uint32_t)i), 0);
+    }
+    for (int i = 1; i <= count; i++) {
+        int value = -1;
+        if (i % 3 == 0) {
+            ck_assert_int_eq(idmap_get(&map, (uint32_t)i, &value), -1);
+        } else {
+            ck_assert_int_eq(idmap_get(&map, (uint32_t)i, &value), 0);
+            ck_assert_int_eq(value, i * 2);
+        }
+    }
+
+    idmap_clear(&map);
+    ck_assert_int_eq(map.count, 0);
+    ck_assert_int_eq(idmap_get(&map, 1, NULL), -1);
+
+    idmap_free(&map);
+}
+END_TEST
+
+// Test keys that collide in the table (multiples of the capacity)
+START_TEST(test_idmap_collisions)
+{
+    idmap_t map = {0};
+    uint32_t ids[] = {16, 32, 48, 64, 80};
+    int n = sizeof(ids) / sizeof(ids[0]);
+
+    for (int i = 0; i < n; i++) {
+        ck_assert_int_eq(idmap_put(&map, ids[i], i), 0);
+    }
+    ck_assert_int_eq(idmap_remove(&map, ids[1]), 0);
+    ck_assert_int_eq(idmap_remove(&map, ids[3]), 0);
+
+    for (int i = 0; i < n; i++) {
+        int value = -1;
+        int expected = (i == 1 || i == 3) ? -1 : 0;
+        ck_assert_int_eq(idmap_get(&map, ids[i], &value), expected);
+        if (expected == 0) ck_assert_int_eq(value, i);
+    }
+
+    idmap_free(&map);
+}
+END_TEST
+
+// Create the test suite
+Suite *idmap_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Idmap");
+
+    tc_core = tcase_create("Core");
+    tcase_add_test(tc_core, test_idmap_basic);
+    tcase_add_test(tc_core, test_idmap_growth_and_removal);
+    tcase_add_test(tc_core, test_idmap_collisions);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = idmap_suite();
+    sr = srunner_create(s);
+
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -55,6 +55,7 @@ START_TEST(test_ipc_init)
     ck_assert_int_ge(ctx->socket_fd, 0);
     ck_assert_int_eq(ctx->layer_count, 0);
     ck_assert_int_eq(ctx->next_layer_id, 1);
+    ck_assert_ptr_null(ctx->stats);
     
     // Check socket exists
     ck_assert_int_eq(access(ctx->socket_path, F_OK), 0);
@@ -243,6 +244,125 @@ START_TEST(test_ipc_max_layers)
 }
 END_TEST
 
+// Test the change journal records adds, removes and coalesced modifies
+START_TEST(test_ipc_change_journal)
+{
+    ipc_context_t* ctx = ipc_init();
+    ck_assert_ptr_nonnull(ctx);
+
+    uint32_t a = ipc_add_layer(ctx, test_image, 1.0f, 1.0f, 0.0f, 0.0f, 0);
+    uint32_t b = ipc_add_layer(ctx, test_image, 1.0f, 1.0f, 0.0f, 0.0f, 1);
+    ck_assert_int_eq(ctx->change_count, 2);
+    ck_assert_int_eq(ctx->changes[0].type, IPC_CHANGE_ADD);
+    ck_assert_int_eq(ctx->changes[0].layer_id, a);
+
+    // A modify of a layer added in the same batch adds nothing new
+    ck_assert(ipc_modify_layer(ctx, a, "opacity", "0.5"));
+    ck_assert_int_eq(ctx->change_count, 2);
+
+    ipc_clear_changes(ctx);
+    ck_assert_int_eq(ctx->change_count, 0);
+
+    // Repeated modifies fold into one entry
+    for (int i = 0; i < 10; i++) {
+        ck_assert(ipc_modify_layer(ctx, b, "opacity", "0.25"));
+    }
+    ck_assert_int_eq(ctx->change_count, 1);
+    ck_assert_int_eq(ctx->changes[0].type, IPC_CHANGE_MODIFY);
+
+    // Failed commands leave the journal alone
+    ck_assert(!ipc_modify_layer(ctx, b, "bogus", "1"));
+    ck_assert(!ipc_remove_layer(ctx, 999));
+    ck_assert_int_eq(ctx->change_count, 1);
+
+    ck_assert(ipc_remove_layer(ctx, b));
+    ck_assert_int_eq(ctx->change_count, 2);
+    ck_assert_int_eq(ctx->changes[1].type, IPC_CHANGE_REMOVE);
+    ck_assert_int_eq(ctx->changes[1].layer_id, b);
+    ck_assert(!ctx->changes_overflowed);
+
+    ipc_cleanup(ctx);
+}
+END_TEST
+
+// Test a full journal asks the renderer for a complete resync
+START_TEST(test_ipc_change_journal_overflow)
+{
+    ipc_context_t* ctx = ipc_init();
+    ck_assert_ptr_nonnull(ctx);
+
+    for (int i = 0; i <= IPC_MAX_CHANGES / 2; i++) {
+        uint32_t id = ipc_add_layer(ctx, test_image, 1.0f, 1.0f, 0.0f, 0.0f, 0);
+        ck_assert_int_gt(id, 0);
+        ck_assert(ipc_remove_layer(ctx, id));
+    }
+    ck_assert(ctx->changes_overflowed);
+    ck_assert_int_eq(ctx->change_count, 0);
+
+    ipc_clear_changes(ctx);
+    ck_assert(!ctx->changes_overflowed);
+
+    ipc_cleanup(ctx);
+}
+END_TEST
+
+// Renderer stub for ipc_sync_layers: records what it was handed
+static uint32_t synced_ids[IPC_MAX_LAYERS];
+static int synced_count = 0;
+static int pruned = 0;
+
+static bool record_apply(uint32_t layer_id, void* data)
+{
+    (void)data;
+    if (synced_count < IPC_MAX_LAYERS) synced_ids[synced_count++] = layer_id;
+    return true;
+}
+
+static bool record_prune(void* data)
+{
+    (void)data;
+    pruned++;
+    return false;
+}
+
+// Test the renderer is handed exactly the journaled layers, or all of them after an overflow
+START_TEST(test_ipc_sync_layers)
+{
+    ipc_context_t* ctx = ipc_init();
+    ck_assert_ptr_nonnull(ctx);
+    const ipc_sync_ops_t ops = { .apply = record_apply, .prune = record_prune };
+
+    uint32_t a = ipc_add_layer(ctx, test_image, 1.0f, 1.0f, 0.0f, 0.0f, 0);
+    uint32_t b = ipc_add_layer(ctx, test_image, 1.0f, 1.0f, 0.0f, 0.0f, 1);
+    ipc_clear_changes(ctx);
+
+    // Nothing journaled, nothing to do
+    synced_count = pruned = 0;
+    ck_assert(!ipc_sync_layers(ctx, &ops));
+    ck_assert_int_eq(synced_count, 0);
+
+    ck_assert(ipc_modify_layer(ctx, b, "opacity", "0.5"));
+    ck_assert(ipc_sync_layers(ctx, &ops));
+    ck_assert_int_eq(synced_count, 1);
+    ck_assert_uint_eq(synced_ids[0], b);
+    ck_assert_int_eq(pruned, 0);
+    ck_assert_int_eq(ctx->change_count, 0);
+
+    // Overflow: prune once, then every layer
+    ctx->changes_overflowed = true;
+    synced_count = 0;
+    ck_assert(ipc_sync_layers(ctx, &ops));
+    ck_assert_int_eq(pruned, 1);
+    ck_assert_int_eq(synced_count, 2);
+    ck_assert_uint_eq(synced_ids[0], a);
+    ck_assert_uint_eq(synced_ids[1], b);
+    ck_assert(!ctx->changes_overflowed);
+
+    ck_assert(!ipc_sync_layers(NULL, &ops));
+    ipc_cleanup(ctx);
+}
+END_TEST
+
 // Test client-server communication
 START_TEST(test_ipc_client_server)
 {
@@ -318,6 +438,249 @@ START_TEST(test_ipc_client_server)
 }
 END_TEST
 
+// Connect a client to the context's socket
+static int connect_test_client(ipc_context_t* ctx) {
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    ck_assert_int_ge(sock, 0);
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, ctx->socket_path, strnlen(ctx->socket_path, sizeof(addr.sun_path) - 1));
+    ck_assert_int_eq(connect(sock, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    return sock;
+}
+
+// Read whatever the server has sent so far
+static void recv_test_responses(int sock, char* buffer, size_t size) {
+    ssize_t n = recv(sock, buffer, size - 1, MSG_DONTWAIT);
+    buffer[n > 0 ? n : 0] = '\0';
+}
+
+// Test several commands pipelined in one write over a persistent connection
+START_TEST(test_ipc_pipelined_commands)
+{
+    test_ctx = ipc_init();
+    ck_assert_ptr_nonnull(test_ctx);
+    int sock = connect_test_client(test_ctx);
+
+    char commands[256];
+    snprintf(commands, sizeof(commands), "add %s\nadd %s z=5\nmodify 1 opacity 0.5\nsta",
+             test_image, test_image);
+    send(sock, commands, strlen(commands), 0);
+
+    ck_assert(ipc_process_commands(test_ctx));
+    ck_assert_int_eq(test_ctx->layer_count, 2);
+    ck_assert_float_eq_tol(ipc_find_layer(test_ctx, 1)->opacity, 0.5f, 0.001f);
+
+    // Each response ends with a blank line; the partial command waits for its newline
+    char buffer[1024];
+    recv_test_responses(sock, buffer, sizeof(buffer));
+    ck_assert_str_eq(buffer,
+        "Layer added with ID: 1\n\n"
+        "Layer added with ID: 2\n\n"
+        "Layer 1 modified\n\n");
+
+    // The same connection stays open for the rest of the command
+    send(sock, "tus\n", 4, 0);
+    ck_assert(ipc_process_commands(test_ctx));
+    recv_test_responses(sock, buffer, sizeof(buffer));
+    ck_assert_ptr_nonnull(strstr(buffer, "Status: Active\nLayers: 2/32\n"));
+
+    // Closing the connection frees its slot
+    close(sock);
+    ck_assert(!ipc_process_commands(test_ctx));
+    for (int i = 0; i < IPC_MAX_CLIENTS; i++) {
+        ck_assert_int_eq(test_ctx->clients[i].fd, -1);
+    }
+}
+END_TEST
+
+// Test that a transaction holds back the sync until it is committed
+START_TEST(test_ipc_transaction)
+{
+    test_ctx = ipc_init();
+    ck_assert_ptr_nonnull(test_ctx);
+    int sock = connect_test_client(test_ctx);
+
+    char commands[256];
+    snprintf(commands, sizeof(commands), "begin\nadd %s\nadd %s\n", test_image, test_image);
+    send(sock, commands, strlen(commands), 0);
+
+    // Commands inside the transaction are applied but not yet journaled for the renderer
+    ck_assert(!ipc_process_commands(test_ctx));
+    ck_assert_int_eq(test_ctx->layer_count, 2);
+    ck_assert_int_eq(test_ctx->change_count, 0);
+    ck_assert_int_eq(test_ctx->open_transactions, 1);
+
+    send(sock, "commit\ncommit\n", 14, 0);
+    ck_assert(ipc_process_commands(test_ctx));
+    ck_assert_int_eq(test_ctx->open_transactions, 0);
+    ck_assert_int_eq(test_ctx->change_count, 2);
+
+    char buffer[1024];
+    recv_test_responses(sock, buffer, sizeof(buffer));
+    ck_assert_str_eq(buffer,
+        "Transaction started\n\n"
+        "Layer added with ID: 1\n\n"
+        "Layer added with ID: 2\n\n"
+        "Transaction committed\n\n"
+        "Error: No transaction open\n\n");
+
+    // Hanging up mid-transaction commits it
+    send(sock, "begin\nclear\n", 12, 0);
+    ck_assert(!ipc_process_commands(test_ctx));
+    close(sock);
+    ck_assert(ipc_process_commands(test_ctx));
+    ck_assert_int_eq(test_ctx->open_transactions, 0);
+    ck_assert_int_eq(test_ctx->layer_count, 0);
+}
+END_TEST
+
+// Test that a client holding a transaction open doesn't hold back other clients
+START_TEST(test_ipc_transaction_isolated)
+{
+    test_ctx = ipc_init();
+    ck_assert_ptr_nonnull(test_ctx);
+    uint32_t id = ipc_add_layer(test_ctx, test_image, 1.0f, 1.0f, 0.0f, 0.0f, 0);
+    ipc_clear_changes(test_ctx);
+    int sock_a = connect_test_client(test_ctx);
+    int sock_b = connect_test_client(test_ctx);
+
+    char commands[256];
+    snprintf(commands, sizeof(commands), "begin\nadd %s\n", test_image);
+    send(sock_a, commands, strlen(commands), 0);
+    ck_assert(!ipc_process_commands(test_ctx));
+
+    snprintf(commands, sizeof(commands), "modify %u opacity 0.5\n", id);
+    send(sock_b, commands, strlen(commands), 0);
+    ck_assert(ipc_process_commands(test_ctx));
+    ck_assert_int_eq(test_ctx->change_count, 1);
+    ck_assert_int_eq(test_ctx->changes[0].type, IPC_CHANGE_MODIFY);
+    ck_assert_int_eq(test_ctx->changes[0].layer_id, id);
+    ipc_clear_changes(test_ctx);
+
+    // A's add reaches the journal with its commit
+    send(sock_a, "commit\n", 7, 0);
+    ck_assert(ipc_process_commands(test_ctx));
+    ck_assert_int_eq(test_ctx->change_count, 1);
+    ck_assert_int_eq(test_ctx->changes[0].type, IPC_CHANGE_ADD);
+
+    close(sock_a);
+    close(sock_b);
+}
+END_TEST
+
+static int reload_calls;
+
+static bool fake_reload(char* response, size_t size)
+{
+    reload_calls++;
+    snprintf(response, size, "Config reloaded\n");
+    return true;
+}
+
+// Test reload is answered by the renderer's hook, or refused when there is none
+START_TEST(test_ipc_reload)
+{
+    test_ctx = ipc_init();
+    ck_assert_ptr_nonnull(test_ctx);
+    int sock = connect_test_client(test_ctx);
+
+    send(sock, "reload\n", 7, 0);
+    ck_assert(!ipc_process_commands(test_ctx));
+
+    test_ctx->reload_config = fake_reload;
+    reload_calls = 0;
+    send(sock, "reload\n", 7, 0);
+    ck_assert(ipc_process_commands(test_ctx));
+    ck_assert_int_eq(reload_calls, 1);
+
+    char buffer[256];
+    recv_test_responses(sock, buffer, sizeof(buffer));
+    ck_assert_str_eq(buffer,
+        "Error: Config reload not available\n\n"
+        "Config reloaded\n\n");
+    close(sock);
+}
+END_TEST
+
+static char scene_path[256];
+static double scene_delay, scene_fade;
+
+static bool fake_queue_scene(const char* path, double delay, double fade, char* response, size_t size)
+{
+    snprintf(scene_path, sizeof(scene_path), "%s", path);
+    scene_delay = delay;
+    scene_fade = fade;
+    snprintf(response, size, "Scene queued\n");
+    return true;
+}
+
+// Test scene hands its path and timing to the renderer's hook
+START_TEST(test_ipc_scene)
+{
+    test_ctx = ipc_init();
+    ck_assert_ptr_nonnull(test_ctx);
+    int sock = connect_test_client(test_ctx);
+
+    const char* command = "scene /tmp/night.conf\n";
+    send(sock, command, strlen(command), 0);
+    ck_assert(!ipc_process_commands(test_ctx));
+
+    test_ctx->queue_scene = fake_queue_scene;
+    send(sock, command, strlen(command), 0);
+    ck_assert(ipc_process_commands(test_ctx));
+    ck_assert_str_eq(scene_path, "/tmp/night.conf");
+    ck_assert_float_eq_tol(scene_delay, 0.0, 0.001);
+    ck_assert_float_eq_tol(scene_fade, IPC_SCENE_DEFAULT_FADE, 0.001);
+
+    command = "scene /tmp/day.conf in=60 fade=2.5\nscene\n";
+    send(sock, command, strlen(command), 0);
+    ck_assert(ipc_process_commands(test_ctx));
+    ck_assert_str_eq(scene_path, "/tmp/day.conf");
+    ck_assert_float_eq_tol(scene_delay, 60.0, 0.001);
+    ck_assert_float_eq_tol(scene_fade, 2.5, 0.001);
+
+    char buffer[512];
+    recv_test_responses(sock, buffer, sizeof(buffer));
+    ck_assert_str_eq(buffer,
+        "Error: Scenes not available\n\n"
+        "Scene queued\n\n"
+        "Scene queued\n\n"
+        "Error: Usage: scene <config> [in=seconds] [fade=seconds]\n\n");
+    close(sock);
+}
+END_TEST
+
+static void fake_memory(char* out, size_t size)
+{
+    snprintf(out, size, "GPU memory: 12.0 MiB\n");
+}
+
+// Test status appends the renderer's memory totals when it provides them
+START_TEST(test_ipc_status_memory)
+{
+    test_ctx = ipc_init();
+    ck_assert_ptr_nonnull(test_ctx);
+    int sock = connect_test_client(test_ctx);
+
+    send(sock, "status\n", 7, 0);
+    ipc_process_commands(test_ctx);
+    char buffer[512];
+    recv_test_responses(sock, buffer, sizeof(buffer));
+    ck_assert_ptr_null(strstr(buffer, "GPU memory"));
+
+    test_ctx->format_memory = fake_memory;
+    send(sock, "status\n", 7, 0);
+    ipc_process_commands(test_ctx);
+    recv_test_responses(sock, buffer, sizeof(buffer));
+    ck_assert_ptr_nonnull(strstr(buffer, "Layers: 0/32\n"));
+    ck_assert_ptr_nonnull(strstr(buffer, "GPU memory: 12.0 MiB\n\n"));
+    close(sock);
+}
+END_TEST
+
 // Create the test suite
 Suite *ipc_suite(void)
 {
@@ -344,6 +707,9 @@ Suite *ipc_suite(void)
     tcase_add_test(tc_layers, test_ipc_clear_layers);
     tcase_add_test(tc_layers, test_ipc_sort_layers);
     tcase_add_test(tc_layers, test_ipc_max_layers);
+    tcase_add_test(tc_layers, test_ipc_change_journal);
+    tcase_add_test(tc_layers, test_ipc_change_journal_overflow);
+    tcase_add_test(tc_layers, test_ipc_sync_layers);
     suite_add_tcase(s, tc_layers);
     
     // Communication test case
@@ -351,6 +717,12 @@ Suite *ipc_suite(void)
     tcase_add_checked_fixture(tc_comm, setup, teardown);
     tcase_set_timeout(tc_comm, 5);  // 5 second timeout
     tcase_add_test(tc_comm, test_ipc_client_server);
+    tcase_add_test(tc_comm, test_ipc_pipelined_commands);
+    tcase_add_test(tc_comm, test_ipc_transaction);
+    tcase_add_test(tc_comm, test_ipc_transaction_isolated);
+    tcase_add_test(tc_comm, test_ipc_reload);
+    tcase_add_test(tc_comm, test_ipc_scene);
+    tcase_add_test(tc_comm, test_ipc_status_memory);
     suite_add_tcase(s, tc_comm);
     
     return s;
@@ -0,0 +1,128 @@
+// Test suite for the line framing buffer using Check framework
+#include <check.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/linebuf.h"
+
+// Non-blocking pipe standing in for the event socket
+static void open_pipe(int fds[2]) {
+    ck_assert_int_eq(pipe(fds), 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+}
+
+// Test that a line split across reads is kept until it completes
+START_TEST(test_linebuf_partial_lines)
+{
+    linebuf_t buf = {0};
+    int fds[2];
+    open_pipe(fds);
+
+    ck_assert_int_eq(write(fds[1], "workspace>>1\nfocusedmon>>DP", 27), 27);
+    ck_assert_int_eq(linebuf_fill(&buf, fds[0]), 27);
+    ck_assert_str_eq(linebuf_next(&buf), "workspace>>1");
+    ck_assert_ptr_null(linebuf_next(&buf));
+
+    ck_assert_int_eq(write(fds[1], "-1,2\nworkspace>>3\n", 18), 18);
+    ck_assert_int_eq(linebuf_fill(&buf, fds[0]), 18);
+    ck_assert_str_eq(linebuf_next(&buf), "focusedmon>>DP-1,2");
+    ck_assert_str_eq(linebuf_next(&buf), "workspace>>3");
+    ck_assert_ptr_null(linebuf_next(&buf));
+
+    // Nothing pending is not an error
+    ck_assert_int_eq(linebuf_fill(&buf, fds[0]), 0);
+
+    close(fds[0]);
+    close(fds[1]);
+    linebuf_free(&buf);
+}
+END_TEST
+
+// Test that a burst larger than the initial capacity is drained in one call
+START_TEST(test_linebuf_growth)
+{
+    linebuf_t buf = {0};
+    int fds[2];
+    open_pipe(fds);
+
+    char line[32];
+    long written = 0;
+    for (int i = 0; i < 1000; i++) {
+        int n = snprintf(line, sizeof(line), "workspace>>%d\n", i);
+        ck_assert_int_eq(write(fds[1], line, n), n);
+        written += n;
+    }
+
+    ck_assert_int_eq(linebuf_fill(&buf, fds[0]), written);
+    ck_assert_uint_gt(buf.capacity, LINEBUF_MIN_CAPACITY);
+
+    int count = 0;
+    char *next;
+    while ((next = linebuf_next(&buf))) {
+        snprintf(line, sizeof(line), "workspace>>%d", count++);
+        ck_assert_str_eq(next, line);
+    }
+    ck_assert_int_eq(count, 1000);
+
+    close(fds[0]);
+    close(fds[1]);
+    linebuf_free(&buf);
+    ck_assert_ptr_null(buf.data);
+}
+END_TEST
+
+// Test that end of stream is reported but buffered lines stay readable
+START_TEST(test_linebuf_eof)
+{
+    linebuf_t buf = {0};
+    int fds[2];
+    open_pipe(fds);
+
+    ck_assert_int_eq(write(fds[1], "workspace>>2\n", 13), 13);
+    close(fds[1]);
+
+    ck_assert_int_eq(linebuf_fill(&buf, fds[0]), LINEBUF_CLOSED);
+    ck_assert_str_eq(linebuf_next(&buf), "workspace>>2");
+    ck_assert_ptr_null(linebuf_next(&buf));
+
+    close(fds[0]);
+    linebuf_free(&buf);
+}
+END_TEST
+
+// Create the test suite
+Suite *linebuf_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Linebuf");
+
+    tc_core = tcase_create("Core");
+    tcase_add_test(tc_core, test_linebuf_partial_lines);
+    tcase_add_test(tc_core, test_linebuf_growth);
+    tcase_add_test(tc_core, test_linebuf_eof);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = linebuf_suite();
+    sr = srunner_create(s);
+
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
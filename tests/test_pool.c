@@ -0,0 +1,150 @@
+// Test suite for the worker thread pool using Check framework
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <pthread.h>
+
+#include "../src/pool.h"
+
+#define JOB_COUNT 64
+
+typedef struct {
+    int input;
+    int output;               // Written by the worker
+    int done;                 // Written by the done callback
+    int cancelled;
+    pthread_t done_thread;
+} test_job_t;
+
+static void square_run(void* arg) {
+    test_job_t* job = arg;
+    job->output = job->input * job->input;
+}
+
+static void record_done(void* arg, int cancelled) {
+    test_job_t* job = arg;
+    job->done++;
+    job->cancelled = cancelled;
+    job->done_thread = pthread_self();
+}
+
+// Wait on the completion fd and dispatch until nothing is pending
+static void drain(worker_pool_t* pool) {
+    while (pool_pending(pool) > 0) {
+        struct pollfd pfd = { .fd = pool_get_fd(pool), .events = POLLIN };
+        ck_assert_int_ge(poll(&pfd, 1, 5000), 1);
+        pool_dispatch(pool);
+    }
+}
+
+// Test pool creation and the completion fd
+START_TEST(test_pool_create)
+{
+    worker_pool_t* pool = pool_create(2);
+    ck_assert_ptr_nonnull(pool);
+    ck_assert_int_ge(pool_get_fd(pool), 0);
+    ck_assert_int_eq(pool_pending(pool), 0);
+
+    // Nothing finished yet
+    ck_assert_int_eq(pool_dispatch(pool), 0);
+    pool_destroy(pool);
+
+    // Automatic thread count
+    pool = pool_create(0);
+    ck_assert_ptr_nonnull(pool);
+    pool_destroy(pool);
+
+    // NULL pool is handled gracefully
+    ck_assert_int_eq(pool_get_fd(NULL), -1);
+    ck_assert_int_eq(pool_pending(NULL), 0);
+    ck_assert_int_eq(pool_submit(NULL, square_run, record_done, NULL), -1);
+    pool_destroy(NULL);
+}
+END_TEST
+
+// Test every job runs once and completes on the dispatching thread
+START_TEST(test_pool_jobs_complete)
+{
+    worker_pool_t* pool = pool_create(4);
+    ck_assert_ptr_nonnull(pool);
+
+    test_job_t jobs[JOB_COUNT];
+    memset(jobs, 0, sizeof(jobs));
+    for (int i = 0; i < JOB_COUNT; i++) {
+        jobs[i].input = i;
+        ck_assert_int_eq(pool_submit(pool, square_run, record_done, &jobs[i]), 0);
+    }
+    ck_assert_int_eq(pool_pending(pool), JOB_COUNT);
+
+    drain(pool);
+
+    for (int i = 0; i < JOB_COUNT; i++) {
+        ck_assert_int_eq(jobs[i].output, i * i);
+        ck_assert_int_eq(jobs[i].done, 1);
+        ck_assert_int_eq(jobs[i].cancelled, 0);
+        ck_assert(pthread_equal(jobs[i].done_thread, pthread_self()));
+    }
+    ck_assert_int_eq(pool_pending(pool), 0);
+
+    pool_destroy(pool);
+}
+END_TEST
+
+// Test jobs left over at destroy are handed back as cancelled
+START_TEST(test_pool_destroy_cancels)
+{
+    worker_pool_t* pool = pool_create(1);
+    ck_assert_ptr_nonnull(pool);
+
+    test_job_t jobs[JOB_COUNT];
+    memset(jobs, 0, sizeof(jobs));
+    for (int i = 0; i < JOB_COUNT; i++) {
+        jobs[i].input = i;
+        ck_assert_int_eq(pool_submit(pool, square_run, record_done, &jobs[i]), 0);
+    }
+
+    pool_destroy(pool);
+
+    // None dispatched normally, so every job must come back exactly once, cancelled
+    for (int i = 0; i < JOB_COUNT; i++) {
+        ck_assert_int_eq(jobs[i].done, 1);
+        ck_assert_int_eq(jobs[i].cancelled, 1);
+    }
+}
+END_TEST
+
+// Create the test suite
+Suite *pool_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Pool");
+
+    tc_core = tcase_create("Core");
+    tcase_add_test(tc_core, test_pool_create);
+    tcase_add_test(tc_core, test_pool_jobs_complete);
+    tcase_add_test(tc_core, test_pool_destroy_cancels);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = pool_suite();
+    sr = srunner_create(s);
+
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
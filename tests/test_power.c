@@ -0,0 +1,140 @@
+// Test suite for the power-aware render policy using Check framework
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "../src/power.h"
+
+static char supply_dir[64];
+
+static void setup(void)
+{
+    snprintf(supply_dir, sizeof(supply_dir), "/tmp/hyprlax_power_test_XXXXXX");
+    ck_assert_ptr_nonnull(mkdtemp(supply_dir));
+}
+
+static void teardown(void)
+{
+    char command[512];
+    snprintf(command, sizeof(command), "rm -rf '%s'", supply_dir);
+    ck_assert_int_eq(system(command), 0);
+}
+
+// Write one attribute of a fake power supply
+static void write_attribute(const char* supply, const char* name, const char* value)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", supply_dir, supply);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%s/%s", supply_dir, supply, name);
+    FILE* file = fopen(path, "w");
+    ck_assert_ptr_nonnull(file);
+    fprintf(file, "%s\n", value);
+    fclose(file);
+}
+
+// Test a laptop unplugged, then plugged in
+START_TEST(test_power_battery_state)
+{
+    write_attribute("AC", "type", "Mains");
+    write_attribute("AC", "online", "0");
+    write_attribute("BAT0", "type", "Battery");
+    write_attribute("BAT0", "status", "Discharging");
+    ck_assert_int_eq(power_on_battery(supply_dir), 1);
+
+    write_attribute("AC", "online", "1");
+    write_attribute("BAT0", "status", "Charging");
+    ck_assert_int_eq(power_on_battery(supply_dir), 0);
+
+    // Some firmware keeps reporting Discharging on AC; the online supply wins
+    write_attribute("BAT0", "status", "Discharging");
+    ck_assert_int_eq(power_on_battery(supply_dir), 0);
+
+    // USB-C power delivery counts as external power too
+    write_attribute("AC", "online", "0");
+    write_attribute("ucsi-source-psy-USBC000:001", "type", "USB");
+    write_attribute("ucsi-source-psy-USBC000:001", "online", "1");
+    ck_assert_int_eq(power_on_battery(supply_dir), 0);
+}
+END_TEST
+
+// Test desktops and peripheral batteries never count as running on battery
+START_TEST(test_power_no_system_battery)
+{
+    ck_assert_int_eq(power_on_battery(supply_dir), 0);
+
+    write_attribute("hidpp_battery_0", "type", "Battery");
+    write_attribute("hidpp_battery_0", "scope", "Device");
+    write_attribute("hidpp_battery_0", "status", "Discharging");
+    ck_assert_int_eq(power_on_battery(supply_dir), 0);
+
+    ck_assert_int_eq(power_on_battery("/nonexistent/power_supply"), -1);
+}
+END_TEST
+
+// Test default profiles and parsing of profile settings
+START_TEST(test_power_profiles)
+{
+    power_profile_t profiles[POWER_PROFILE_COUNT];
+    power_profiles_default(profiles);
+    ck_assert_int_eq(profiles[POWER_PROFILE_AC].fps, 0);
+    ck_assert_int_eq(profiles[POWER_PROFILE_AC].pause, 0);
+    ck_assert_int_eq(profiles[POWER_PROFILE_BATTERY].fps, 60);
+    ck_assert_int_eq(profiles[POWER_PROFILE_FULLSCREEN].pause, 0);
+
+    ck_assert_int_eq(power_profile_from_name("battery"), POWER_PROFILE_BATTERY);
+    ck_assert_int_eq(power_profile_from_name("fullscreen"), POWER_PROFILE_FULLSCREEN);
+    ck_assert_int_eq(power_profile_from_name("turbo"), -1);
+    ck_assert_str_eq(power_profile_name(POWER_PROFILE_AC), "ac");
+
+    power_profile_t* battery = &profiles[POWER_PROFILE_BATTERY];
+    ck_assert_int_eq(power_profile_set(battery, "fps", "30"), 0);
+    ck_assert_int_eq(power_profile_set(battery, "duration_scale", "0.5"), 0);
+    ck_assert_int_eq(power_profile_set(battery, "blur_layers", "0"), 0);
+    ck_assert_int_eq(battery->fps, 30);
+    ck_assert_float_eq_tol(battery->duration_scale, 0.5f, 0.0001f);
+    ck_assert_int_eq(battery->blur_layers, 0);
+
+    // Bad input leaves the profile alone
+    ck_assert_int_eq(power_profile_set(battery, "fps", "fast"), -1);
+    ck_assert_int_eq(power_profile_set(battery, "fps", "-5"), -1);
+    ck_assert_int_eq(power_profile_set(battery, "brightness", "1"), -1);
+    ck_assert_int_eq(battery->fps, 30);
+}
+END_TEST
+
+Suite *power_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Power");
+
+    tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, setup, teardown);
+    tcase_add_test(tc_core, test_power_battery_state);
+    tcase_add_test(tc_core, test_power_no_system_battery);
+    tcase_add_test(tc_core, test_power_profiles);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = power_suite();
+    sr = srunner_create(s);
+
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
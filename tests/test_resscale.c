@@ -0,0 +1,144 @@
+// Test suite for the dynamic resolution controller using Check framework
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/resscale.h"
+
+// Feed the same GPU time until the controller has settled on it
+static int feed(resscale_t* rs, double gpu_ms, double budget_ms, int frames)
+{
+    int changes = 0;
+    for (int i = 0; i < frames; i++) {
+        changes += resscale_update(rs, gpu_ms, budget_ms);
+    }
+    return changes;
+}
+
+// Test that frames within budget stay at full resolution
+START_TEST(test_resscale_within_budget)
+{
+    resscale_t rs;
+    resscale_init(&rs, RESSCALE_MIN_DEFAULT);
+    ck_assert_float_eq(rs.scale, 1.0f);
+
+    ck_assert_int_eq(feed(&rs, 3.0, 4.0, 100), 0);
+    ck_assert_float_eq(rs.scale, 1.0f);
+}
+END_TEST
+
+// Test that an over-budget GPU shrinks to the scale whose pixel count fits
+START_TEST(test_resscale_shrinks)
+{
+    resscale_t rs;
+    resscale_init(&rs, RESSCALE_MIN_DEFAULT);
+
+    // Nothing changes before enough frames were measured
+    ck_assert_int_eq(feed(&rs, 8.0, 4.0, RESSCALE_SETTLE_SAMPLES - 1), 0);
+    ck_assert_float_eq(rs.scale, 1.0f);
+
+    // Twice the budget: half the pixels, sqrt(0.5) = 0.707 rounded down to a step
+    ck_assert_int_eq(resscale_update(&rs, 8.0, 4.0), 1);
+    ck_assert_float_eq_tol(rs.scale, 0.70f, 0.001f);
+    ck_assert_int_eq(rs.samples, 0);
+
+    // Far over budget stops at the minimum
+    feed(&rs, 100.0, 4.0, 4 * RESSCALE_SETTLE_SAMPLES);
+    ck_assert_float_eq_tol(rs.scale, RESSCALE_MIN_DEFAULT, 0.001f);
+}
+END_TEST
+
+// Test that the scale grows back a step at a time once the load is gone
+START_TEST(test_resscale_grows)
+{
+    resscale_t rs;
+    resscale_init(&rs, 0.25f);
+    feed(&rs, 64.0, 4.0, RESSCALE_SETTLE_SAMPLES);
+    ck_assert_float_eq_tol(rs.scale, 0.25f, 0.001f);
+
+    // Cheap frames: one step per settle period, up to full resolution
+    ck_assert_int_eq(feed(&rs, 0.5, 4.0, RESSCALE_SETTLE_SAMPLES), 1);
+    ck_assert_float_eq_tol(rs.scale, 0.30f, 0.001f);
+    feed(&rs, 0.5, 4.0, 100 * RESSCALE_SETTLE_SAMPLES);
+    ck_assert_float_eq(rs.scale, 1.0f);
+
+    // In the band between growing and shrinking the scale holds
+    resscale_init(&rs, 0.25f);
+    feed(&rs, 8.0, 4.0, RESSCALE_SETTLE_SAMPLES);
+    float held = rs.scale;
+    ck_assert_int_eq(feed(&rs, 3.0, 4.0, 10 * RESSCALE_SETTLE_SAMPLES), 0);
+    ck_assert_float_eq(rs.scale, held);
+}
+END_TEST
+
+// Test the configured minimum is kept in range
+START_TEST(test_resscale_min_clamped)
+{
+    resscale_t rs;
+    resscale_init(&rs, 0.0f);
+    ck_assert_float_eq_tol(rs.min_scale, RESSCALE_STEP, 0.0001f);
+    resscale_init(&rs, 2.0f);
+    ck_assert_float_eq(rs.min_scale, 1.0f);
+    ck_assert_int_eq(feed(&rs, 100.0, 4.0, 100), 0);
+    ck_assert_float_eq(rs.scale, 1.0f);
+}
+END_TEST
+
+// Test a new minimum takes effect on a scaler already running
+START_TEST(test_resscale_set_min)
+{
+    resscale_t rs;
+    resscale_init(&rs, 0.25f);
+    feed(&rs, 64.0, 4.0, RESSCALE_SETTLE_SAMPLES);
+    ck_assert_float_eq_tol(rs.scale, 0.25f, 0.001f);
+
+    // Raising the minimum lifts the scale with it
+    ck_assert_int_eq(resscale_set_min(&rs, 0.5f), 1);
+    ck_assert_float_eq_tol(rs.scale, 0.5f, 0.001f);
+    ck_assert_int_eq(rs.samples, 0);
+    feed(&rs, 64.0, 4.0, 10 * RESSCALE_SETTLE_SAMPLES);
+    ck_assert_float_eq_tol(rs.scale, 0.5f, 0.001f);
+
+    // Lowering it leaves the scale alone until frames ask for less
+    ck_assert_int_eq(resscale_set_min(&rs, 0.0f), 0);
+    ck_assert_float_eq_tol(rs.min_scale, RESSCALE_STEP, 0.0001f);
+    ck_assert_float_eq_tol(rs.scale, 0.5f, 0.001f);
+    ck_assert_int_eq(feed(&rs, 64.0, 4.0, RESSCALE_SETTLE_SAMPLES), 1);
+    ck_assert(rs.scale < 0.5f);
+}
+END_TEST
+
+Suite *resscale_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Resscale");
+
+    tc_core = tcase_create("Core");
+    tcase_add_test(tc_core, test_resscale_within_budget);
+    tcase_add_test(tc_core, test_resscale_shrinks);
+    tcase_add_test(tc_core, test_resscale_grows);
+    tcase_add_test(tc_core, test_resscale_min_clamped);
+    tcase_add_test(tc_core, test_resscale_set_min);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = resscale_suite();
+    sr = srunner_create(s);
+
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,154 @@
+// Test suite for frame timing statistics using Check framework
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/stats.h"
+
+// Test initialization derives the frame period from the target FPS
+START_TEST(test_stats_init)
+{
+    frame_stats_t stats;
+    stats_init(&stats, 144);
+
+    ck_assert_float_eq_tol(stats.frame_period_ms, 1000.0 / 144.0, 0.0001);
+    ck_assert_int_eq(stats.total_frames, 0);
+    ck_assert_int_eq(stats.missed_frames, 0);
+    for (int i = 0; i < STATS_METRIC_COUNT; i++) {
+        ck_assert_int_eq(stats.rings[i].count, 0);
+    }
+
+    // Invalid FPS falls back to 60 Hz
+    stats_init(&stats, 0);
+    ck_assert_float_eq_tol(stats.frame_period_ms, 1000.0 / 60.0, 0.0001);
+}
+END_TEST
+
+// Test percentiles over a known distribution
+START_TEST(test_stats_percentiles)
+{
+    frame_stats_t stats;
+    stats_init(&stats, 60);
+
+    // 1..100 ms, recorded in reverse so ordering is exercised
+    for (int i = 100; i >= 1; i--) {
+        stats_record(&stats, STATS_DRAW, (double)i);
+    }
+
+    ck_assert_float_eq_tol(stats_percentile(&stats, STATS_DRAW, 50.0f), 50.0f, 0.001f);
+    ck_assert_float_eq_tol(stats_percentile(&stats, STATS_DRAW, 95.0f), 95.0f, 0.001f);
+    ck_assert_float_eq_tol(stats_percentile(&stats, STATS_DRAW, 99.0f), 99.0f, 0.001f);
+    ck_assert_float_eq_tol(stats_max(&stats, STATS_DRAW), 100.0f, 0.001f);
+
+    // Empty metrics report zero
+    ck_assert_float_eq(stats_percentile(&stats, STATS_SWAP, 50.0f), 0.0f);
+}
+END_TEST
+
+// Test the ring buffer keeps only the most recent samples
+START_TEST(test_stats_ring_wraparound)
+{
+    frame_stats_t stats;
+    stats_init(&stats, 60);
+
+    for (int i = 0; i < STATS_RING_SIZE; i++) {
+        stats_record_frame(&stats, 100.0, 100.0, 100.0);
+    }
+    for (int i = 0; i < STATS_RING_SIZE; i++) {
+        stats_record_frame(&stats, 1.0, 2.0, 3.0);
+    }
+
+    ck_assert_int_eq(stats.rings[STATS_UPDATE].count, STATS_RING_SIZE);
+    ck_assert_int_eq(stats.total_frames, 2 * STATS_RING_SIZE);
+    ck_assert_float_eq_tol(stats_max(&stats, STATS_UPDATE), 1.0f, 0.001f);
+    ck_assert_float_eq_tol(stats_max(&stats, STATS_DRAW), 2.0f, 0.001f);
+    ck_assert_float_eq_tol(stats_max(&stats, STATS_SWAP), 3.0f, 0.001f);
+}
+END_TEST
+
+// Test missed frame detection from callback intervals
+START_TEST(test_stats_missed_frames)
+{
+    frame_stats_t stats;
+    stats_init(&stats, 100);  // 10 ms period
+
+    stats_record_interval(&stats, 10.0);   // On time
+    stats_record_interval(&stats, 14.0);   // Jitter, below threshold
+    ck_assert_int_eq(stats.missed_frames, 0);
+
+    stats_record_interval(&stats, 20.0);   // One refresh skipped
+    ck_assert_int_eq(stats.missed_frames, 1);
+
+    stats_record_interval(&stats, 40.0);   // Three refreshes skipped
+    ck_assert_int_eq(stats.missed_frames, 4);
+
+    ck_assert_int_eq(stats.rings[STATS_INTERVAL].count, 4);
+
+    // Reset clears samples but keeps the period
+    stats_reset(&stats);
+    ck_assert_int_eq(stats.missed_frames, 0);
+    ck_assert_int_eq(stats.rings[STATS_INTERVAL].count, 0);
+    ck_assert_float_eq_tol(stats.frame_period_ms, 10.0, 0.0001);
+}
+END_TEST
+
+// Test the text report used by the IPC stats command
+START_TEST(test_stats_format)
+{
+    frame_stats_t stats;
+    stats_init(&stats, 144);
+    stats_record_frame(&stats, 0.5, 1.5, 2.5);
+    stats_record_interval(&stats, 7.0);
+
+    char buffer[1024];
+    int written = stats_format(&stats, buffer, sizeof(buffer));
+    ck_assert_int_gt(written, 0);
+    ck_assert_ptr_nonnull(strstr(buffer, "Frames: 1"));
+    ck_assert_ptr_nonnull(strstr(buffer, "Missed: 0"));
+    ck_assert_ptr_nonnull(strstr(buffer, "update"));
+    ck_assert_ptr_nonnull(strstr(buffer, "draw"));
+    ck_assert_ptr_nonnull(strstr(buffer, "swap"));
+    ck_assert_ptr_nonnull(strstr(buffer, "interval"));
+
+    // Too small a buffer is reported as an error
+    char tiny[16];
+    ck_assert_int_eq(stats_format(&stats, tiny, sizeof(tiny)), -1);
+}
+END_TEST
+
+// Create the test suite
+Suite *stats_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Stats");
+
+    tc_core = tcase_create("Core");
+    tcase_add_test(tc_core, test_stats_init);
+    tcase_add_test(tc_core, test_stats_percentiles);
+    tcase_add_test(tc_core, test_stats_ring_wraparound);
+    tcase_add_test(tc_core, test_stats_missed_frames);
+    tcase_add_test(tc_core, test_stats_format);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = stats_suite();
+    sr = srunner_create(s);
+
+    srunner_set_fork_status(sr, CK_FORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}